@@ -32,6 +32,7 @@
  */
 
 #include <boot.h>
+#include <machdep.h>
 #include <sys/bootinfo.h>
 #include <machine/syspage.h>
 
@@ -41,6 +42,22 @@
  */
 struct bootinfo *const bootinfo = (struct bootinfo *)kvtop(BOOTINFO);
 
+/*
+ * Record the time stamp of the boot stage.
+ * The kernel copies these stamps into its boot log.
+ */
+void
+boot_stamp(const char *name)
+{
+	struct bootinfo *bi = bootinfo;
+	struct bootstamp *bs;
+
+	if (bi->nr_stamps >= NBOOTSTAMPS)
+		return;
+	bs = &bi->stamps[bi->nr_stamps++];
+	strlcpy(bs->name, name, sizeof(bs->name));
+	bs->cycles = cycle_count();
+}
 
 #if defined(DEBUG) && defined(DEBUG_BOOTINFO)
 static void
@@ -33,17 +33,34 @@
 
 #include <boot.h>
 #include <load.h>
+#include <lz4.h>
 #include <sys/ar.h>
 #include <sys/bootinfo.h>
 
 /* forward declarations */
 static int	load_module(struct ar_hdr *, struct module *);
 static void	setup_bootdisk(struct ar_hdr *);
+static char	*member_data(struct ar_hdr *, size_t *);
+#ifdef CONFIG_BOOTCOMP
+static paddr_t	archive_end(struct ar_hdr *);
+static paddr_t	ram_end(paddr_t);
+static paddr_t	unpack_area(size_t);
+#endif
 
 paddr_t	load_base;	/* current load address */
 paddr_t	load_start;	/* start address for loading */
 int	nr_img;		/* number of module images */
 
+#if defined(CONFIG_BOOTCOMP) && defined(CONFIG_ROMBOOT)
+#error "Compressed boot image is not supported for ROM boot"
+#endif
+
+#ifdef CONFIG_BOOTCOMP
+static paddr_t	unpack_min;	/* work area must be above this */
+static paddr_t	unpack_top;	/* end of work area */
+static paddr_t	unpack_base;	/* work area of the last module */
+#endif
+
 
 /*
  * Load OS images - kernel, driver and boot tasks.
@@ -81,6 +98,11 @@ load_os(void)
 	 * Load kernel module.
 	 */
 	hdr = (char *)((paddr_t)magic + 8);
+#ifdef CONFIG_BOOTCOMP
+	unpack_min = archive_end((struct ar_hdr *)hdr);
+	unpack_top = ram_end((paddr_t)magic);
+	unpack_base = unpack_top;
+#endif
 	if (load_module((struct ar_hdr *)hdr, &bi->kernel))
 		panic("Can not load kernel");
 
@@ -150,7 +172,8 @@ load_os(void)
 static int
 load_module(struct ar_hdr *hdr, struct module *m)
 {
-	char *c;
+	char *c, *img;
+	size_t size;
 
 	if (strncmp((char *)&hdr->ar_fmag, ARFMAG, 2)) {
 		DPRINTF(("Invalid image %s\n", hdr->ar_name));
@@ -165,8 +188,17 @@ load_module(struct ar_hdr *hdr, struct module *m)
  	DPRINTF(("loading: hdr=%lx module=%lx name=%s\n",
 		 (paddr_t)hdr, (paddr_t)m, m->name));
 
-	if (load_elf((char *)hdr + sizeof(struct ar_hdr), m))
+	img = member_data(hdr, &size);
+	if (load_elf(img, m))
 		panic("Load error");
+#ifdef CONFIG_BOOTCOMP
+	/*
+	 * The module must not run into the work area, or the
+	 * boot disk kept above it.
+	 */
+	if (load_base > ((paddr_t)img == unpack_base ? unpack_base : unpack_top))
+		panic("No memory to unpack image");
+#endif
 
 	return 0;
 }
@@ -188,13 +220,20 @@ setup_bootdisk(struct ar_hdr *hdr)
 		DPRINTF(("Invalid bootdisk image\n"));
 		return;
 	}
-	size = (size_t)atol((char *)&hdr->ar_size);
+	base = (paddr_t)member_data(hdr, &size);
 	size += size % 2;	/* even alignment */
 	if (size == 0) {
 		DPRINTF(("Size of bootdisk is zero\n"));
 		return;
 	}
-	base = (paddr_t)hdr + sizeof(struct ar_hdr);
+#ifdef CONFIG_BOOTCOMP
+	/*
+	 * The decompressed boot disk must be kept in the work
+	 * area.  So, the following modules are unpacked below it.
+	 */
+	if (base >= unpack_min && base < unpack_top)
+		unpack_top = trunc_page(base);
+#endif
 	bi->bootdisk.base = base;
 	bi->bootdisk.size = size;
 
@@ -211,3 +250,109 @@ setup_bootdisk(struct ar_hdr *hdr)
 	DPRINTF(("bootdisk base=%lx size=%lx\n",
 		 bi->bootdisk.base, bi->bootdisk.size));
 }
+
+#ifdef CONFIG_BOOTCOMP
+/*
+ * Return the end address of the archive.
+ * The area after the archive is used to decompress modules.
+ */
+static paddr_t
+archive_end(struct ar_hdr *hdr)
+{
+	long len;
+
+	while (!strncmp((char *)&hdr->ar_fmag, ARFMAG, 2)) {
+		len = atol((char *)&hdr->ar_size);
+		len += len % 2;	/* even alignment */
+		if (len == 0)
+			break;
+		hdr = (struct ar_hdr *)((paddr_t)hdr +
+					sizeof(struct ar_hdr) + len);
+	}
+	return round_page((paddr_t)hdr);
+}
+
+/*
+ * Return the end address of the RAM which holds the archive.
+ */
+static paddr_t
+ram_end(paddr_t addr)
+{
+	struct bootinfo *bi = bootinfo;
+	int i;
+
+	for (i = 0; i < bi->nr_rams; i++) {
+		if (bi->ram[i].type == MT_USABLE &&
+		    addr >= bi->ram[i].base &&
+		    addr - bi->ram[i].base < bi->ram[i].size)
+			return trunc_page(bi->ram[i].base + bi->ram[i].size);
+	}
+	panic("Boot image is not in RAM");
+	return 0;
+}
+
+/*
+ * Get the work area to decompress a module.
+ *
+ * The area is taken from the top of the RAM, so that it does
+ * not overlap the archive or the modules loaded so far. The
+ * modules are loaded upward from their link address, and
+ * load_module() checks that they stay below the area.
+ */
+static paddr_t
+unpack_area(size_t size)
+{
+	paddr_t min;
+
+	min = unpack_min;
+	if (load_base > min)
+		min = round_page(load_base);
+	if (unpack_top < min || size > unpack_top - min)
+		panic("No memory to unpack image");
+	unpack_base = trunc_page(unpack_top - size);
+	return unpack_base;
+}
+#endif
+
+/*
+ * Get the data of the archive member.
+ *
+ * If the member is compressed, it is decompressed into the
+ * work area at the top of the RAM.  The size of the
+ * (decompressed) data is stored in psize.
+ */
+static char *
+member_data(struct ar_hdr *hdr, size_t *psize)
+{
+	char *data;
+	size_t size;
+#ifdef CONFIG_BOOTCOMP
+	u_char *p;
+	size_t orgsz;
+	paddr_t base;
+#endif
+
+	data = (char *)hdr + sizeof(struct ar_hdr);
+	size = (size_t)atol((char *)&hdr->ar_size);
+
+#ifdef CONFIG_BOOTCOMP
+	if (size > LZ_HDRSZ && !strncmp(data, LZ_MAGIC, LZ_MAGICSZ)) {
+		p = (u_char *)data + LZ_MAGICSZ;
+		orgsz = (size_t)(p[0] | (p[1] << 8) | (p[2] << 16) |
+				 ((u_long)p[3] << 24));
+
+		base = unpack_area(orgsz);
+
+		DPRINTF(("unpack: %lx -> %lx size=%x\n",
+			 (paddr_t)data, base, orgsz));
+
+		if (lz4_decode((u_char *)data + LZ_HDRSZ, size - LZ_HDRSZ,
+			       (u_char *)base, orgsz) != (long)orgsz)
+			panic("Broken compressed image");
+		data = (char *)base;
+		size = orgsz;
+	}
+#endif
+	*psize = size;
+	return data;
+}
@@ -0,0 +1,99 @@
+/*-
+ * Copyright (c) 2009, Kohsuke Ohtani
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the author nor the names of any co-contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * lz4.c - LZ4 decompressor
+ */
+
+#include <boot.h>
+#include <load.h>
+
+/*
+ * Decode LZ4 block data.
+ *
+ * Each sequence consists of a token, literals, and a match
+ * which is copied from the already decoded data.  The last
+ * sequence has only literals.  Returns the size of decoded
+ * data, or -1 if the input data is broken.
+ */
+long
+lz4_decode(const u_char *src, size_t srclen, u_char *dst, size_t dstlen)
+{
+	const u_char *sp = src, *send = src + srclen;
+	u_char *dp = dst, *dend = dst + dstlen;
+	const u_char *ref;
+	size_t len, off;
+	u_int token;
+
+	while (sp < send) {
+		token = *sp++;
+
+		/* Copy literals */
+		len = token >> 4;
+		if (len == 15) {
+			do {
+				if (sp >= send)
+					return -1;
+				len += *sp;
+			} while (*sp++ == 255);
+		}
+		if (len > (size_t)(send - sp) || len > (size_t)(dend - dp))
+			return -1;
+		memcpy(dp, sp, len);
+		dp += len;
+		sp += len;
+		if (sp == send)
+			break;		/* end of block */
+
+		/* Copy match */
+		if (send - sp < 2)
+			return -1;
+		off = (size_t)(sp[0] | (sp[1] << 8));
+		sp += 2;
+		if (off == 0 || off > (size_t)(dp - dst))
+			return -1;
+		len = token & 15;
+		if (len == 15) {
+			do {
+				if (sp >= send)
+					return -1;
+				len += *sp;
+			} while (*sp++ == 255);
+		}
+		len += 4;
+		if (len > (size_t)(dend - dp))
+			return -1;
+
+		/* The match may overlap with the output. */
+		ref = dp - off;
+		while (len-- > 0)
+			*dp++ = *ref++;
+	}
+	return (long)(dp - dst);
+}
@@ -55,6 +55,7 @@ main(void)
 	entry_t entry;
 
 	memset(bootinfo, 0, BOOTINFOSZ);
+	boot_stamp("loader");
 
 	/*
 	 * Initialize debug port.
@@ -66,16 +67,19 @@ main(void)
 	 * Do platform dependent initialization.
 	 */
 	startup();
+	boot_stamp("startup");
 
 	/*
 	 * Show splash screen.
 	 */
 	splash();
+	boot_stamp("splash");
 
 	/*
 	 * Load OS modules to appropriate locations.
 	 */
 	load_os();
+	boot_stamp("load");
 
 	/*
 	 * Dump boot infomation for debug.
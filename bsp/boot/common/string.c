@@ -95,11 +95,21 @@ strncmp(const char *src, const char *tgt, size_t count)
 	return res;
 }
 
+/*
+ * The aligned data is processed by word.
+ */
 void *
 memcpy(void *dest, const void *src, size_t count)
 {
 	char *tmp = (char *)dest, *s = (char *)src;
 
+	if ((((u_long)tmp | (u_long)s) & 3) == 0) {
+		for (; count >= 4; count -= 4) {
+			*(u_long *)tmp = *(u_long *)s;
+			tmp += 4;
+			s += 4;
+		}
+	}
 	while (count--)
 		*tmp++ = *s++;
 	return dest;
@@ -109,7 +119,15 @@ void *
 memset(void *dest, int ch, size_t count)
 {
 	char *p = (char *)dest;
+	u_long w;
 
+	if (((u_long)p & 3) == 0) {
+		w = (u_long)(u_char)ch * 0x01010101;
+		for (; count >= 4; count -= 4) {
+			*(u_long *)p = w;
+			p += 4;
+		}
+	}
 	while (count--)
 		*p++ = (char)ch;
 	return dest;
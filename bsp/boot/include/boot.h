@@ -55,6 +55,7 @@ extern struct bootinfo *const bootinfo;
 __BEGIN_DECLS
 void	 panic(const char *);
 void	 dump_bootinfo(void);
+void	 boot_stamp(const char *);
 void	 splash(void);
 #ifdef DEBUG
 void	 printf(const char *, ...);
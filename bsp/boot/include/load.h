@@ -39,6 +39,7 @@ extern int	nr_img;
 __BEGIN_DECLS
 void	load_os(void);
 int	load_elf(char *, struct module *);
+long	lz4_decode(const u_char *, size_t, u_char *, size_t);
 __END_DECLS
 
 #endif /* !_BOOT_LOAD_H */
@@ -34,6 +34,7 @@ __BEGIN_DECLS
 void	startup(void);
 void	debug_init(void);
 void	debug_putc(int);
+u_long	cycle_count(void);
 __END_DECLS
 
 #endif /* !_BOOT_MACHDEP_H */
@@ -30,6 +30,7 @@
 #include <sys/param.h>
 #include <sys/bootinfo.h>
 #include <boot.h>
+#include <machdep.h>
 
 /*
  * Setup boot information.
@@ -61,3 +62,13 @@ startup(void)
 
 	bootinfo_init();
 }
+
+/*
+ * No cycle counter is available in the loader.
+ */
+u_long
+cycle_count(void)
+{
+
+	return 0;
+}
@@ -0,0 +1,209 @@
+/*-
+ * Copyright (c) 2009, Kohsuke Ohtani
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the author nor the names of any co-contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * lzpack.c - compress a boot module for the boot loader.
+ *
+ * usage: lzpack infile outfile
+ *
+ * This is a host tool to build the boot image.  The output
+ * file has LZ4 block data after the member header defined in
+ * bsp/boot/include/lz4.h.  If the data can not be compressed,
+ * the input file is copied as-is.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lz4.h"
+
+#define MINMATCH	4
+#define LASTLITERALS	5	/* last bytes must be literals */
+#define MFLIMIT		12	/* no match in the last bytes */
+#define MAXOFFSET	65535
+#define HASHLOG		16
+
+static unsigned long	hashtab[1 << HASHLOG];
+
+static unsigned long
+read32(const unsigned char *p)
+{
+
+	return (unsigned long)p[0] | ((unsigned long)p[1] << 8) |
+	    ((unsigned long)p[2] << 16) | ((unsigned long)p[3] << 24);
+}
+
+static unsigned int
+hash(const unsigned char *p)
+{
+
+	return (unsigned int)(((read32(p) * 2654435761UL) & 0xffffffffUL)
+			      >> (32 - HASHLOG));
+}
+
+static unsigned char *
+put_length(unsigned char *op, size_t len)
+{
+
+	while (len >= 255) {
+		*op++ = 255;
+		len -= 255;
+	}
+	*op++ = (unsigned char)len;
+	return op;
+}
+
+static unsigned char *
+put_sequence(unsigned char *op, const unsigned char *lit, size_t litlen,
+	     size_t off, size_t mlen)
+{
+	unsigned char *token = op++;
+
+	*token = (unsigned char)((litlen >= 15 ? 15 : litlen) << 4);
+	if (litlen >= 15)
+		op = put_length(op, litlen - 15);
+	memcpy(op, lit, litlen);
+	op += litlen;
+	if (mlen == 0)
+		return op;	/* last literals */
+
+	*op++ = (unsigned char)(off & 0xff);
+	*op++ = (unsigned char)(off >> 8);
+	mlen -= MINMATCH;
+	*token |= (unsigned char)(mlen >= 15 ? 15 : mlen);
+	if (mlen >= 15)
+		op = put_length(op, mlen - 15);
+	return op;
+}
+
+/*
+ * Compress data with the greedy LZ4 parser.
+ * Returns the size of compressed data.
+ */
+static size_t
+compress(const unsigned char *src, size_t len, unsigned char *dst)
+{
+	const unsigned char *ip = src, *anchor = src, *ref;
+	const unsigned char *end = src + len;
+	unsigned char *op = dst;
+	size_t mlen;
+	unsigned int h;
+
+	memset(hashtab, 0, sizeof(hashtab));
+
+	if (len > MFLIMIT) {
+		while (ip < end - MFLIMIT) {
+			h = hash(ip);
+			ref = hashtab[h] ? src + hashtab[h] - 1 : NULL;
+			hashtab[h] = (unsigned long)(ip - src) + 1;
+
+			if (ref == NULL || ip - ref > MAXOFFSET ||
+			    read32(ref) != read32(ip)) {
+				ip++;
+				continue;
+			}
+			mlen = MINMATCH;
+			while (ip + mlen < end - LASTLITERALS &&
+			       ref[mlen] == ip[mlen])
+				mlen++;
+
+			op = put_sequence(op, anchor, (size_t)(ip - anchor),
+					  (size_t)(ip - ref), mlen);
+			ip += mlen;
+			anchor = ip;
+		}
+	}
+	op = put_sequence(op, anchor, (size_t)(end - anchor), 0, 0);
+	return (size_t)(op - dst);
+}
+
+int
+main(int argc, char *argv[])
+{
+	FILE *fp;
+	unsigned char *src, *dst, hdr[LZ_HDRSZ];
+	size_t len, clen;
+	long size;
+
+	if (argc != 3) {
+		fprintf(stderr, "usage: lzpack infile outfile\n");
+		exit(1);
+	}
+	if ((fp = fopen(argv[1], "rb")) == NULL) {
+		perror(argv[1]);
+		exit(1);
+	}
+	fseek(fp, 0, SEEK_END);
+	size = ftell(fp);
+	rewind(fp);
+	if (size < 0) {
+		perror(argv[1]);
+		exit(1);
+	}
+	len = (size_t)size;
+
+	src = malloc(len + 1);
+	dst = malloc(len + len / 255 + 16);
+	if (src == NULL || dst == NULL) {
+		fprintf(stderr, "lzpack: out of memory\n");
+		exit(1);
+	}
+	if (fread(src, 1, len, fp) != len) {
+		perror(argv[1]);
+		exit(1);
+	}
+	fclose(fp);
+
+	clen = compress(src, len, dst);
+
+	if ((fp = fopen(argv[2], "wb")) == NULL) {
+		perror(argv[2]);
+		exit(1);
+	}
+	if (clen + LZ_HDRSZ < len) {
+		memcpy(hdr, LZ_MAGIC, LZ_MAGICSZ);
+		hdr[4] = (unsigned char)(len & 0xff);
+		hdr[5] = (unsigned char)((len >> 8) & 0xff);
+		hdr[6] = (unsigned char)((len >> 16) & 0xff);
+		hdr[7] = (unsigned char)((len >> 24) & 0xff);
+		fwrite(hdr, 1, LZ_HDRSZ, fp);
+		fwrite(dst, 1, clen, fp);
+	} else {
+		/* Not compressible */
+		fwrite(src, 1, len, fp);
+	}
+	if (fclose(fp) != 0) {
+		perror(argv[2]);
+		exit(1);
+	}
+	free(src);
+	free(dst);
+	return 0;
+}
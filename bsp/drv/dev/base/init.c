@@ -92,6 +92,7 @@ driver_init(void)
 			DPRINTF(("Initializing %s\n", dp->name));
 			if (dp->init(dp) == 0)
 				dp->flags |= DS_ACTIVE;
+			bootlog_mark(dp->name);
 		}
 	}
 }
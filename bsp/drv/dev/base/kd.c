@@ -483,34 +483,46 @@ kd_examine(int argc, char **argv)
 			return KERR_INVAL;
 	}
 
-	if ((kp = kmem_map((void *)addr, (size_t)len)) == NULL)
-		return KERR_BADADDR;
+	switch (fmt) {
+	case 'c':
+	case 'b':
+		size = 1;
+		break;
+	case 'h':
+		size = 2;
+		break;
+	default:
+		size = 4;
+		break;
+	}
 
 	for (cnt = 0; cnt < len;) {
+		/*
+		 * The memory may not be physically contiguous, so
+		 * each item is mapped separately.
+		 */
+		if ((kp = kmem_map((void *)addr, (size_t)size)) == NULL)
+			return KERR_BADADDR;
+
 		if ((cnt % 16) == 0)
 			printf("\n%08lx: ", (long)addr);
 
 		switch (fmt) {
 		case 'c':
 			printf("%c", *kp);
-			size = 1;
 			break;
 		case 'b':
 			printf("%02x ", *kp);
-			size = 1;
 			break;
 		case 'h':
 			printf("%04x ", *(u_short *)kp);
-			size = 2;
 			break;
 		case 'w':
 		default:
 			printf("%08lx ", *(u_long *)kp);
-			size = 4;
 			break;
 		}
 		addr += size;
-		kp += size;
 		cnt += size;
 	}
 	return 0;
@@ -60,6 +60,7 @@ driver_main(dkifn_t *dkient)
 	calibrate_delay();
 
 	driver_probe();
+	bootlog_mark("probe");
 	driver_init();
 
 	DPRINTF(("Driver initialized\n"));
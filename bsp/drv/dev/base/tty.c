@@ -60,6 +60,11 @@
 
 static void tty_output(int c, struct tty *tp);
 
+/*
+ * No output processing is done in raw mode or if OPOST is off.
+ */
+#define tty_rawout(tp)	(!((tp)->t_lflag & ICANON) || !((tp)->t_oflag & OPOST))
+
 /* default control characters */
 static const cc_t	ttydefchars[NCCS] = TTYDEFCHARS;
 
@@ -68,11 +73,14 @@ static const cc_t	ttydefchars[NCCS] = TTYDEFCHARS;
 /*
  * TTY queue operations
  */
-#define ttyq_next(i)	(((i) + 1) & (TTYQ_SIZE - 1))
-#define ttyq_prev(i)	(((i) - 1) & (TTYQ_SIZE - 1))
-#define ttyq_full(q)	((q)->tq_count >= TTYQ_SIZE)
+#define ttyq_next(q, i)	(((i) + 1) & ((q)->tq_size - 1))
+#define ttyq_prev(q, i)	(((i) - 1) & ((q)->tq_size - 1))
+#define ttyq_full(q)	((q)->tq_count >= (q)->tq_size)
 #define ttyq_empty(q)	((q)->tq_count == 0)
 
+/* Size of the bounce buffer for block copy */
+#define TTY_BLKSIZE	128
+
 /*
  * Get a character from a queue.
  */
@@ -88,7 +96,7 @@ tty_getc(struct tty_queue *tq)
 		return -1;
 	}
 	c = tq->tq_buf[tq->tq_head];
-	tq->tq_head = ttyq_next(tq->tq_head);
+	tq->tq_head = ttyq_next(tq, tq->tq_head);
 	tq->tq_count--;
 	splx(s);
 	return (int)c;
@@ -108,7 +116,7 @@ tty_putc(int c, struct tty_queue *tq)
 		return;
 	}
 	tq->tq_buf[tq->tq_tail] = (char)(c & 0xff);
-	tq->tq_tail = ttyq_next(tq->tq_tail);
+	tq->tq_tail = ttyq_next(tq, tq->tq_tail);
 	tq->tq_count++;
 	splx(s);
 }
@@ -125,13 +133,55 @@ tty_unputc(struct tty_queue *tq)
 	if (ttyq_empty(tq))
 		return -1;
 	s = splhigh();
-	tq->tq_tail = ttyq_prev(tq->tq_tail);
+	tq->tq_tail = ttyq_prev(tq, tq->tq_tail);
 	c = tq->tq_buf[tq->tq_tail];
 	tq->tq_count--;
 	splx(s);
 	return (int)c;
 }
 
+/*
+ * Get up to n characters from a queue.
+ * Returns the number of characters copied.
+ */
+static int
+tty_getbuf(char *buf, int n, struct tty_queue *tq)
+{
+	int i, s;
+
+	s = splhigh();
+	if (n > tq->tq_count)
+		n = tq->tq_count;
+	for (i = 0; i < n; i++) {
+		buf[i] = tq->tq_buf[tq->tq_head];
+		tq->tq_head = ttyq_next(tq, tq->tq_head);
+	}
+	tq->tq_count -= n;
+	splx(s);
+	return n;
+}
+
+/*
+ * Put up to n characters into a queue.
+ * Returns the number of characters copied.
+ */
+static int
+tty_putbuf(const char *buf, int n, struct tty_queue *tq)
+{
+	int i, s;
+
+	s = splhigh();
+	if (n > tq->tq_size - tq->tq_count)
+		n = tq->tq_size - tq->tq_count;
+	for (i = 0; i < n; i++) {
+		tq->tq_buf[tq->tq_tail] = buf[i];
+		tq->tq_tail = ttyq_next(tq, tq->tq_tail);
+	}
+	tq->tq_count += n;
+	splx(s);
+	return n;
+}
+
 /*
  * Put the chars in the from queue on the end of the to queue.
  */
@@ -394,6 +444,44 @@ tty_input(int c, struct tty *tp)
 	tty_start(tp);
 }
 
+/*
+ * Process input of a block of characters received on a tty.
+ * If no input processing is required, the characters are
+ * copied into the raw queue at once.  Otherwise, they are
+ * passed to tty_input() one by one.
+ * This may be called with interrupt level.
+ */
+void
+tty_input_buf(const char *buf, int n, struct tty *tp)
+{
+	struct tty_queue *tq = &tp->t_rawq;
+	int i;
+
+	if (n <= 0)
+		return;
+
+	if ((tp->t_lflag & (ICANON | ISIG | ECHO | ECHONL)) ||
+	    (tp->t_iflag & (IGNCR | ICRNL | INLCR | IXON)) ||
+	    (tp->t_state & TS_TTSTOP) || n > tq->tq_size - tq->tq_count)
+		goto slow;
+#if defined(DEBUG) && defined(CONFIG_KD)
+	for (i = 0; i < n; i++) {
+		if (buf[i] == tp->t_cc[VDDB])
+			goto slow;
+	}
+#endif
+
+	pm_notify(PME_USER_ACTIVITY);
+
+	tty_putbuf(buf, n, tq);
+	sched_wakeup(&tp->t_input);
+	tty_start(tp);
+	return;
+ slow:
+	for (i = 0; i < n; i++)
+		tty_input(buf[i], tp);
+}
+
 /*
  * Output a single character on a tty, doing output processing
  * as needed (expanding tabs, newline processing, etc.).
@@ -403,7 +491,7 @@ tty_output(int c, struct tty *tp)
 {
 	int i, col;
 
-	if ((tp->t_lflag & ICANON) == 0) {
+	if (tty_rawout(tp)) {
 		tty_putc(c, &tp->t_outq);
 		return;
 	}
@@ -454,10 +542,11 @@ tty_read(struct tty *tp, char *buf, size_t *nbyte)
 {
 	unsigned char *cc;
 	struct tty_queue *qp;
-	int rc, tmp;
+	int rc, tmp, n;
 	u_char c;
 	size_t count = 0;
 	tcflag_t lflag;
+	char cbuf[TTY_BLKSIZE];
 
 	DPRINTF(("tty_read\n"));
 
@@ -473,6 +562,22 @@ tty_read(struct tty *tp, char *buf, size_t *nbyte)
 			return EINTR;
 		}
 	}
+	if (!(lflag & ICANON)) {
+		/*
+		 * Raw mode: copy the queued data in blocks.
+		 */
+		while (count < *nbyte) {
+			n = (int)MIN(*nbyte - count, sizeof(cbuf));
+			if ((n = tty_getbuf(cbuf, n, qp)) == 0)
+				break;
+			if (copyout(cbuf, buf, (size_t)n))
+				return EFAULT;
+			buf += n;
+			count += n;
+		}
+		*nbyte = count;
+		return 0;
+	}
 	while (count < *nbyte) {
 		if ((tmp = tty_getc(qp)) == -1)
 			break;
@@ -496,21 +601,39 @@ tty_read(struct tty *tp, char *buf, size_t *nbyte)
 int
 tty_write(struct tty *tp, char *buf, size_t *nbyte)
 {
+	struct tty_queue *qp = &tp->t_outq;
 	size_t remain, count = 0;
 	u_char c;
+	char cbuf[TTY_BLKSIZE];
+	int n;
 
 	DPRINTF(("tty_write\n"));
 
 	remain = *nbyte;
 	while (remain > 0) {
-		if (tp->t_outq.tq_count > TTYQ_HIWAT) {
+		if (qp->tq_count > TTYQ_HIWAT(qp)) {
 			tty_start(tp);
-			if (tp->t_outq.tq_count <= TTYQ_HIWAT)
+			if (qp->tq_count <= TTYQ_HIWAT(qp))
 				continue;
 			tp->t_state |= TS_ASLEEP;
 			sched_sleep(&tp->t_output);
 			continue;
 		}
+		if (tty_rawout(tp)) {
+			/*
+			 * No output processing: copy the data in blocks.
+			 */
+			n = (int)MIN(remain, sizeof(cbuf));
+			if (n > qp->tq_size - qp->tq_count)
+				n = qp->tq_size - qp->tq_count;
+			if (copyin(buf, cbuf, (size_t)n))
+				return EFAULT;
+			n = tty_putbuf(cbuf, n, qp);
+			buf += n;
+			remain -= n;
+			count += n;
+			continue;
+		}
 		if (copyin(buf, &c, 1))
 			return EFAULT;
 		tty_output((int)c, tp);
@@ -523,13 +646,105 @@ tty_write(struct tty *tp, char *buf, size_t *nbyte)
 	return 0;
 }
 
+static char *
+ttyq_alloc(int size)
+{
+	paddr_t pa;
+
+	if (size < PAGE_SIZE)
+		return kmem_alloc((size_t)size);
+	if ((pa = page_alloc((psize_t)size)) == 0)
+		return NULL;
+	return ptokv(pa);
+}
+
+static void
+ttyq_free(char *buf, int size)
+{
+
+	if (size < PAGE_SIZE)
+		kmem_free(buf);
+	else
+		page_free(kvtop(buf), (psize_t)size);
+}
+
+/*
+ * Change the buffer size of all queues.
+ * The size is rounded up to a power of 2.  The queued data
+ * is moved to the new buffers.
+ */
+static int
+tty_setqsize(struct tty *tp, int size)
+{
+	struct tty_queue *q[3];
+	char *newbuf[3], *oldbuf[3];
+	int i, j, n, oldsize, qsize, s;
+
+	if (size < TTYQ_SIZE || size > TTYQ_MAXSIZE)
+		return EINVAL;
+	for (qsize = TTYQ_SIZE; qsize < size; qsize <<= 1)
+		;
+	oldsize = tp->t_rawq.tq_size;
+	if (qsize == oldsize)
+		return 0;
+
+	q[0] = &tp->t_rawq;
+	q[1] = &tp->t_canq;
+	q[2] = &tp->t_outq;
+
+	for (i = 0; i < 3; i++) {
+		newbuf[i] = q[i]->tq_defbuf;
+		if (qsize == TTYQ_SIZE)
+			continue;
+		if ((newbuf[i] = ttyq_alloc(qsize)) == NULL) {
+			while (--i >= 0)
+				ttyq_free(newbuf[i], qsize);
+			return ENOMEM;
+		}
+	}
+
+	tty_wait(tp);
+
+	s = splhigh();
+	for (i = 0; i < 3; i++) {
+		if (q[i]->tq_count > qsize)
+			break;
+	}
+	if (i < 3) {
+		splx(s);
+		if (qsize != TTYQ_SIZE) {
+			for (i = 0; i < 3; i++)
+				ttyq_free(newbuf[i], qsize);
+		}
+		return EBUSY;
+	}
+	for (i = 0; i < 3; i++) {
+		n = q[i]->tq_count;
+		for (j = 0; j < n; j++)
+			newbuf[i][j] = q[i]->tq_buf[(q[i]->tq_head + j) &
+						    (oldsize - 1)];
+		oldbuf[i] = q[i]->tq_buf;
+		q[i]->tq_buf = newbuf[i];
+		q[i]->tq_size = qsize;
+		q[i]->tq_head = 0;
+		q[i]->tq_tail = n & (qsize - 1);
+	}
+	splx(s);
+
+	if (oldsize != TTYQ_SIZE) {
+		for (i = 0; i < 3; i++)
+			ttyq_free(oldbuf[i], oldsize);
+	}
+	return 0;
+}
+
 /*
  * Ioctls for all tty devices.
  */
 int
 tty_ioctl(struct tty *tp, u_long cmd, void *data)
 {
-	int flags;
+	int flags, size;
 	struct tty_queue *qp;
 
 	switch (cmd) {
@@ -600,6 +815,14 @@ tty_ioctl(struct tty *tp, u_long cmd, void *data)
 		if (copyout(&tp->t_outq.tq_count, data, sizeof(int)))
 			return EFAULT;
 		break;
+	case TIOCSQSIZE:
+		if (copyin(data, &size, sizeof(int)))
+			return EFAULT;
+		return tty_setqsize(tp, size);
+	case TIOCGQSIZE:
+		if (copyout(&tp->t_rawq.tq_size, data, sizeof(int)))
+			return EFAULT;
+		break;
 	}
 	return 0;
 }
@@ -616,6 +839,13 @@ tty_attach(struct tty *tp)
 	memset(tp, 0, sizeof(struct tty));
 	memcpy(&tp->t_termios.c_cc, ttydefchars, sizeof(ttydefchars));
 
+	tp->t_rawq.tq_buf = tp->t_rawq.tq_defbuf;
+	tp->t_rawq.tq_size = TTYQ_SIZE;
+	tp->t_canq.tq_buf = tp->t_canq.tq_defbuf;
+	tp->t_canq.tq_size = TTYQ_SIZE;
+	tp->t_outq.tq_buf = tp->t_outq.tq_defbuf;
+	tp->t_outq.tq_size = TTYQ_SIZE;
+
 	event_init(&tp->t_input, "TTY input");
 	event_init(&tp->t_output, "TTY output");
 
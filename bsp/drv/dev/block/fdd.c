@@ -558,7 +558,6 @@ static int
 fdd_read(device_t dev, char *buf, size_t *nbyte, int blkno)
 {
 	struct fdd_softc *sc = device_private(dev);
-	char *kbuf;
 	int track, sect, error;
 	u_int i, nr_sect;
 
@@ -568,10 +567,6 @@ fdd_read(device_t dev, char *buf, size_t *nbyte, int blkno)
 	if (blkno > FDG_HEADS * FDG_TRACKS * FDG_SECTORS)
 		return EIO;
 
-	/* Translate buffer address to kernel address */
-	if ((kbuf = kmem_map(buf, *nbyte)) == NULL)
-		return EFAULT;
-
 	nr_sect = *nbyte / SECTOR_SIZE;
 	error = 0;
 	for (i = 0; i < nr_sect; i++) {
@@ -592,10 +587,13 @@ fdd_read(device_t dev, char *buf, size_t *nbyte, int blkno)
 			}
 			sc->track = track;
 		}
-		memcpy(kbuf, (char *)sc->rbuf + sect * SECTOR_SIZE,
-		       SECTOR_SIZE);
+		if (copyout((char *)sc->rbuf + sect * SECTOR_SIZE, buf,
+			    SECTOR_SIZE) != 0) {
+			error = EFAULT;
+			break;
+		}
 		blkno++;
-		kbuf += SECTOR_SIZE;
+		buf += SECTOR_SIZE;
 	}
 	*nbyte = i * SECTOR_SIZE;
 	return error;
@@ -614,7 +612,7 @@ static int
 fdd_write(device_t dev, char *buf, size_t *nbyte, int blkno)
 {
 	struct fdd_softc *sc = device_private(dev);
-	char *kbuf, *wbuf;
+	char *wbuf;
 	int track, sect, error;
 	u_int i, nr_sect;
 
@@ -624,10 +622,6 @@ fdd_write(device_t dev, char *buf, size_t *nbyte, int blkno)
 	if (blkno > FDG_HEADS * FDG_TRACKS * FDG_SECTORS)
 		return EIO;
 
-	/* Translate buffer address to kernel address */
-	if ((kbuf = kmem_map(buf, *nbyte)) == NULL)
-		return EFAULT;
-
 	nr_sect = *nbyte / SECTOR_SIZE;
 	error = 0;
 	for (i = 0; i < nr_sect; i++) {
@@ -644,14 +638,16 @@ fdd_write(device_t dev, char *buf, size_t *nbyte, int blkno)
 		else
 			wbuf = sc->wbuf;
 
-		memcpy(wbuf, kbuf, SECTOR_SIZE);
-		error = fdd_rw(sc, IO_WRITE, wbuf, 1, blkno);
+		if (copyin(buf, wbuf, SECTOR_SIZE) != 0)
+			error = EFAULT;
+		else
+			error = fdd_rw(sc, IO_WRITE, wbuf, 1, blkno);
 		if (error != 0) {
 			sc->track = INVALID_TRACK;
 			break;
 		}
 		blkno++;
-		kbuf += SECTOR_SIZE;
+		buf += SECTOR_SIZE;
 	}
 	*nbyte = i * SECTOR_SIZE;
 
@@ -79,7 +79,6 @@ ramdisk_read(device_t dev, char *buf, size_t *nbyte, int blkno)
 {
 	struct ramdisk_softc *sc = device_private(dev);
 	int offset = blkno * BSIZE;
-	void *kbuf;
 	size_t nr_read;
 
 	DPRINTF(("ramdisk_read: buf=%x nbyte=%d blkno=%x\n",
@@ -94,13 +93,9 @@ ramdisk_read(device_t dev, char *buf, size_t *nbyte, int blkno)
 	if (offset + nr_read > (int)sc->size)
 		nr_read = sc->size - offset;
 
-	/* Translate buffer address to kernel address */
-	if ((kbuf = kmem_map(buf, nr_read)) == NULL) {
-		return EFAULT;
-	}
-
 	/* Copy data */
-	memcpy(kbuf, sc->addr + offset, nr_read);
+	if (copyout(sc->addr + offset, buf, nr_read) != 0)
+		return EFAULT;
 	*nbyte = nr_read;
 	return 0;
 }
@@ -110,7 +105,6 @@ ramdisk_write(device_t dev, char *buf, size_t *nbyte, int blkno)
 {
 	struct ramdisk_softc *sc = device_private(dev);
 	int offset = blkno * BSIZE;
-	void *kbuf;
 	size_t nr_write;
 
 	DPRINTF(("ramdisk_write: buf=%x nbyte=%d blkno=%x\n",
@@ -123,12 +117,9 @@ ramdisk_write(device_t dev, char *buf, size_t *nbyte, int blkno)
 	if (offset + nr_write > (int)sc->size)
 		nr_write = sc->size - offset;
 
-	/* Translate buffer address to kernel address */
-	if ((kbuf = kmem_map(buf, nr_write)) == NULL)
-		return EFAULT;
-
 	/* Copy data */
-	memcpy(sc->addr + offset, kbuf, nr_write);
+	if (copyin(buf, sc->addr + offset, nr_write) != 0)
+		return EFAULT;
 	*nbyte = nr_write;
 	return 0;
 }
@@ -63,12 +63,21 @@ static int
 zero_read(device_t dev, char *buf, size_t *nbyte, int blkno)
 {
 	void *p;
+	size_t len, n;
 
-	/* Translate buffer address to kernel address. */
-	if ((p = kmem_map(buf, *nbyte)) == NULL)
-		return EFAULT;
-
-	memset(p, 0, *nbyte);
+	/*
+	 * Translate buffer address to kernel address.
+	 * The buffer may not be contiguous, so it is
+	 * cleared page by page.
+	 */
+	for (len = *nbyte; len > 0; len -= n, buf += n) {
+		n = PAGE_SIZE - ((vaddr_t)buf & PAGE_MASK);
+		if (n > len)
+			n = len;
+		if ((p = kmem_map(buf, n)) == NULL)
+			return EFAULT;
+		memset(p, 0, n);
+	}
 	return 0;
 }
 
@@ -46,6 +46,14 @@
 #define COM_BASE	CONFIG_NS16550_BASE
 #define COM_IRQ		CONFIG_NS16550_IRQ
 
+/*
+ * Receive FIFO trigger level: 1, 4, 8 or 14 bytes.
+ * 0 disables the FIFO.
+ */
+#ifndef CONFIG_NS16550_RXTRIG
+#define CONFIG_NS16550_RXTRIG	8
+#endif
+
 /* Register offsets */
 #define COM_RBR		(COM_BASE + 0x00)	/* receive buffer register */
 #define COM_THR		(COM_BASE + 0x00)	/* transmit holding register */
@@ -71,7 +79,34 @@
 #define	IIR_TXB		0x02	/* transmitter holding register empty */
 #define	IIR_RXB		0x04	/* received data available */
 #define	IIR_LSR		0x06	/* line status change */
-#define	IIR_MASK	0x07	/* mask off just the meaningful bits */
+#define	IIR_RXTOUT	0x0c	/* receive timeout (FIFO mode) */
+#define	IIR_MASK	0x0f	/* mask off just the meaningful bits */
+#define	IIR_FIFO_MASK	0xc0	/* set if FIFOs are enabled */
+
+/* FIFO control register */
+#define	FCR_ENABLE	0x01	/* enable FIFO */
+#define	FCR_RCV_RST	0x02	/* reset receive FIFO */
+#define	FCR_XMT_RST	0x04	/* reset transmit FIFO */
+#define	FCR_TRIGGER_1	0x00	/* receive trigger level: 1 byte */
+#define	FCR_TRIGGER_4	0x40	/* receive trigger level: 4 bytes */
+#define	FCR_TRIGGER_8	0x80	/* receive trigger level: 8 bytes */
+#define	FCR_TRIGGER_14	0xc0	/* receive trigger level: 14 bytes */
+
+#define FIFO_SIZE	16	/* 16550A FIFO depth */
+
+#if CONFIG_NS16550_RXTRIG == 0
+#define FCR_TRIGGER	0
+#elif CONFIG_NS16550_RXTRIG == 1
+#define FCR_TRIGGER	FCR_TRIGGER_1
+#elif CONFIG_NS16550_RXTRIG == 4
+#define FCR_TRIGGER	FCR_TRIGGER_4
+#elif CONFIG_NS16550_RXTRIG == 8
+#define FCR_TRIGGER	FCR_TRIGGER_8
+#elif CONFIG_NS16550_RXTRIG == 14
+#define FCR_TRIGGER	FCR_TRIGGER_14
+#else
+#error "NS16550_RXTRIG must be 0, 1, 4, 8 or 14"
+#endif
 
 /* line status register */
 #define	LSR_RCV_FIFO	0x80
@@ -93,6 +128,7 @@ static char	ns16550_rcv_char(struct serial_port *);
 static void	ns16550_set_poll(struct serial_port *, int);
 static void	ns16550_start(struct serial_port *);
 static void	ns16550_stop(struct serial_port *);
+static void	ns16550_xmt_start(struct serial_port *);
 
 
 struct driver ns16550_driver = {
@@ -111,10 +147,12 @@ static struct serial_ops ns16550_ops = {
 	/* set_poll */	ns16550_set_poll,
 	/* start */	ns16550_start,
 	/* stop */	ns16550_stop,
+	/* xmt_start */	ns16550_xmt_start,
 };
 
 
 static struct serial_port ns16550_port;
+static int ns16550_fifosz;	/* bytes per transmitter empty interrupt */
 
 
 static void
@@ -148,24 +186,70 @@ ns16550_set_poll(struct serial_port *sp, int on)
 	}
 }
 
+/*
+ * Fill the transmitter with the queued data.
+ * The transmitter must be empty.
+ */
+static void
+ns16550_xmt_fill(struct serial_port *sp)
+{
+	int c, n;
+
+	for (n = 0; n < ns16550_fifosz; n++) {
+		if ((c = serial_xmt_getc(sp)) < 0)
+			break;
+		bus_write_8(COM_THR, c);
+	}
+	serial_xmt_done(sp);
+}
+
+static void
+ns16550_xmt_start(struct serial_port *sp)
+{
+	int s;
+
+	/*
+	 * If the transmitter is busy, the data will be sent
+	 * by the next transmitter empty interrupt.
+	 */
+	s = splhigh();
+	if (bus_read_8(COM_LSR) & LSR_TXRDY)
+		ns16550_xmt_fill(sp);
+	splx(s);
+}
+
 static int
 ns16550_isr(void *arg)
 {
 	struct serial_port *sp = arg;
-
-	switch (bus_read_8(COM_IIR) & IIR_MASK) {
-	case IIR_MSR:		/* Modem status change */
-		break;
-	case IIR_LSR:		/* Line status change */
-		bus_read_8(COM_LSR);
-		break;
-	case IIR_TXB:		/* Transmitter holding register empty */
-		serial_xmt_done(sp);
-		break;
-	case IIR_RXB:		/* Received data available */
-		bus_read_8(COM_LSR);
-		serial_rcv_char(sp, bus_read_8(COM_RBR));
-		break;
+	char buf[FIFO_SIZE];
+	u_char iir;
+	int n;
+
+	while (!((iir = bus_read_8(COM_IIR)) & IIR_IP)) {
+		switch (iir & IIR_MASK) {
+		case IIR_MSR:		/* Modem status change */
+			bus_read_8(COM_MSR);
+			break;
+		case IIR_LSR:		/* Line status change */
+			bus_read_8(COM_LSR);
+			break;
+		case IIR_TXB:		/* Transmitter holding register empty */
+			ns16550_xmt_fill(sp);
+			break;
+		case IIR_RXB:		/* Received data available */
+		case IIR_RXTOUT:	/* Receive timeout */
+			/*
+			 * Drain the receive FIFO and pass the data
+			 * to the tty at once.
+			 */
+			n = 0;
+			while (n < FIFO_SIZE &&
+			       (bus_read_8(COM_LSR) & LSR_RXRDY))
+				buf[n++] = bus_read_8(COM_RBR);
+			serial_rcv_buf(sp, buf, n);
+			break;
+		}
 	}
 	return 0;
 }
@@ -180,7 +264,20 @@ ns16550_start(struct serial_port *sp)
 	bus_write_8(COM_DLL, 0x01);	/* 115200 baud */
 	bus_write_8(COM_DLM, 0x00);
 	bus_write_8(COM_LCR, 0x03);	/* N, 8, 1 */
-	bus_write_8(COM_FCR, 0x06);	/* Disable & clear FIFO */
+
+	/*
+	 * Enable the FIFO if the UART has a working one (16550A).
+	 */
+	ns16550_fifosz = 1;
+	if (CONFIG_NS16550_RXTRIG != 0) {
+		bus_write_8(COM_FCR, FCR_ENABLE|FCR_RCV_RST|FCR_XMT_RST|
+			    FCR_TRIGGER);
+		if ((bus_read_8(COM_IIR) & IIR_FIFO_MASK) == IIR_FIFO_MASK)
+			ns16550_fifosz = FIFO_SIZE;
+	}
+	if (ns16550_fifosz == 1)
+		bus_write_8(COM_FCR, FCR_RCV_RST|FCR_XMT_RST);
+	DPRINTF(("ns16550: fifo=%d\n", ns16550_fifosz));
 
 	sp->irq = irq_attach(COM_IRQ, IPL_COMM, 0, ns16550_isr,
 			     IST_NONE, sp);
@@ -125,18 +125,46 @@ serial_start(struct tty *tp)
 	struct serial_port *port = sc->port;
 	int c;
 
+	if (sc->ops->xmt_start != NULL) {
+		/*
+		 * Interrupt driven output.  The driver pulls the
+		 * data with serial_xmt_getc() until the queue is
+		 * drained, and tty_done() clears TS_BUSY.
+		 */
+		tp->t_state |= TS_BUSY;
+		sc->ops->xmt_start(port);
+		return;
+	}
 	while ((c = tty_getc(&tp->t_outq)) >= 0)
 		sc->ops->xmt_char(port, c);
 }
 
+/*
+ * Get a character to transmit.
+ * Returns -1 if no data is queued or output is stopped.
+ */
+int
+serial_xmt_getc(struct serial_port *port)
+{
+	struct tty *tp = port->tty;
+
+	if (tp->t_state & TS_TTSTOP)
+		return -1;
+	return tty_getc(&tp->t_outq);
+}
+
 /*
  * Output completed.
  */
 void
 serial_xmt_done(struct serial_port *port)
 {
+	struct tty *tp = port->tty;
 
-	tty_done(port->tty);
+	/* Let tty_start() restart the stopped output later. */
+	if (tp->t_state & TS_TTSTOP)
+		tp->t_state &= ~TS_BUSY;
+	tty_done(tp);
 }
 
 /*
@@ -149,6 +177,16 @@ serial_rcv_char(struct serial_port *port, char c)
 	tty_input(c, port->tty);
 }
 
+/*
+ * Block input.
+ */
+void
+serial_rcv_buf(struct serial_port *port, const char *buf, int n)
+{
+
+	tty_input_buf(buf, n, port->tty);
+}
+
 static int
 serial_cngetc(device_t dev)
 {
@@ -150,6 +150,7 @@ int	 sysinfo(int, void *);
 void	 panic(const char *);
 void	 printf(const char *, ...);
 void	 dbgctl(int, void *);
+void	 bootlog_mark(const char *);
 __END_DECLS
 
 #endif /* !_DKI_H */
@@ -41,14 +41,21 @@
 #include <sys/termios.h>
 #include <sys/syslimits.h>
 
-#define TTYQ_SIZE	MAX_INPUT
-#define TTYQ_HIWAT	(TTYQ_SIZE - 10)
+#define TTYQ_SIZE	MAX_INPUT	/* default queue size */
+#define TTYQ_MAXSIZE	16384		/* max queue size */
+#define TTYQ_HIWAT(q)	((q)->tq_size - 10)
 
+/*
+ * TTY queue is a ring buffer whose size is a power of 2.
+ * The buffer can be resized by TIOCSQSIZE.
+ */
 struct tty_queue {
-	char	tq_buf[TTYQ_SIZE];
+	char	*tq_buf;		/* ring buffer */
+	int	tq_size;		/* size of buffer */
 	int	tq_head;
 	int	tq_tail;
 	int	tq_count;
+	char	tq_defbuf[TTYQ_SIZE];	/* default buffer */
 };
 
 /*
@@ -92,6 +99,7 @@ int	 tty_read(struct tty *, char *, size_t *);
 int	 tty_write(struct tty *, char *, size_t *);
 int	 tty_ioctl(struct tty *, u_long, void *);
 void	 tty_input(int, struct tty *);
+void	 tty_input_buf(const char *, int, struct tty *);
 int	 tty_getc(struct tty_queue *);
 void	 tty_done(struct tty *);
 void	 tty_attach(struct tty *);
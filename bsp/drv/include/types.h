@@ -36,6 +36,7 @@
 
 typedef unsigned long	task_t;
 typedef unsigned long	thread_t;
+typedef unsigned long	object_t;
 typedef unsigned long	device_t;
 typedef unsigned long	irq_t;
 typedef unsigned long	dma_t;
@@ -189,3 +189,12 @@ context_dump(context_t ctx)
 	trap_dump(ctx->uregs);
 #endif
 }
+
+/*
+ * Release the resources of the context.
+ * This is called when the thread is deallocated.
+ */
+void
+context_cleanup(context_t ctx)
+{
+}
@@ -72,6 +72,8 @@ volatile int irq_level;
 static int ipl_table[NIRQS];		/* Vector -> level */
 static uint16_t mask_table[NIPLS];	/* Level -> mask */
 
+static struct cpu_regs *intr_regs;	/* frame of current interrupt */
+
 /*
  * Set mask for current ipl
  */
@@ -160,11 +162,14 @@ interrupt_dispatch(int vector)
  * Common interrupt handler.
  */
 void
-interrupt_handler(void)
+interrupt_handler(struct cpu_regs *regs)
 {
+	struct cpu_regs *old_regs;
 	uint16_t bits;
 	int vector;
 
+	old_regs = intr_regs;
+	intr_regs = regs;
 	bits = ICU_IF;
 retry:
 	for (vector = 0; vector < NIRQS; vector++) {
@@ -184,9 +189,21 @@ retry:
 	if (bits & IRQ_VALID)
 		goto retry;
 out:
+	intr_regs = old_regs;
 	return;
 }
 
+/*
+ * Return the pc interrupted by the current interrupt.
+ * This is used by the profiler in the clock interrupt.
+ */
+vaddr_t
+interrupt_pc(void)
+{
+
+	return (intr_regs != NULL) ? (vaddr_t)intr_regs->pc : 0;
+}
+
 /*
  * Initialize interrupt controllers.
  * All interrupts will be masked off.
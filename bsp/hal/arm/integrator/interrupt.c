@@ -65,6 +65,8 @@ volatile int irq_level;
 static int ipl_table[NIRQS];		/* vector -> level */
 static uint32_t mask_table[NIPLS];	/* level -> mask */
 
+static struct cpu_regs *intr_regs;	/* frame of current interrupt */
+
 /*
  * Set mask for current ipl
  */
@@ -131,8 +133,9 @@ interrupt_setup(int vector, int mode)
  * Common interrupt handler.
  */
 void
-interrupt_handler(void)
+interrupt_handler(struct cpu_regs *regs)
 {
+	struct cpu_regs *old_regs;
 	uint32_t bits;
 	int vector, old_ipl, new_ipl;
 
@@ -153,12 +156,15 @@ interrupt_handler(void)
 	update_mask();
 
 	/* Allow another interrupt that has higher priority */
+	old_regs = intr_regs;
+	intr_regs = regs;
 	splon();
 
 	/* Dispatch interrupt */
 	irq_handler(vector);
 
 	sploff();
+	intr_regs = old_regs;
 
 	/* Restore interrupt level */
 	irq_level = old_ipl;
@@ -167,6 +173,17 @@ out:
 	return;
 }
 
+/*
+ * Return the pc interrupted by the current interrupt.
+ * This is used by the profiler in the clock interrupt.
+ */
+vaddr_t
+interrupt_pc(void)
+{
+
+	return (intr_regs != NULL) ? (vaddr_t)intr_regs->pc : 0;
+}
+
 /*
  * Initialize interrupt controllers.
  * All interrupts will be masked off.
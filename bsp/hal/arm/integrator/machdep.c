@@ -147,6 +147,17 @@ machine_bootinfo(struct bootinfo **bip)
 	*bip = (struct bootinfo *)BOOTINFO;
 }
 
+/*
+ * Get the cpu cycle counter.
+ * No cycle counter is available on this platform.
+ */
+u_long
+machine_cycles(void)
+{
+
+	return 0;
+}
+
 void
 machine_abort(void)
 {
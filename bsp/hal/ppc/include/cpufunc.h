@@ -36,6 +36,7 @@
 __BEGIN_DECLS
 uint32_t get_decr(void);
 void	 set_decr(uint32_t);
+uint32_t get_tbl(void);
 void	 cpu_idle(void);
 __END_DECLS
 
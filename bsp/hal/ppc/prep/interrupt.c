@@ -67,6 +67,8 @@ static volatile int irq_level;
 static int	ipl_table[NIRQS];	/* Vector -> level */
 static u_int	mask_table[NIPLS];	/* Level -> mask */
 
+static struct cpu_regs *intr_regs;	/* frame of current interrupt */
+
 /*
  * Set mask for current ipl
  */
@@ -174,12 +176,17 @@ interrupt_lookup(void)
 void
 interrupt_handler(struct cpu_regs *regs)
 {
+	struct cpu_regs *old_regs;
 	int vector;
 	int old_ipl, new_ipl;
 
+	old_regs = intr_regs;
+	intr_regs = regs;
+
 	/* Handle decrementer interrupt */
 	if (regs->trap_no == TRAP_DECREMENTER) {
 		clock_isr(NULL);
+		intr_regs = old_regs;
 		return;
 	}
 
@@ -197,12 +204,24 @@ interrupt_handler(struct cpu_regs *regs)
 	splon();
 	irq_handler(vector);
 	sploff();
+	intr_regs = old_regs;
 
 	/* Restore interrupt level */
 	irq_level = old_ipl;
 	update_mask();
 }
 
+/*
+ * Return the pc interrupted by the current interrupt.
+ * This is used by the profiler in the clock interrupt.
+ */
+vaddr_t
+interrupt_pc(void)
+{
+
+	return (intr_regs != NULL) ? (vaddr_t)intr_regs->srr0 : 0;
+}
+
 /*
  * Initialize 8259 interrupt controllers.
  * All interrupts will be masked off in ICU.
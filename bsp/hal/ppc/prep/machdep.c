@@ -131,6 +131,17 @@ machine_bootinfo(struct bootinfo **bip)
 	*bip = (struct bootinfo *)BOOTINFO;
 }
 
+/*
+ * Get the cpu cycle counter.
+ * We use the lower word of the time base register.
+ */
+u_long
+machine_cycles(void)
+{
+
+	return (u_long)get_tbl();
+}
+
 void
 machine_abort(void)
 {
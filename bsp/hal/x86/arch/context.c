@@ -51,6 +51,7 @@
 #include <trap.h>
 #include <context.h>
 #include <locore.h>
+#include <fpu.h>
 
 /*
  * Set user mode registers into the specific context.
@@ -139,11 +140,16 @@ context_set(context_t ctx, int type, register_t val)
  *
  * It is assumed all interrupts are disabled by caller.
  *
- * TODO: FPU context is not switched as of now.
+ * The FPU registers are switched lazily by the trap of the first
+ * FPU instruction. See fpu.c.
  */
 void
 context_switch(context_t prev, context_t next)
 {
+
+#ifdef CONFIG_FPU
+	fpu_switch(next);
+#endif
 	/* Set kernel stack pointer in TSS (esp0). */
 	tss_set((uint32_t)next->esp0);
 
@@ -177,6 +183,9 @@ context_save(context_t ctx)
 
 	ctx->saved_regs = sav;
 
+	/* The handler is not traced even if the thread is. */
+	cur->eflags &= ~EFL_TF;
+
 	/* Adjust stack pointer */
 	cur->esp = (uint32_t)sav - (sizeof(uint32_t) * 2);
 }
@@ -207,3 +216,16 @@ context_dump(context_t ctx)
 	trap_dump(ctx->uregs);
 #endif
 }
+
+/*
+ * Release the resources of the context.
+ * This is called when the thread is deallocated.
+ */
+void
+context_cleanup(context_t ctx)
+{
+
+#ifdef CONFIG_FPU
+	fpu_cleanup(ctx);
+#endif
+}
@@ -36,6 +36,7 @@
 #include <cpu.h>
 #include <locore.h>
 #include <cpufunc.h>
+#include <fpu.h>
 
 typedef void (*trapfn_t)(void);
 
@@ -46,6 +47,19 @@ static struct seg_desc gdt[NGDTS];
 static struct gate_desc idt[NIDTS];
 static struct tss tss;
 
+/*
+ * Stack for sysenter.  Its top word is a copy of esp0, which
+ * sysenter_entry loads as the kernel stack.  The space below
+ * it takes the debug trap which fires at sysenter_entry if the
+ * user enters with TF set.
+ */
+#define SYSENTER_STKSZ	512
+
+static struct {
+	uint32_t	stack[SYSENTER_STKSZ / sizeof(uint32_t)];
+	uint32_t	esp0;
+} sysenter_stack;
+
 /*
  * Interrupt table
  */
@@ -75,6 +89,7 @@ tss_set(uint32_t kstack)
 {
 
 	tss.esp0 = kstack;
+	sysenter_stack.esp0 = kstack;
 }
 
 /*
@@ -201,12 +216,37 @@ tss_init(void)
 	memset(&tss, 0, sizeof(struct tss));
 	tss.ss0 = KERNEL_DS;
 	tss.esp0 = (uint32_t)BOOTSTKTOP;
+	sysenter_stack.esp0 = tss.esp0;
 	tss.cs = (uint32_t)USER_CS | 3;
 	tss.ds = tss.es = tss.ss = tss.fs = tss.gs = (uint32_t)USER_CS | 3;
 	tss.io_bitmap_offset = INVALID_IO_BITMAP;
 	load_tr(KERNEL_TSS);
 }
 
+/*
+ * Setup the fast system call entry.
+ * The "int" gate is still used if the cpu has no sysenter.
+ * The user stub in libc must do the same check.
+ */
+static void
+sysenter_init(void)
+{
+	uint32_t sig;
+
+	if (!(cpu_features() & CPUID_SEP))
+		return;
+
+	/* Pentium Pro reports SEP, but it has no sysenter. */
+	sig = cpu_signature();
+	if ((sig & 0xf00) == 0x600 && (sig & 0xf0) < 0x30 &&
+	    (sig & 0xf) < 3)
+		return;
+
+	wrmsr(MSR_SYSENTER_CS, KERNEL_CS);
+	wrmsr(MSR_SYSENTER_ESP, (uint32_t)&sysenter_stack.esp0);
+	wrmsr(MSR_SYSENTER_EIP, (uint32_t)sysenter_entry);
+}
+
 /*
  * Initialize CPU state.
  * Setup segment and interrupt descriptor.
@@ -222,4 +262,9 @@ cpu_init(void)
 	gdt_init();
 	idt_init();
 	tss_init();
+	sysenter_init();
+
+#ifdef CONFIG_FPU
+	fpu_init();
+#endif
 }
@@ -0,0 +1,162 @@
+/*-
+ * Copyright (c) 2009, Kohsuke Ohtani
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the author nor the names of any co-contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+/*
+ * fpu.c - lazy FPU context switching
+ */
+
+/*
+ * The FPU registers are not switched at the context switch.
+ * Instead, CR0.TS is set when the next thread does not own the
+ * FPU registers, and the first FPU instruction of that thread
+ * raises the "device not available" trap. The trap handler saves
+ * the registers of the old owner, and loads the registers of the
+ * current thread.
+ *
+ * The threads which never use FPU do not pay for it, and their
+ * save area is not allocated.
+ */
+
+#include <kernel.h>
+#include <kmem.h>
+#include <cpu.h>
+#include <cpufunc.h>
+#include <context.h>
+#include <fpu.h>
+
+#define MXCSR_DEFAULT	0x1f80		/* all SIMD exceptions masked */
+
+static context_t fpu_owner;		/* context owning FPU registers */
+static int	 fpu_ts;		/* true if CR0.TS is set */
+static int	 has_fxsr;		/* true if fxsave is supported */
+
+/*
+ * Select the FPU owner for the next context.
+ * CR0.TS is written only when its state changes.
+ */
+void
+fpu_switch(context_t next)
+{
+
+	if (next == fpu_owner) {
+		if (fpu_ts) {
+			clts();
+			fpu_ts = 0;
+		}
+	} else {
+		if (!fpu_ts) {
+			set_ts();
+			fpu_ts = 1;
+		}
+	}
+}
+
+/*
+ * Handle "device not available" trap.
+ * Returns 0 on success, or ENOMEM if no save area is available.
+ */
+int
+fpu_trap(context_t ctx)
+{
+	void *area;
+	int s, first = 0;
+
+	if (ctx->fregs == NULL) {
+		/*
+		 * Allocate the save area at first use.
+		 */
+		area = kmem_alloc((has_fxsr ? FXSAVE_SIZE :
+				   sizeof(struct fpu_regs)) + 16);
+		if (area == NULL)
+			return ENOMEM;
+		ctx->fpu_area = area;
+		ctx->fregs = (struct fpu_regs *)
+			(((vaddr_t)area + 15) & ~(vaddr_t)15);
+		first = 1;
+	}
+
+	s = splhigh();
+	clts();
+	fpu_ts = 0;
+	if (fpu_owner != ctx) {
+		if (fpu_owner != NULL) {
+			if (has_fxsr)
+				fxsave(fpu_owner->fregs);
+			else
+				fnsave(fpu_owner->fregs);
+		}
+		if (first) {
+			fninit();
+			if (has_fxsr)
+				ldmxcsr(MXCSR_DEFAULT);
+		} else {
+			if (has_fxsr)
+				fxrstor(ctx->fregs);
+			else
+				frstor(ctx->fregs);
+		}
+		fpu_owner = ctx;
+	}
+	splx(s);
+	return 0;
+}
+
+/*
+ * Release the FPU state of the context.
+ */
+void
+fpu_cleanup(context_t ctx)
+{
+
+	if (fpu_owner == ctx)
+		fpu_owner = NULL;
+	if (ctx->fpu_area != NULL) {
+		kmem_free(ctx->fpu_area);
+		ctx->fpu_area = NULL;
+		ctx->fregs = NULL;
+	}
+}
+
+/*
+ * Initialize FPU.
+ */
+void
+fpu_init(void)
+{
+
+	set_cr0((get_cr0() & ~CR0_EM) | CR0_MP | CR0_NE);
+	if (cpu_features() & CPUID_FXSR) {
+		set_cr4(get_cr4() | CR4_OSFXSR | CR4_OSXMMEXCPT);
+		has_fxsr = 1;
+	}
+	fninit();
+	set_ts();
+	fpu_ts = 1;
+}
@@ -50,10 +50,24 @@
  */
 static pgd_t boot_pgd = (pgd_t)BOOT_PGD;
 
+/*
+ * TLB control.
+ * The kernel pages are marked global if the cpu supports it,
+ * so they survive the TLB flush at the context switch.
+ */
+#define LARGE_PAGE	0x400000	/* size of 4M page */
+#define TLB_FLUSH_MAX	32		/* max pages for invlpg */
+
+static int	has_invlpg;		/* true if invlpg is usable */
+static uint32_t	pte_global;		/* PTE_GLOBAL or 0 */
+
+static void	tlb_flush(vaddr_t, size_t, int);
+
 /*
  * Map physical memory range into virtual address
  *
- * Returns 0 on success, or ENOMEM on failure.
+ * Returns 0 on success, ENOMEM if no page table can be allocated,
+ * or EINVAL if the range overlaps a 4M page.
  *
  * Map type can be one of the following type.
  *   PG_UNMAP  - Remove mapping
@@ -75,8 +89,8 @@ static pgd_t boot_pgd = (pgd_t)BOOT_PGD;
  * page entry in it. All page tables are released when mmu_delmap()
  * is called when task is terminated.
  *
- * TODO: TLB should be flushed for specific page by invalpg in
- * case of i486.
+ * The TLB is not flushed if the page directory is not in use,
+ * because its entries are flushed by the next mmu_switch().
  */
 int
 mmu_map(pgd_t pgd, paddr_t pa, vaddr_t va, size_t size, int type)
@@ -85,10 +99,15 @@ mmu_map(pgd_t pgd, paddr_t pa, vaddr_t va, size_t size, int type)
 	uint32_t pde_flag = 0;
 	pte_t pte;
 	paddr_t pg;
+	vaddr_t start;
+	size_t npages;
+	int i;
 
 	pa = round_page(pa);
 	va = round_page(va);
 	size = trunc_page(size);
+	start = va;
+	npages = size / PAGE_SIZE;
 
 	/*
 	 * Set page flag
@@ -108,15 +127,28 @@ mmu_map(pgd_t pgd, paddr_t pa, vaddr_t va, size_t size, int type)
 		break;
 	case PG_SYSTEM:
 		pde_flag = (uint32_t)(PDE_PRESENT | PDE_WRITE);
-		pte_flag = (uint32_t)(PTE_PRESENT | PTE_WRITE);
+		pte_flag = (uint32_t)(PTE_PRESENT | PTE_WRITE) | pte_global;
 		break;
 	case PG_IOMEM:
 		pde_flag = (uint32_t)(PDE_PRESENT | PDE_WRITE);
-		pte_flag = (uint32_t)(PTE_PRESENT | PTE_WRITE | PTE_NCACHE);
+		pte_flag = (uint32_t)(PTE_PRESENT | PTE_WRITE | PTE_NCACHE)
+			| pte_global;
 		break;
 	default:
 		panic("mmu_map");
 	}
+	/*
+	 * The 4M pages map the kernel RAM for good, and they
+	 * have no page table to put the new entries in.
+	 */
+	for (i = PAGE_DIR(va); size > 0 && i <= PAGE_DIR(va + size - 1); i++) {
+		if ((pgd[i] & (PDE_PRESENT | PDE_SIZE)) ==
+		    (PDE_PRESENT | PDE_SIZE)) {
+			DPRINTF(("Error: MMU mapping on 4M page\n"));
+			return EINVAL;
+		}
+	}
+
 	/*
 	 * Map all pages
 	 */
@@ -142,10 +174,37 @@ mmu_map(pgd_t pgd, paddr_t pa, vaddr_t va, size_t size, int type)
 		va += PAGE_SIZE;
 		size -= PAGE_SIZE;
 	}
-	flush_tlb();
+	if (type == PG_SYSTEM || type == PG_IOMEM)
+		tlb_flush(start, npages, 1);
+	else if (kvtop(pgd) == get_cr3())
+		tlb_flush(start, npages, 0);
 	return 0;
 }
 
+/*
+ * Flush TLB entries for the specified pages.
+ * A large range is flushed at once. The global entries
+ * are flushed only if "global" is true.
+ */
+static void
+tlb_flush(vaddr_t va, size_t npages, int global)
+{
+	uint32_t cr4;
+
+	if (has_invlpg && npages <= TLB_FLUSH_MAX) {
+		while (npages-- > 0) {
+			flush_tlb_page(va);
+			va += PAGE_SIZE;
+		}
+	} else if (global && pte_global) {
+		/* Toggle PGE to flush global entries */
+		cr4 = get_cr4();
+		set_cr4(cr4 & ~CR4_PGE);
+		set_cr4(cr4);
+	} else
+		flush_tlb();
+}
+
 /*
  * Create new page map.
  *
@@ -230,12 +289,16 @@ mmu_extract(pgd_t pgd, vaddr_t va, size_t size)
 	for (pg = start; pg <= end; pg += PAGE_SIZE) {
 		if (!pte_present(pgd, pg))
 			return 0;
+		if (pde_large(pgd, pg))
+			continue;
 		pte = vtopte(pgd, pg);
 		if (!page_present(pte, pg))
 			return 0;
 	}
 
 	/* Get physical address */
+	if (pde_large(pgd, start))
+		return (paddr_t)largetopg(pgd, va);
 	pte = vtopte(pgd, start);
 	pa = (paddr_t)ptetopg(pte, start);
 	return pa + (paddr_t)(va - start);
@@ -251,16 +314,33 @@ mmu_extract(pgd_t pgd, vaddr_t va, size_t size)
  * these kernel pages.
  * page_init() must be called before calling this routine.
  *
- * Note: This routine requires 4K bytes to map 4M bytes memory. So,
- * if the system has a lot of RAM, the "used memory" by kernel will
- * become large, too. For example, page table requires 512K bytes
- * for 512M bytes system RAM.
+ * If the cpu supports 4M pages, the RAM is mapped by them as far
+ * as its address is aligned. Otherwise, this routine requires 4K
+ * bytes to map 4M bytes memory. For example, page table requires
+ * 512K bytes for 512M bytes system RAM.
  */
 void
 mmu_init(struct mmumap *mmumap_table)
 {
 	struct mmumap *map;
 	int map_type = 0;
+	uint32_t features;
+	paddr_t pa;
+	vaddr_t va;
+	size_t size;
+
+	/*
+	 * Enable global pages and 4M pages.
+	 */
+	features = cpu_features();
+	if (features != 0)
+		has_invlpg = 1;
+	if (features & CPUID_PGE) {
+		set_cr4(get_cr4() | CR4_PGE);
+		pte_global = PTE_GLOBAL;
+	}
+	if (features & CPUID_PSE)
+		set_cr4(get_cr4() | CR4_PSE);
 
 	for (map = mmumap_table; map->type != 0; map++) {
 		switch (map->type) {
@@ -274,8 +354,23 @@ mmu_init(struct mmumap *mmumap_table)
 			break;
 		}
 
-		if (mmu_map(boot_pgd, map->phys, map->virt,
-			    (size_t)map->size, map_type))
+		pa = map->phys;
+		va = map->virt;
+		size = (size_t)map->size;
+
+		if (map_type == PG_SYSTEM && (features & CPUID_PSE)) {
+			while (size >= LARGE_PAGE &&
+			       ((pa | va) & (LARGE_PAGE - 1)) == 0) {
+				boot_pgd[PAGE_DIR(va)] = (uint32_t)pa |
+				    PDE_PRESENT | PDE_WRITE | PDE_SIZE |
+				    (pte_global ? PDE_GLOBAL : 0);
+				pa += LARGE_PAGE;
+				va += LARGE_PAGE;
+				size -= LARGE_PAGE;
+			}
+		}
+		if (size > 0 && mmu_map(boot_pgd, pa, va, size, map_type))
 			panic("mmu_init");
 	}
+	tlb_flush(0, (size_t)-1, 1);
 }
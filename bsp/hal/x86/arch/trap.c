@@ -41,6 +41,7 @@
 #include <cpufunc.h>
 #include <context.h>
 #include <locore.h>
+#include <fpu.h>
 
 #ifdef DEBUG
 /*
@@ -97,6 +98,12 @@ static const int exception_map[] = {
 	SIGILL,		/* 18: Cache flush denied */
 };
 
+/*
+ * TF taken from the user by the debug trap at sysenter_entry.
+ * sysenter_entry gives it back to the user eflags.
+ */
+uint32_t sysenter_tf;
+
 /*
  * Trap handler
  * Invoke the exception handler if it is needed.
@@ -111,6 +118,27 @@ trap_handler(struct cpu_regs *regs)
 	else if (trap_no == 2)
 		panic("NMI");
 
+	/*
+	 * sysenter does not clear TF. If the user enters with TF
+	 * set, the debug trap fires at the first instruction of
+	 * sysenter_entry. Clear TF and let the entry continue.
+	 * The trap is delivered to the user after the system call.
+	 */
+	if (trap_no == 1 && regs->cs == KERNEL_CS &&
+	    regs->eip == (uint32_t)sysenter_entry) {
+		regs->eflags &= ~EFL_TF;
+		sysenter_tf = EFL_TF;
+		return;
+	}
+
+#ifdef CONFIG_FPU
+	/*
+	 * Load the FPU registers of the current thread.
+	 */
+	if (trap_no == 7 && fpu_trap(&curthread->ctx) == 0)
+		return;
+#endif
+
 	/*
 	 * Check whether this trap is kernel page fault caused
 	 * by known routine to access user space like copyin().
@@ -74,7 +74,9 @@ struct kern_regs {
 };
 
 /*
- * FPU register for fsave/frstor
+ * FPU register for fsave/frstor.
+ * The area for fxsave/fxrstor is FXSAVE_SIZE bytes instead,
+ * and it must be aligned to 16 bytes.
  */
 struct fpu_regs {
 	uint32_t	ctrl_word;
@@ -87,6 +89,8 @@ struct fpu_regs {
 	uint32_t	st[20];
 };
 
+#define FXSAVE_SIZE	512
+
 /*
  * Processor context
  */
@@ -96,6 +100,7 @@ struct context {
 	struct cpu_regs	*saved_regs;	/* saved user mode registers */
 #ifdef CONFIG_FPU
 	struct fpu_regs	*fregs;		/* co-processor registers */
+	void		*fpu_area;	/* allocated area for fregs */
 #endif
 	uint32_t	 esp0;		/* top of kernel stack */
 };
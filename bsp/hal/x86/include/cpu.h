@@ -85,6 +85,31 @@
 #define CR0_MP		0x00000002	/* monitor coprocessor */
 #define CR0_PE		0x00000001	/* enable protected mode */
 
+/*
+ * CR4 register
+ */
+#define CR4_PSE		0x00000010	/* page size extension */
+#define CR4_PGE		0x00000080	/* page global enable */
+#define CR4_OSFXSR	0x00000200	/* fxsave/fxrstor support */
+#define CR4_OSXMMEXCPT	0x00000400	/* SIMD exception support */
+
+/*
+ * Model specific registers
+ */
+#define MSR_SYSENTER_CS		0x174
+#define MSR_SYSENTER_ESP	0x175
+#define MSR_SYSENTER_EIP	0x176
+
+/*
+ * Feature flags from cpuid
+ */
+#define CPUID_PSE	0x00000008	/* page size extension */
+#define CPUID_TSC	0x00000010	/* time stamp counter */
+#define CPUID_SEP	0x00000800	/* sysenter/sysexit */
+#define CPUID_PGE	0x00002000	/* page global enable */
+#define CPUID_FXSR	0x01000000	/* fxsave/fxrstor */
+#define CPUID_SSE	0x02000000	/* SSE extensions */
+
 #ifndef __ASSEMBLY__
 
 #include <sys/types.h>
@@ -36,17 +36,34 @@
 __BEGIN_DECLS
 void	 cpu_idle(void);
 void	 flush_tlb(void);
+void	 flush_tlb_page(vaddr_t);
 void	 flush_cache(void);
 void	 load_tr(uint32_t);
 void	 load_gdt(void *);
 void	 load_idt(void *);
+void	 set_cr0(uint32_t);
+uint32_t get_cr0(void);
 uint32_t get_cr2(void);
 void	 set_cr3(uint32_t);
 uint32_t get_cr3(void);
+void	 set_cr4(uint32_t);
+uint32_t get_cr4(void);
 void	 outb(int, u_char);
 u_char	 inb(int);
 void	 outb_p(int, u_char);
 u_char	 inb_p(int);
+uint32_t cpu_features(void);
+uint32_t cpu_signature(void);
+void	 wrmsr(uint32_t, uint32_t);
+uint32_t get_tsc(void);
+void	 clts(void);
+void	 set_ts(void);
+void	 fninit(void);
+void	 fnsave(void *);
+void	 frstor(void *);
+void	 fxsave(void *);
+void	 fxrstor(void *);
+void	 ldmxcsr(uint32_t);
 __END_DECLS
 
 #endif /* !_X86_CPUFUNC_H */
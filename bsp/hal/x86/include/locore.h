@@ -72,6 +72,7 @@ void	trap_17(void);
 void	trap_18(void);
 void	syscall_entry(void);
 void	syscall_ret(void);
+void	sysenter_entry(void);
 void	cpu_switch(struct kern_regs *, struct kern_regs *);
 void	known_fault1(void);
 void	known_fault2(void);
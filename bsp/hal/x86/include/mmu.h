@@ -45,8 +45,10 @@ typedef uint32_t	*pte_t;		/* page table entry */
 #define PDE_NCACHE	0x00000010
 #define PDE_ACCESS	0x00000020
 #define PDE_SIZE	0x00000080
+#define PDE_GLOBAL	0x00000100
 #define PDE_AVAIL	0x00000e00
 #define PDE_ADDRESS	0xfffff000
+#define PDE_LARGE_ADDRESS 0xffc00000	/* address of 4M page */
 
 /*
  * Page table entry
@@ -58,6 +60,7 @@ typedef uint32_t	*pte_t;		/* page table entry */
 #define PTE_NCACHE	0x00000010
 #define PTE_ACCESS	0x00000020
 #define PTE_DIRTY	0x00000040
+#define PTE_GLOBAL	0x00000100
 #define PTE_AVAIL	0x00000e00
 #define PTE_ADDRESS	0xfffff000
 
@@ -69,10 +72,18 @@ typedef uint32_t	*pte_t;		/* page table entry */
 
 #define pte_present(pgd, virt)  (pgd[PAGE_DIR(virt)] & PDE_PRESENT)
 
+#define pde_large(pgd, virt)    (pgd[PAGE_DIR(virt)] & PDE_SIZE)
+
 #define page_present(pte, virt) (pte[PAGE_TABLE(virt)] & PTE_PRESENT)
 
+/* Returns NULL if the address is mapped by a 4M page. */
 #define vtopte(pgd, virt) \
-            (pte_t)ptokv(((uint32_t *)pgd)[PAGE_DIR(virt)] & PDE_ADDRESS)
+            (pde_large(pgd, virt) ? (pte_t)NULL : \
+             (pte_t)ptokv(((uint32_t *)pgd)[PAGE_DIR(virt)] & PDE_ADDRESS))
+
+#define largetopg(pgd, virt) \
+            ((pgd[PAGE_DIR(virt)] & PDE_LARGE_ADDRESS) + \
+             ((vaddr_t)(virt) & ~PDE_LARGE_ADDRESS))
 
 #define ptetopg(pte, virt) \
             ((pte)[PAGE_TABLE(virt)] & PTE_ADDRESS)
@@ -32,6 +32,8 @@
 
 #include <sys/cdefs.h>
 
+extern uint32_t sysenter_tf;
+
 __BEGIN_DECLS
 void	 trap_handler(struct cpu_regs *);
 void	 trap_dump(struct cpu_regs *);
@@ -65,6 +65,8 @@ static volatile int irq_level;
 static int	ipl_table[NIRQS];	/* Vector -> level */
 static u_int	mask_table[NIPLS];	/* Level -> mask */
 
+static struct cpu_regs *intr_regs;	/* frame of current interrupt */
+
 /*
  * Set mask for current ipl
  */
@@ -155,6 +157,7 @@ interrupt_setup(int vector, int mode)
 void
 interrupt_handler(struct cpu_regs *regs)
 {
+	struct cpu_regs *old_regs;
 	int vector = (int)regs->trap_no;
 	int old_ipl, new_ipl;
 
@@ -171,15 +174,29 @@ interrupt_handler(struct cpu_regs *regs)
 	outb(PIC_M, 0x20);		/* Non specific EOI to master */
 
 	/* Dispatch interrupt */
+	old_regs = intr_regs;
+	intr_regs = regs;
 	splon();
 	irq_handler(vector);
 	sploff();
+	intr_regs = old_regs;
 
 	/* Restore interrupt level */
 	irq_level = old_ipl;
 	update_mask();
 }
 
+/*
+ * Return the pc interrupted by the current interrupt.
+ * This is used by the profiler in the clock interrupt.
+ */
+vaddr_t
+interrupt_pc(void)
+{
+
+	return (intr_regs != NULL) ? (vaddr_t)intr_regs->eip : 0;
+}
+
 /*
  * Initialize 8259 interrupt controllers.
  * All interrupts will be masked off in ICU.
@@ -128,6 +128,22 @@ machine_bootinfo(struct bootinfo **bip)
 	*bip = (struct bootinfo *)BOOTINFO;
 }
 
+/*
+ * Get the cpu cycle counter.
+ * Returns 0 if the cpu does not have TSC.
+ */
+u_long
+machine_cycles(void)
+{
+	static int has_tsc = -1;
+
+	if (has_tsc < 0)
+		has_tsc = (cpu_features() & CPUID_TSC) ? 1 : 0;
+	if (!has_tsc)
+		return 0;
+	return (u_long)get_tsc();
+}
+
 void
 machine_abort(void)
 {
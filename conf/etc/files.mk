@@ -36,6 +36,30 @@ ifeq ($(CONFIG_CMD_DEBUG),y)
 FILES+= 	$(SRCDIR)/usr/sbin/debug/debug
 endif
 
+ifeq ($(CONFIG_CMD_BOOTLOG),y)
+FILES+= 	$(SRCDIR)/usr/sbin/bootlog/bootlog
+endif
+
+ifeq ($(CONFIG_CMD_EVTRACE),y)
+FILES+= 	$(SRCDIR)/usr/sbin/evtrace/evtrace
+endif
+
+ifeq ($(CONFIG_CMD_PROF),y)
+FILES+= 	$(SRCDIR)/usr/sbin/prof/prof
+endif
+
+ifeq ($(CONFIG_CMD_LATSTAT),y)
+FILES+= 	$(SRCDIR)/usr/sbin/latstat/latstat
+endif
+
+ifeq ($(CONFIG_CMD_LOCKSTAT),y)
+FILES+= 	$(SRCDIR)/usr/sbin/lockstat/lockstat
+endif
+
+ifeq ($(CONFIG_CMD_IPCSTAT),y)
+FILES+= 	$(SRCDIR)/usr/sbin/ipcstat/ipcstat
+endif
+
 ifneq ($(_QUICK_),1)
 ifneq ($(CONFIG_TINY),y)
 FILES+=		$(SRCDIR)/usr/sample/hello/hello
@@ -54,6 +78,7 @@ endif
 #FILES+= 	$(SRCDIR)/usr/test/fork/fork
 #FILES+= 	$(SRCDIR)/usr/test/forkbomb/forkbomb
 #FILES+= 	$(SRCDIR)/usr/test/memleak/memleak
+#FILES+= 	$(SRCDIR)/usr/test/microbench/microbench
 #FILES+= 	$(SRCDIR)/usr/test/mount/mount
 #FILES+= 	$(SRCDIR)/usr/test/object/object
 #FILES+= 	$(SRCDIR)/usr/test/pipe/pipe
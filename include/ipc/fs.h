@@ -31,6 +31,7 @@
 #define _IPC_FS_H
 
 #include <sys/types.h>
+#include <sys/param.h>
 #include <sys/dirent.h>
 #include <sys/stat.h>
 #include <sys/fcntl.h>
@@ -81,6 +82,7 @@
 #define FS_TRUNCATE	0x00000224
 #define FS_FTRUNCATE	0x00000225
 #define FS_FCHDIR	0x00000226
+#define FS_PIPEMAP	0x00000227
 
 /*
  * Mount message
@@ -107,6 +109,10 @@ struct open_msg {
 
 /*
  * I/O request message
+ *
+ * A request up to MAX_FSDATA bytes may carry its data in the second
+ * segment of the message (see msg_sendv).  In that case, buf is set
+ * to NULL.
  */
 struct io_msg {
 	struct msg_header hdr;		/* message header */
@@ -166,8 +172,41 @@ struct fcntl_msg {
 	struct flock lock;		/* file lock data */
 };
 
+/*
+ * Shared pipe ring
+ *
+ * The file system server allocates one ring for each pipe and
+ * shares it with the tasks using the pipe. The tasks exchange
+ * data through the ring directly, and the server is used only
+ * for open/close and fork/exit bookkeeping. All fields are
+ * protected by pr_lock. The threads waiting for data or free
+ * space sleep on pr_rsem or pr_wsem. The client holding
+ * pr_lock is kept in pr_owner, so that the server can release
+ * the lock if that thread dies.
+ */
+struct pipe_ring {
+	sem_t	pr_lock;		/* lock for this ring */
+	thread_t pr_owner;		/* client thread holding pr_lock */
+	sem_t	pr_rsem;		/* readers wait for data */
+	sem_t	pr_wsem;		/* writers wait for space */
+	int	pr_rwait;		/* number of waiting readers */
+	int	pr_wwait;		/* number of waiting writers */
+	int	pr_readers;		/* number of read ends */
+	int	pr_writers;		/* number of write ends */
+	size_t	pr_start;		/* start offset of data */
+	size_t	pr_count;		/* size of data */
+	size_t	pr_size;		/* size of data area */
+	size_t	pr_lowat;		/* low water mark to wake writers */
+	char	pr_buf[1];		/* data area */
+};
+
+/* Size of the pipe ring including its header */
+#define PIPE_RINGSZ	(4 * PAGE_SIZE)
 
 /* Max size of fs message */
 #define MAX_FSMSG	sizeof(struct mount_msg)
 
+/* Max size of data carried with read/write message */
+#define MAX_FSDATA	1024
+
 #endif /* !_IPC_FS_H */
@@ -46,6 +46,17 @@ struct msg_header {
 	int	status;		/* return status */
 };
 
+/*
+ * Posted message
+ *
+ * A message sent by msg_post() is copied into the queue of the
+ * target object, and the sender does not wait for a reply.
+ * Its size is limited to MSG_POSTSIZE.  msg_wait() stores the
+ * index of the object in the status field of the header.
+ */
+#define MSG_POSTSIZE	64		/* max size of posted message */
+#define MSG_NOWAIT	((u_long)-1)	/* msg_wait() does not block */
+
 /*
  * Standard messages
  */
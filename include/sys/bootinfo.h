@@ -87,6 +87,17 @@ struct physmem
 
 #define NMEMS		8		/* max number of memory slots */
 
+/*
+ * Time stamp of the boot stage in an OS loader
+ */
+struct bootstamp
+{
+	char		name[MAXIMGNAME]; /* name of boot stage */
+	u_long		cycles;		/* cpu cycle counter */
+};
+
+#define NBOOTSTAMPS	4		/* max number of loader stamps */
+
 /*
  * Boot information
  */
@@ -96,6 +107,8 @@ struct bootinfo
 	struct physmem	ram[NMEMS];	/* physical ram table */
 	int		nr_rams;	/* number of ram blocks */
 	struct physmem	bootdisk;	/* boot disk in memory */
+	int		nr_stamps;	/* number of loader stamps */
+	struct bootstamp stamps[NBOOTSTAMPS]; /* loader time stamps */
 	int		nr_tasks;	/* number of boot tasks */
 	struct module	kernel;		/* kernel image */
 	struct module	driver;		/* driver image */
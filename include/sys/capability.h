@@ -51,6 +51,7 @@ typedef uint32_t	cap_t;
 #define CAP_DISKADMIN	0x00000200	/* Allow mount, umount, etc. */
 #define CAP_USERFILES	0x00000400	/* Allow accessing user files */
 #define CAP_SYSFILES	0x00000800	/* Allow accessing system files */
+#define CAP_DIAG	0x00001000	/* Allow kernel diagnostic operations */
 
 /*
  * Default capability set
@@ -75,18 +75,23 @@
 
 #ifdef __GNUC__
 #define	__packed	__attribute__((__packed__))
+#define	__aligned(x)	__attribute__((__aligned__(x)))
 #define	__noreturn	__attribute__((__noreturn__))
 #elif defined(__lint__)
 #define	__packed	/* delete */
+#define	__aligned(x)	/* delete */
 #define	__noreturn	/* delete */
 #elif defined(__PCC__)
 #define	__packed	_Pragma("packed")
+#define	__aligned(x)	/* delete */
 #define	__noreturn	/* delete */
 #elif defined(__SUNPRO_C)
 #define	__packed	/* delete */
+#define	__aligned(x)	/* delete */
 #define	__noreturn	/* delete */
 #else
 #define	__packed	error: no __packed for this compiler
+#define	__aligned(x)	error: no __aligned for this compiler
 #define	__noreturn	/* delete */
 #endif
 
@@ -44,6 +44,13 @@ struct abort_ops {
 #define DBGC_LOGSIZE		0x0001	/* return log size */
 #define DBGC_GETLOG		0x0002	/* get message log */
 #define DBGC_TRACE		0x0003	/* trace thread */
+#define DBGC_PROFSTART		0x0004	/* start profiler */
+#define DBGC_PROFSTOP		0x0005	/* stop profiler */
+#define DBGC_PROFREAD		0x0006	/* read profile samples */
+#define DBGC_LATRESET		0x0007	/* reset latency histograms */
+#define DBGC_LOCKSTAT		0x0008	/* get lock statistics */
+#define DBGC_LOCKRESET		0x0009	/* reset lock statistics */
+#define DBGC_IPCRESET		0x000a	/* reset IPC statistics */
 
 #ifdef KERNEL
 #define DBGC_DUMPTRAP		0x8001	/* dump trap frame */
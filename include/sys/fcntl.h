@@ -98,6 +98,8 @@
 #define	F_GETLK		7		/* get record locking information */
 #define	F_SETLK		8		/* set record locking information */
 #define	F_SETLKW	9		/* F_SETLK; wait if blocked */
+#define	F_GETPIPE_SZ	10		/* get pipe buffer size (Prex) */
+#define	F_SETPIPE_SZ	11		/* set pipe buffer size (Prex) */
 
 /* file descriptor flags (F_GETFD, F_SETFD) */
 #define	FD_CLOEXEC	1		/* close-on-exec flag */
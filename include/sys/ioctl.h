@@ -96,6 +96,14 @@ struct cpufreqinfo {
 #define PMIOC_GET_POLICY	 _IOR('P', 7, int)
 #define PMIOC_SET_POLICY	 _IOW('P', 8, int)
 
+/*
+ * FIFO I/O control code
+ */
+#define FIFOIOC_GET_SIZE	 _IOR('F', 0, int)
+#define FIFOIOC_SET_SIZE	 _IOW('F', 1, int)
+#define FIFOIOC_GET_RING	 _IOR('F', 2, void *)
+#define FIFOIOC_RECOVER		 _IO('F', 3)
+
 /*
  * RTC I/O control code
  */
@@ -0,0 +1,67 @@
+/*-
+ * Copyright (c) 2009, Kohsuke Ohtani
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the author nor the names of any co-contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _SYS_LOCKSTAT_H
+#define _SYS_LOCKSTAT_H
+
+#include <sys/types.h>
+
+/*
+ * Lock counters
+ */
+struct lockcnt {
+	u_long		count;		/* number of acquisitions */
+	u_long		contended;	/* contended acquisitions */
+	u_long		waittime;	/* total wait time, in usec */
+	u_long		waitmax;	/* maximum wait time, in usec */
+	u_long		holdmax;	/* maximum hold time, in usec */
+};
+
+/*
+ * Argument for DBGC_LOCKSTAT
+ *
+ * For the scheduler lock, the statistics are kept for each
+ * call site of sched_lock().  An acquisition is contended if
+ * a thread switch was deferred until the lock is released, and
+ * the wait time is measured from the first deferred wakeup.
+ * For the mutexes, the statistics are kept for each mutex.
+ */
+struct lockstat {
+	int		type;		/* lock type */
+	int		cookie;		/* index cookie */
+	u_long		id;		/* call site or mutex id */
+	task_t		task;		/* task which owns the mutex */
+	struct lockcnt	cnt;		/* counters */
+};
+
+/* Lock type */
+#define LS_SCHED	0	/* scheduler lock */
+#define LS_MUTEX	1	/* mutex */
+
+#endif /* !_SYS_LOCKSTAT_H */
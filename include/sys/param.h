@@ -59,6 +59,9 @@
 #define	MAXTHREADS	128		/* max number of threads per task */
 #define	MAXOBJECTS	32		/* max number of objects per task */
 #define	MAXSYNCS	512		/* max number of synch objects per task */
+#define	MAXPOSTQ	16		/* max posted messages per object */
+#define	MAXWAITOBJ	8		/* max objects for msg_wait() */
+#define	MAXMSGIOV	4		/* max segments of a message */
 #define MAXMEM		(4*1024*1024)	/* max core per task - first # is Mb */
 
 /* The following name length include a null-terminate character */
@@ -66,6 +69,7 @@
 #define MAXDEVNAME	12		/* max device name */
 #define MAXOBJNAME	16		/* max object name */
 #define MAXEVTNAME	12		/* max event name */
+#define MAXSTAGENAME	16		/* max boot stage name */
 
 #define HZ		CONFIG_HZ	/* ticks per second */
 #define MAXIRQS		32		/* max number of irq line */
@@ -0,0 +1,88 @@
+/*-
+ * Copyright (c) 2009, Kohsuke Ohtani
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the author nor the names of any co-contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _SYS_POOL_H_
+#define _SYS_POOL_H_
+
+#include <sys/cdefs.h>
+#include <sys/types.h>
+#include <sys/prex.h>
+
+/*
+ * Pool of fixed-size objects.
+ *
+ * Objects are carved from pages which stay with the pool, and
+ * freed objects are kept for reuse.  A pool is not locked unless
+ * POOL_LOCKED is set; otherwise the caller must serialize it.
+ */
+struct pool {
+	size_t		pr_size;	/* object size */
+	int		pr_flags;	/* flags */
+	mutex_t		pr_lock;	/* lock for POOL_LOCKED */
+	void		*pr_free;	/* list of free objects */
+	char		*pr_page;	/* unused part of the current page */
+	size_t		pr_avail;	/* bytes left in the current page */
+	u_long		pr_nget;	/* number of allocations */
+	u_long		pr_nput;	/* number of frees */
+	u_long		pr_npages;	/* pages owned by the pool */
+};
+
+#define POOL_LOCKED	0x01		/* serialize access */
+
+#define POOL_INITIALIZER(size, flags) \
+	{ (size), (flags), MUTEX_INITIALIZER, NULL, NULL, 0, 0, 0, 0 }
+
+/*
+ * Bump allocator for the data which lives only while one request
+ * is handled.  Memory comes from a buffer given by the owner, and
+ * from extra pages if the buffer is used up.  arena_reset() frees
+ * everything at once.  The buffer must be aligned to 8 bytes.
+ */
+struct arena {
+	char		*ar_base;	/* buffer */
+	size_t		ar_size;	/* size of buffer */
+	size_t		ar_used;	/* bytes used in buffer */
+	void		*ar_extra;	/* list of extra chunks */
+	size_t		ar_peak;	/* max bytes used by one request */
+	size_t		ar_total;	/* bytes used by this request */
+};
+
+#define ARENA_INITIALIZER(buf) \
+	{ (char *)(buf), sizeof(buf), 0, NULL, 0, 0 }
+
+__BEGIN_DECLS
+void	 pool_init(struct pool *, size_t, int);
+void	*pool_get(struct pool *);
+void	 pool_put(struct pool *, void *);
+void	 arena_init(struct arena *, void *, size_t);
+void	*arena_alloc(struct arena *, size_t);
+void	 arena_reset(struct arena *);
+__END_DECLS
+
+#endif /* !_SYS_POOL_H_ */
@@ -36,8 +36,19 @@
 extern object_t __proc_obj;
 extern object_t __fs_obj;
 
+struct pipe_ring;
+struct iovec;
+
 __BEGIN_DECLS
 int __posix_call(object_t, void *, size_t, int);
+int __posix_callv(object_t, const struct iovec *, int, int);
+
+int __pipe_read(int, struct pipe_ring *, void *, size_t, size_t *);
+int __pipe_write(int, struct pipe_ring *, const void *, size_t, size_t *);
+struct pipe_ring *__pipe_lookup(int, int);
+void __pipe_setfd(int, struct pipe_ring *, int);
+void __pipe_dupfd(int, int);
+void __pipe_closefd(int);
 __END_DECLS
 
 #endif	/* KERNEL */
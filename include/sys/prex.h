@@ -38,6 +38,7 @@
 #include <sys/sysinfo.h>
 #include <sys/capability.h>
 #include <sys/dbgctl.h>
+#include <sys/uio.h>
 
 /*
  * vm_option for task_crate()
@@ -109,14 +110,21 @@ int	vm_allocate(task_t task, void **addr, size_t size, int anywhere);
 int	vm_free(task_t task, void *addr);
 int	vm_attribute(task_t task, void *addr, int prot);
 int	vm_map(task_t target, void  *addr, size_t size, void **alloc);
+int	vm_share(task_t target, void *addr, void **alloc);
 
 int	object_create(const char *name, object_t *objp);
 int	object_destroy(object_t obj);
 int	object_lookup(const char *name, object_t *objp);
+int	object_wait(const char *name, object_t *objp, u_long msec);
 
 int	msg_send(object_t obj, void *msg, size_t size);
 int	msg_receive(object_t obj, void *msg, size_t size);
 int	msg_reply(object_t obj, void *msg, size_t size);
+int	msg_sendv(object_t obj, const struct iovec *iov, int iovcnt);
+int	msg_receivev(object_t obj, struct iovec *iov, int iovcnt);
+int	msg_replyv(object_t obj, const struct iovec *iov, int iovcnt);
+int	msg_post(object_t obj, void *msg, size_t size);
+int	msg_wait(object_t *objs, int nobjs, void *msg, u_long msec);
 
 int	timer_sleep(u_long msec, u_long *remain);
 int	timer_alarm(u_long msec, u_long *remain);
@@ -153,6 +161,8 @@ void	sys_panic(const char *msg);
 int	sys_info(int type, void *buf);
 int	sys_time(u_long *ticks);
 int	sys_debug(int cmd, void *data);
+int	sys_bootlog(const char *name);
+int	sys_trace(int cmd, void *data);
 
 void	panic(const char *fmt, ...);
 void	dprintf(const char *fmt, ...);
@@ -34,6 +34,7 @@
 #include <sys/utsname.h>
 #include <sys/capability.h>
 #include <sys/device.h>
+#include <sys/time.h>
 
 /*
  * Max size of info buffer.
@@ -41,7 +42,7 @@
  * Please make sure MAXINFOSZ is still correct if you change
  * the information structure below.
  */
-#define MAXINFOSZ	sizeof(struct kerninfo)
+#define MAXINFOSZ	sizeof(struct threadinfo)
 
 /*
  * Data type for sys_info()
@@ -54,6 +55,10 @@
 #define INFO_VM		6
 #define INFO_DEVICE	7
 #define INFO_IRQ	8
+#define INFO_BOOTLOG	9
+#define INFO_LATENCY	10
+#define INFO_IPC	11
+#define INFO_MSGCODE	12
 
 /*
  * Kernel information
@@ -92,6 +97,13 @@ struct threadinfo {
 	int		active;		/* true if active thread */
 	char		taskname[MAXTASKNAME];	/* task name */
 	char		slpevt[MAXEVTNAME];	/* sleep event */
+	struct timeval	rtime;		/* precise running time */
+	u_long		nvcsw;		/* voluntary context switches */
+	u_long		nivcsw;		/* involuntary context switches */
+	u_long		nwakeup;	/* number of measured wakeups */
+	u_long		wklat;		/* average wakeup latency, in usec */
+	u_long		wklatmax;	/* maximum wakeup latency, in usec */
+	struct timeval	ipcwait;	/* time blocked in IPC */
 };
 
 /*
@@ -127,6 +139,7 @@ struct vminfo {
 #define VF_EXEC		0x00000004
 #define VF_SHARED	0x00000008
 #define VF_MAPPED	0x00000010
+#define VF_PAGED	0x00000020
 #define VF_FREE		0x00000080
 
 /*
@@ -148,6 +161,21 @@ struct timerinfo {
 	u_long		idleticks;	/* total idle ticks */
 };
 
+/*
+ * Latency histogram
+ *
+ * Bucket 0 counts the latencies less than 1 usec, and bucket n
+ * counts the latencies in [2^(n-1), 2^n) usec.  The last bucket
+ * counts all the longer ones too.
+ */
+#define NLATBUCKET	16	/* number of histogram buckets */
+
+struct lathist {
+	u_long		count;		/* number of samples */
+	u_long		max;		/* maximum latency, in usec */
+	u_long		bucket[NLATBUCKET]; /* number of samples */
+};
+
 /*
  * IRQ information
  */
@@ -158,6 +186,60 @@ struct irqinfo {
 	int		priority;	/* interrupt priority */
 	int		istreq;		/* pending ist request */
 	thread_t	thread;		/* thread id of ist */
+	struct lathist	istlat;		/* isr to ist latency */
+};
+
+/*
+ * Scheduling latency information
+ *
+ * The wakeup-to-dispatch latency is kept for each band of
+ * LATBANDPRI priorities.
+ */
+#define LATBANDPRI	32	/* priorities in one band */
+#define NLATBAND	(NPRI / LATBANDPRI) /* number of bands */
+
+struct latinfo {
+	int		cookie;		/* index cookie */
+	int		pri;		/* highest priority in band */
+	struct lathist	lat;		/* wakeup to dispatch latency */
+};
+
+/*
+ * Boot log information
+ */
+struct bootlog {
+	int		cookie;		/* index cookie */
+	char		name[MAXSTAGENAME]; /* name of boot stage */
+	u_long		cycles;		/* cpu cycle counter */
+	u_long		ticks;		/* timer ticks since boot */
+};
+
+/*
+ * IPC object information
+ */
+struct ipcinfo {
+	int		cookie;		/* index cookie */
+	object_t	id;		/* object id */
+	task_t		owner;		/* owner task */
+	char		name[MAXOBJNAME]; /* object name */
+	u_long		nsend;		/* messages sent */
+	u_long		nrecv;		/* messages received */
+	u_long		nreply;		/* messages replied */
+	int		qmax;		/* high-water mark of send queue */
+	u_long		rttavg;		/* average round-trip time, in usec */
+	u_long		rttmax;		/* maximum round-trip time, in usec */
+	struct timeval	busy;		/* time from receive to reply */
+};
+
+/*
+ * IPC statistics of a message code
+ */
+struct msgcodeinfo {
+	int		cookie;		/* index cookie */
+	object_t	object;		/* object id */
+	int		code;		/* message code, -1 for others */
+	u_long		rttavg;		/* average round-trip time, in usec */
+	struct lathist	hist;		/* round-trip time histogram */
 };
 
 #endif /* !_SYS_SYSINFO_H */
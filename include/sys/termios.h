@@ -282,6 +282,8 @@ struct winsize {
 /* Prex unique */
 #define	TIOCSETSIGT	_IOW('t', 200, int)	/* set signal task */
 #define TIOCINQ		_IOR('t', 201, int)	/* input queue size */
+#define TIOCSQSIZE	_IOW('t', 202, int)	/* set queue buffer size */
+#define TIOCGQSIZE	_IOR('t', 203, int)	/* get queue buffer size */
 
 /*
  * Defaults on "first" open.
@@ -0,0 +1,95 @@
+/*-
+ * Copyright (c) 2009, Kohsuke Ohtani
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the author nor the names of any co-contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _SYS_TRACE_H
+#define _SYS_TRACE_H
+
+#include <sys/types.h>
+
+/*
+ * Trace record
+ */
+struct trace_rec {
+	u_long		cycles;		/* cpu cycle counter */
+	u_long		ticks;		/* timer ticks since boot */
+	thread_t	thread;		/* current thread */
+	int		type;		/* event type */
+	u_long		arg[2];		/* event arguments */
+};
+
+/*
+ * Event categories
+ */
+#define TRC_SCHED	0x0001		/* context switch */
+#define TRC_IRQ		0x0002		/* interrupt entry/exit */
+#define TRC_IPC		0x0004		/* message send/receive/reply */
+#define TRC_TIMER	0x0008		/* timer expiration */
+#define TRC_PAGE	0x0010		/* page allocation */
+#define TRC_SYSCALL	0x0020		/* system call entry/exit */
+#define TRC_ALL		0x003f
+
+#define TRC_DEFAULT	(TRC_SCHED | TRC_IRQ | TRC_IPC | TRC_TIMER)
+
+/*
+ * Event types
+ * The upper byte holds the category of the event.
+ */
+#define TREV(cat, n)	(((cat) << 8) | (n))
+#define TREV_CAT(type)	((type) >> 8)
+
+#define TR_SWITCH	TREV(TRC_SCHED, 1)	/* prev thread, next thread */
+#define TR_IRQ_ENTER	TREV(TRC_IRQ, 1)	/* vector */
+#define TR_IRQ_EXIT	TREV(TRC_IRQ, 2)	/* vector */
+#define TR_MSG_SEND	TREV(TRC_IPC, 1)	/* object, size */
+#define TR_MSG_RECV	TREV(TRC_IPC, 2)	/* object, sender thread */
+#define TR_MSG_REPLY	TREV(TRC_IPC, 3)	/* object, sender thread */
+#define TR_TIMER	TREV(TRC_TIMER, 1)	/* callout function, arg */
+#define TR_PAGE_ALLOC	TREV(TRC_PAGE, 1)	/* address, size */
+#define TR_PAGE_FREE	TREV(TRC_PAGE, 2)	/* address, size */
+#define TR_SYSCALL	TREV(TRC_SYSCALL, 1)	/* syscall id, 1st arg */
+#define TR_SYSRET	TREV(TRC_SYSCALL, 2)	/* syscall id, return value */
+
+/*
+ * Trace control code for sys_trace()
+ */
+#define TRACE_SETMASK	1	/* set category mask */
+#define TRACE_GETMASK	2	/* get category mask */
+#define TRACE_READ	3	/* read and remove records */
+#define TRACE_CLEAR	4	/* discard all records */
+
+/*
+ * Argument for TRACE_READ
+ */
+struct trace_req {
+	struct trace_rec *buf;		/* buffer for records */
+	int		count;		/* in: max records, out: read count */
+	u_long		lost;		/* out: records lost by overflow */
+};
+
+#endif /* !_SYS_TRACE_H */
@@ -12,15 +12,31 @@ include $(SRCDIR)/conf/etc/files.mk
 include $(SRCDIR)/mk/common.mk
 -include $(SRCDIR)/bsp/boot/$(ARCH)/$(PLATFORM)/Makefile.sysgen
 
+ifdef FILES
+MODULES:=	$(KERNEL) $(DRIVER) $(TASKS) bootdisk.a
+else
+MODULES:=	$(KERNEL) $(DRIVER) $(TASKS)
+endif
+
+ifeq ($(CONFIG_BOOTCOMP),y)
+LZPACK:=	$(SRCDIR)/bsp/boot/tools/lzpack
+endif
+
 $(TARGET): dummy
 	$(call echo-file,PACK   ,$@)
 ifdef FILES
 	$(AR) rcS bootdisk.a $(FILES)
-	$(AR) rcS tmp.a $(KERNEL) $(DRIVER) $(TASKS) bootdisk.a
-	$(RM) bootdisk.a
+endif
+ifeq ($(CONFIG_BOOTCOMP),y)
+	$(HOSTCC) -O2 -I$(SRCDIR)/bsp/boot/include -o lzpack $(LZPACK)/lzpack.c
+	mkdir -p lz
+	for f in $(MODULES); do ./lzpack $$f lz/`basename $$f` || exit 1; done
+	$(AR) rcS tmp.a $(addprefix lz/,$(notdir $(MODULES)))
+	$(RM) -r lz lzpack
 else
-	$(AR) rcS tmp.a $(KERNEL) $(DRIVER) $(TASKS)
+	$(AR) rcS tmp.a $(MODULES)
 endif
+	$(RM) bootdisk.a
 	$(CAT) $(LOADER) tmp.a > $@
 	$(RM) tmp.a
 	$(call sysgen)
@@ -23,6 +23,7 @@ LINT:=		splint
 #LINT:=		lint
 RM:=		rm -f
 CAT:=		cat
+HOSTCC?=	cc
 ifdef SHELL_PATH
 SHELL:=		$(SHELL_PATH)
 endif
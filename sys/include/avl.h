@@ -0,0 +1,66 @@
+/*-
+ * Copyright (c) 2009, Kohsuke Ohtani
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the author nor the names of any co-contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _AVL_H
+#define _AVL_H
+
+#include <sys/cdefs.h>
+
+/*
+ * Node of AVL tree.
+ * This is embedded in the structure to be indexed.
+ */
+struct avlnode {
+	struct avlnode	*left;
+	struct avlnode	*right;
+	int		height;		/* height of sub tree */
+};
+
+/*
+ * Compare function for tree.
+ * The keys must be unique within a tree.
+ */
+typedef int (*avlcmp_t)(const struct avlnode *, const struct avlnode *);
+
+struct avltree {
+	struct avlnode	*root;		/* root node */
+	avlcmp_t	cmp;		/* compare function */
+};
+
+/* Get the struct for this entry */
+#define avl_entry(n, type, member) \
+    ((type *)((char *)(n) - (unsigned long)(&((type *)0)->member)))
+
+__BEGIN_DECLS
+void	avl_init(struct avltree *, avlcmp_t);
+void	avl_insert(struct avltree *, struct avlnode *);
+void	avl_remove(struct avltree *, struct avlnode *);
+__END_DECLS
+
+#endif /* !_AVL_H */
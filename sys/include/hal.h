@@ -102,6 +102,7 @@ void	  context_switch(context_t, context_t);
 void	  context_save(context_t);
 void	  context_restore(context_t);
 void	  context_dump(context_t);
+void	  context_cleanup(context_t);
 
 void	  mmu_init(struct mmumap *);
 void	  mmu_premap(paddr_t, vaddr_t);
@@ -125,12 +126,14 @@ void	  interrupt_mask(int);
 void	  interrupt_unmask(int, int);
 void	  interrupt_setup(int, int);
 void	  interrupt_init(void);
+vaddr_t	  interrupt_pc(void);
 
 void	  machine_startup(void);
 void	  machine_idle(void);
 void	  machine_powerdown(int);
 void	  machine_abort(void);
 void	  machine_bootinfo(struct bootinfo **);
+u_long	  machine_cycles(void);
 
 void	  clock_init(void);
 
@@ -34,8 +34,62 @@
 #include <types.h>
 #include <sys/list.h>
 #include <sys/queue.h>
+#include <sys/uio.h>
+#include <sys/sysinfo.h>
 #include <ipc/ipc.h>
 
+/*
+ * Queue of posted messages.
+ */
+struct postmsg {
+	size_t		size;		/* message size */
+	char		data[MSG_POSTSIZE]; /* message body */
+};
+
+struct postq {
+	int		head;		/* index of the first message */
+	int		count;		/* number of queued messages */
+	struct postmsg	msgs[MAXPOSTQ];	/* message ring */
+};
+
+/*
+ * Link of a thread waiting in msg_wait to one of its objects.
+ * It is kept on the kernel stack of the waiting thread.
+ */
+struct postwait {
+	struct queue	link;		/* linkage on postwaitq of object */
+	thread_t	thread;		/* waiting thread */
+};
+
+#ifdef CONFIG_IPCSTAT
+/*
+ * IPC statistics of a message code.
+ */
+struct msgcode {
+	int		code;		/* message code */
+	struct timeval	rtt;		/* total round-trip time */
+	struct lathist	hist;		/* round-trip time histogram */
+};
+
+#define NMSGCODE	32	/* message codes kept per object */
+
+/*
+ * IPC statistics of an object.
+ * Allocated when the first message is sent to the object.
+ */
+struct ipcstat {
+	u_long		nsend;		/* messages sent */
+	u_long		nrecv;		/* messages received */
+	u_long		nreply;		/* messages replied */
+	int		qmax;		/* high-water mark of send queue */
+	struct timeval	rtt;		/* total round-trip time */
+	u_long		rttmax;		/* maximum round-trip time, in usec */
+	struct timeval	busy;		/* time from receive to reply */
+	struct msgcode	codes[NMSGCODE]; /* statistics per message code */
+	struct msgcode	other;		/* codes not in the table */
+};
+#endif /* CONFIG_IPCSTAT */
+
 struct object {
 	struct list	link;		/* linkage for all objects in system */
 	char		name[MAXOBJNAME]; /* object name */
@@ -43,19 +97,36 @@ struct object {
 	task_t		owner;		/* creator of this object */
 	struct queue	sendq;		/* queue for sender threads */
 	struct queue	recvq;		/* queue for receiver threads */
+	struct postq	*postq;		/* posted messages */
+	struct queue	postwaitq;	/* threads waiting for posted message */
+#ifdef CONFIG_IPCSTAT
+	int		sendqlen;	/* number of threads in sendq */
+	struct ipcstat	*stat;		/* IPC statistics */
+#endif
 };
 
 __BEGIN_DECLS
 int	 object_create(const char *, object_t *);
 int	 object_lookup(const char *, object_t *);
+int	 object_wait(const char *, object_t *, u_long);
 int	 object_destroy(object_t);
 int	 object_valid(object_t);
 void	 object_cleanup(task_t);
+#ifdef CONFIG_IPCSTAT
+int	 object_info(struct ipcinfo *);
+int	 object_codeinfo(struct msgcodeinfo *);
+void	 object_statreset(void);
+#endif
 void	 object_init(void);
 
 int	 msg_send(object_t, void *, size_t);
 int	 msg_receive(object_t, void *, size_t);
 int	 msg_reply(object_t, void *, size_t);
+int	 msg_sendv(object_t, const struct iovec *, int);
+int	 msg_receivev(object_t, struct iovec *, int);
+int	 msg_replyv(object_t, const struct iovec *, int);
+int	 msg_post(object_t, void *, size_t);
+int	 msg_wait(object_t *, int, void *, u_long);
 void	 msg_cancel(thread_t);
 void	 msg_abort(object_t);
 void	 msg_init(void);
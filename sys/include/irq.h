@@ -35,6 +35,7 @@
 #include <sys/sysinfo.h>
 #include <sys/ipl.h>
 #include <event.h>
+#include <timer.h>
 
 struct irq {
 	int		vector;		/* vector number */
@@ -46,6 +47,11 @@ struct irq {
 	int		istreq;		/* number of ist request */
 	thread_t	thread;		/* thread id of ist */
 	struct event	istevt;		/* event for ist */
+#ifdef CONFIG_LATSTAT
+	struct tstamp	iststamp;	/* time stamp of oldest ist request */
+	int		istpend;	/* true if iststamp is valid */
+	struct lathist	istlat;		/* isr to ist latency */
+#endif
 };
 
 /*
@@ -68,6 +74,9 @@ irq_t	 irq_attach(int, int, int, int (*)(void *), void (*)(void *), void *);
 void	 irq_detach(irq_t);
 void	 irq_handler(int);
 int	 irq_info(struct irqinfo *);
+#ifdef CONFIG_LATSTAT
+void	 irq_latreset(void);
+#endif
 void	 irq_init(void);
 __BEGIN_DECLS
 
@@ -40,6 +40,7 @@ int	 strncmp(const char *, const char *, size_t);
 size_t	 strnlen(const char *, size_t);
 void	*memcpy(void *, const void *, size_t);
 void	*memset(void *, int, size_t);
+int	 memcmp(const void *, const void *, size_t);
 int	 vsprintf(char *, const char *, va_list);
 __BEGIN_DECLS
 
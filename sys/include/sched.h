@@ -33,6 +33,7 @@
 #include <types.h>
 #include <sys/cdefs.h>
 #include <sys/queue.h>
+#include <sys/sysinfo.h>
 #include <event.h>
 
 /*
@@ -81,6 +82,10 @@ void	 sched_setpri(thread_t, int, int);
 int	 sched_getpolicy(thread_t);
 int	 sched_setpolicy(thread_t, int);
 void	 sched_dpc(struct dpc *, void (*)(void *), void *);
+#ifdef CONFIG_LATSTAT
+int	 sched_latinfo(struct latinfo *);
+void	 sched_latreset(void);
+#endif
 void	 sched_init(void);
 __END_DECLS
 
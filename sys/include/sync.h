@@ -33,7 +33,9 @@
 #include <types.h>
 #include <sys/cdefs.h>
 #include <sys/list.h>
+#include <sys/lockstat.h>
 #include <event.h>
+#include <timer.h>
 
 struct sem {
 	struct sem	*next;		/* linkage on semaphore list in system */
@@ -52,6 +54,11 @@ struct mutex {
 	thread_t	holder;		/* thread that holds the mutex */
 	int		priority;	/* highest priority in waiting threads */
 	int		locks;		/* counter for recursive lock */
+#ifdef CONFIG_LOCKSTAT
+	struct list	stat_link;	/* linkage on all mutex list */
+	struct tstamp	holdstamp;	/* time stamp at lock */
+	struct lockcnt	stat;		/* lock statistics */
+#endif
 };
 
 struct cond {
@@ -86,6 +93,8 @@ int	 mutex_unlock(mutex_t *);
 void	 mutex_cancel(thread_t);
 void	 mutex_setpri(thread_t, int);
 void	 mutex_cleanup(task_t);
+int	 mutex_lockstat(struct lockstat *);
+void	 mutex_lockreset(void);
 
 int	 cond_init(cond_t *);
 int	 cond_destroy(cond_t *);
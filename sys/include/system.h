@@ -33,6 +33,8 @@
 #include <types.h>
 #include <sys/cdefs.h>
 
+#define NBOOTLOG	64	/* max number of boot log records */
+
 __BEGIN_DECLS
 int	 sysinfo(int, void *);
 int	 sys_info(int, void *);
@@ -41,6 +43,9 @@ int	 sys_debug(int, void *);
 int	 sys_panic(const char *);
 int	 sys_time(u_long *);
 int	 sys_nosys(void);
+int	 sys_bootlog(const char *);
+void	 bootlog_mark(const char *);
+void	 bootlog_init(void);
 __END_DECLS
 
 #endif /* !_SYSTEM_H */
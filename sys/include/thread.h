@@ -35,6 +35,7 @@
 #include <sys/queue.h>
 #include <sys/list.h>
 #include <sys/sysinfo.h>
+#include <sys/uio.h>
 #include <event.h>
 #include <timer.h>
 #include <hal.h>
@@ -53,8 +54,24 @@ struct thread {
 	int		basepri;	/* statical base priority */
 	int		timeleft;	/* remaining ticks to run */
 	u_int		time;		/* total running time */
+	struct tstamp	swstamp;	/* time stamp at last switch */
+	u_long		rcycles;	/* cycles not billed yet */
+	struct timeval	rtime;		/* precise running time */
+	u_long		nvcsw;		/* voluntary context switches */
+	u_long		nivcsw;		/* involuntary context switches */
+	struct tstamp	wkstamp;	/* time stamp at wakeup */
+	int		waking;		/* true if not dispatched after wakeup */
+	u_long		nwakeup;	/* number of measured wakeups */
+	u_long		wklat;		/* total wakeup latency, in usec */
+	u_long		wklatmax;	/* maximum wakeup latency, in usec */
+	struct timeval	ipcwait;	/* time blocked in IPC */
 	int		resched;	/* true if rescheduling is needed */
 	int		locks;		/* schedule lock counter */
+#ifdef CONFIG_LOCKSTAT
+	vaddr_t		lockpc;		/* call site of outermost lock */
+	struct tstamp	lockstamp;	/* time stamp at lock or switch */
+	u_long		lockheld;	/* lock hold time before switch */
+#endif
 	int		suscnt;		/* suspend count */
 	struct event	*slpevt;	/* event we are waiting on */
 	int		slpret;		/* return value for sched_tleep */
@@ -64,12 +81,19 @@ struct thread {
 	struct list 	mutexes;	/* mutexes locked by this thread */
 	mutex_t 	mutex_waiting;	/* mutex pointer currently waiting */
 	struct queue 	ipc_link;	/* linkage on IPC queue */
-	void		*msgaddr;	/* kernel address of IPC message */
-	size_t		msgsize;	/* size of IPC message */
+	struct iovec	msgiov[MAXMSGIOV]; /* segments of IPC message */
+	int		msgiovcnt;	/* number of segments */
 	thread_t	sender;		/* thread that sends IPC message */
 	thread_t	receiver;	/* thread that receives IPC message */
 	object_t 	sendobj;	/* IPC object sending to */
 	object_t 	recvobj;	/* IPC object receiving from */
+	struct postwait	*postwait;	/* links to objects in msg_wait */
+	int		npostwait;	/* number of links */
+#ifdef CONFIG_IPCSTAT
+	int		msgcode;	/* code of message being sent */
+	struct tstamp	sendstamp;	/* time stamp at send */
+	struct tstamp	recvstamp;	/* time stamp at receive */
+#endif
 	void		*kstack;	/* base address of kernel stack */
 	struct context 	ctx;		/* machine specific context */
 };
@@ -34,6 +34,7 @@
 #include <sys/cdefs.h>
 #include <sys/list.h>
 #include <sys/sysinfo.h>
+#include <sys/time.h>
 #include <event.h>
 
 /*
@@ -49,6 +50,14 @@ struct timer {
 	struct event	event;		/* event for this timer */
 };
 
+/*
+ * Time stamp to measure a short interval.
+ */
+struct tstamp {
+	u_long		cycles;		/* cpu cycle counter */
+	u_long		ticks;		/* ticks since boot */
+};
+
 /* state for timer */
 #define TM_ACTIVE	0x54616321	/* magic# 'Tac!' */
 #define TM_STOP		0x54737421	/* magic# 'Tst!' */
@@ -81,6 +90,10 @@ void	 timer_cancel(thread_t);
 void	 timer_clock(void);
 void	 timer_handler(void);
 u_long	 timer_ticks(void);
+void	 timer_stamp(struct tstamp *);
+u_long	 timer_elapsed(struct tstamp *);
+void	 timer_addtime(struct timeval *, struct tstamp *, u_long *);
+void	 timer_histadd(struct lathist *, u_long);
 void	 timer_info(struct timerinfo *);
 void	 timer_init(void);
 __END_DECLS
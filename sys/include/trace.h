@@ -0,0 +1,61 @@
+/*-
+ * Copyright (c) 2009, Kohsuke Ohtani
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the author nor the names of any co-contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+#ifndef _TRACE_H
+#define _TRACE_H
+
+#include <types.h>
+#include <sys/cdefs.h>
+#include <sys/trace.h>
+
+#define NTRACE		1024	/* number of trace records (power of 2) */
+
+/*
+ * Record a trace event.
+ * The category mask is checked inline so that the disabled
+ * events cost only a load and a test.
+ */
+#ifdef CONFIG_TRACE
+#define TRACE(type, a0, a1)						\
+	do {								\
+		if (trace_mask & TREV_CAT(type))			\
+			trace_event(type, (u_long)(a0), (u_long)(a1));	\
+	} while (0)
+#else
+#define TRACE(type, a0, a1)	do {} while (0)
+#endif
+
+extern u_long trace_mask;
+
+__BEGIN_DECLS
+void	 trace_event(int, u_long, u_long);
+int	 sys_trace(int, void *);
+__END_DECLS
+
+#endif /* !_TRACE_H */
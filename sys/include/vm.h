@@ -34,6 +34,7 @@
 #include <sys/cdefs.h>
 #include <sys/sysinfo.h>
 #include <sys/bootinfo.h>
+#include <avl.h>
 
 /*
  * One structure per allocated segment.
@@ -43,10 +44,13 @@ struct seg {
 	struct seg	*next;
 	struct seg	*sh_prev;	/* link for all shared segments */
 	struct seg	*sh_next;
+	struct avlnode	anode;		/* node in address tree */
+	struct avlnode	fnode;		/* node in free segment tree */
 	vaddr_t		addr;		/* base address */
 	size_t		size;		/* size */
 	int		flags;		/* SEG_* flag */
 	paddr_t		phys;		/* physical address */
+	paddr_t		*pages;		/* page frames if SEG_PAGED */
 };
 
 /* Flags for segment */
@@ -55,6 +59,7 @@ struct seg {
 #define SEG_EXEC	0x00000004
 #define SEG_SHARED	0x00000008
 #define SEG_MAPPED	0x00000010
+#define SEG_PAGED	0x00000020
 #define SEG_FREE	0x00000080
 
 /* Attribute for vm_attribute() */
@@ -68,6 +73,8 @@ struct seg {
  */
 struct vm_map {
 	struct seg	head;		/* list head of segements */
+	struct avltree	segtree;	/* all segments sorted by address */
+	struct avltree	freetree;	/* free segments sorted by size */
 	int		refcnt;		/* reference count */
 	pgd_t		pgd;		/* page directory */
 	size_t		total;		/* total used size */
@@ -78,6 +85,7 @@ int	 vm_allocate(task_t, void **, size_t, int);
 int	 vm_free(task_t, void *);
 int	 vm_attribute(task_t, void *, int);
 int	 vm_map(task_t, void *, size_t, void **);
+int	 vm_share(task_t, void *, void **);
 vm_map_t vm_dup(vm_map_t);
 vm_map_t vm_create(void);
 int	 vm_reference(vm_map_t);
@@ -85,6 +93,8 @@ void	 vm_terminate(vm_map_t);
 void	 vm_switch(vm_map_t);
 int	 vm_load(vm_map_t, struct module *, void **);
 paddr_t	 vm_translate(vaddr_t, size_t);
+paddr_t	 vm_translate_task(task_t, vaddr_t, size_t);
+int	 vm_writable(task_t, vaddr_t, size_t);
 int	 vm_info(struct vminfo *);
 void	 vm_init(void);
 __END_DECLS
@@ -53,22 +53,128 @@
  * mapped to the receiver's memory by kernel. Since there is no page
  * out of memory in this system, we can copy the message data via physical
  * memory at anytime.
+ *
+ * msg_sendv, msg_receivev and msg_replyv take a list of segments.  The
+ * first segment holds the message, and the others carry bulk data.  The
+ * kernel copies each segment to the peer's segment of the same index,
+ * so that a server can get or return the payload of a request in the
+ * same operation.
+ *
+ * For notifications which need no reply, msg_post sends a message
+ * asynchronously.  The message is copied into a bounded queue of the
+ * target object, and the sender returns at once.  The owner of the
+ * object takes posted messages by msg_wait, which can wait on several
+ * objects at a time.  A waiting thread is linked to the wait queue of
+ * each of its objects, so that a post wakes only the threads waiting
+ * on the posted object.
  */
 
 #include <kernel.h>
 #include <sched.h>
 #include <task.h>
 #include <kmem.h>
+#include <vm.h>
 #include <thread.h>
 #include <task.h>
 #include <event.h>
+#include <timer.h>
 #include <ipc.h>
+#include <trace.h>
 
 /* forward declarations */
+static int	msg_dosend(object_t, struct iovec *, int);
+static int	msg_doreceive(object_t, struct iovec *, int, struct iovec *);
+static int	msg_doreply(object_t, struct iovec *, int);
 static thread_t	msg_dequeue(queue_t);
 static void	msg_enqueue(queue_t, thread_t);
+static void	msg_postwakeup(object_t, int);
+#ifdef CONFIG_IPCSTAT
+static void	msg_sendstat(object_t);
+static void	msg_replystat(object_t, thread_t);
+#endif
 
 static struct event ipc_event;		/* event for IPC operation */
+static struct event post_event;		/* event for posted message */
+
+/*
+ * Check the segments of a message in the current task.
+ * All pages must be mapped in the user area.
+ */
+static int
+msg_check(const struct iovec *iov, int cnt)
+{
+	vaddr_t va, start, end;
+	int i;
+
+	for (i = 0; i < cnt; i++) {
+		if (iov[i].iov_len == 0)
+			continue;
+		start = (vaddr_t)iov[i].iov_base;
+		end = start + iov[i].iov_len - 1;
+		if (end < start || !user_area(start) || !user_area(end))
+			return EFAULT;
+		for (va = trunc_page(start); va <= end; va += PAGE_SIZE) {
+			if (vm_translate(va, 1) == 0)
+				return EFAULT;
+			if (va + PAGE_SIZE < va)
+				break;
+		}
+	}
+	return 0;
+}
+
+/*
+ * Copy data between the address space of another task and
+ * the current task.  The data is accessed page by page via
+ * the kernel mapping, so that it need not be contiguous in
+ * physical memory.  If "in" is true, the data is copied from
+ * the current task to the other task.  The kernel mapping
+ * ignores the page protection, so the target area must be
+ * checked to be writable by the other task.
+ */
+static int
+msg_copy(task_t task, void *taddr, void *uaddr, size_t len, int in)
+{
+	vaddr_t va = (vaddr_t)taddr;
+	char *ua = uaddr;
+	paddr_t pa;
+	size_t n;
+	int error;
+
+	while (len > 0) {
+		n = PAGE_SIZE - (size_t)(va & PAGE_MASK);
+		if (n > len)
+			n = len;
+		if ((pa = vm_translate_task(task, va, n)) == 0)
+			return EFAULT;
+		if (in && !vm_writable(task, va, n))
+			return EFAULT;
+		if (in)
+			error = copyin(ua, ptokv(pa), n);
+		else
+			error = copyout(ptokv(pa), ua, n);
+		if (error)
+			return EFAULT;
+		va += n;
+		ua += n;
+		len -= n;
+	}
+	return 0;
+}
+
+/*
+ * Copy in the segment list from the user space.
+ */
+static int
+msg_getiov(const struct iovec *uiov, int cnt, struct iovec *iov)
+{
+
+	if (cnt <= 0 || cnt > MAXMSGIOV)
+		return EINVAL;
+	if (copyin(uiov, iov, sizeof(struct iovec) * (size_t)cnt))
+		return EFAULT;
+	return 0;
+}
 
 /*
  * Send a message.
@@ -79,16 +185,42 @@ static struct event ipc_event;		/* event for IPC operation */
  */
 int
 msg_send(object_t obj, void *msg, size_t size)
+{
+	struct iovec iov;
+
+	iov.iov_base = msg;
+	iov.iov_len = size;
+	return msg_dosend(obj, &iov, 1);
+}
+
+/*
+ * Send a message with the data segments.
+ *
+ * The first segment holds the message, and the others carry
+ * the data.  Each segment is copied to the corresponding
+ * segment of the receiver, and the reply is copied back in
+ * the same way.
+ */
+int
+msg_sendv(object_t obj, const struct iovec *uiov, int cnt)
+{
+	struct iovec iov[MAXMSGIOV];
+	int error;
+
+	if ((error = msg_getiov(uiov, cnt, iov)) != 0)
+		return error;
+	return msg_dosend(obj, iov, cnt);
+}
+
+static int
+msg_dosend(object_t obj, struct iovec *iov, int cnt)
 {
 	struct msg_header *hdr;
+	struct tstamp ts;
 	thread_t t;
-	void *kmsg;
-	int rc;
+	int i, rc;
 
-	if (!user_area(msg))
-		return EFAULT;
-
-	if (size < sizeof(struct msg_header))
+	if (iov[0].iov_len < sizeof(struct msg_header))
 		return EINVAL;
 
 	sched_lock();
@@ -107,24 +239,34 @@ msg_send(object_t obj, void *msg, size_t size)
 		return EDEADLK;
 	}
 	/*
-	 * Translate message address to the kernel linear
-	 * address.  So that a receiver thread can access
-	 * the message via kernel pointer. We can catch
-	 * the page fault here.
+	 * Check the message buffers now.  So that the
+	 * receiver can copy them from our address space
+	 * without a fault.
 	 */
-	if ((kmsg = kmem_map(msg, size)) == NULL) {
+	if (msg_check(iov, cnt)) {
 		sched_unlock();
 		return EFAULT;
 	}
-	curthread->msgaddr = kmsg;
-	curthread->msgsize = size;
-
 	/*
 	 * The sender ID is filled in the message header
 	 * by the kernel. So, the receiver can trust it.
 	 */
-	hdr = (struct msg_header *)kmsg;
-	hdr->task = curtask;
+	hdr = (struct msg_header *)iov[0].iov_base;
+	if (copyout(&curtask, &hdr->task, sizeof(task_t))) {
+		sched_unlock();
+		return EFAULT;
+	}
+#ifdef CONFIG_IPCSTAT
+	if (copyin(&hdr->code, &curthread->msgcode, sizeof(int))) {
+		sched_unlock();
+		return EFAULT;
+	}
+	timer_stamp(&curthread->sendstamp);
+#endif
+	for (i = 0; i < cnt; i++)
+		curthread->msgiov[i] = iov[i];
+	curthread->msgiovcnt = cnt;
+	TRACE(TR_MSG_SEND, obj, iov[0].iov_len);
 
 	/*
 	 * If receiver already exists, wake it up.
@@ -142,9 +284,20 @@ msg_send(object_t obj, void *msg, size_t size)
 	 */
 	curthread->sendobj = obj;
 	msg_enqueue(&obj->sendq, curthread);
+#ifdef CONFIG_IPCSTAT
+	obj->sendqlen++;
+	msg_sendstat(obj);
+#endif
+	timer_stamp(&ts);
 	rc = sched_sleep(&ipc_event);
-	if (rc == SLP_INTR)
+	timer_addtime(&curthread->ipcwait, &ts, NULL);
+	if (rc == SLP_INTR) {
 		queue_remove(&curthread->ipc_link);
+#ifdef CONFIG_IPCSTAT
+		if (curthread->receiver == NULL)
+			obj->sendqlen--;
+#endif
+	}
 	curthread->sendobj = NULL;
 
 	sched_unlock();
@@ -187,12 +340,42 @@ msg_send(object_t obj, void *msg, size_t size)
 int
 msg_receive(object_t obj, void *msg, size_t size)
 {
+	struct iovec iov;
+
+	iov.iov_base = msg;
+	iov.iov_len = size;
+	return msg_doreceive(obj, &iov, 1, NULL);
+}
+
+/*
+ * Receive a message with the data segments.
+ * The iov_len of each segment is updated to the size actually
+ * received. The segments which the sender did not give are
+ * set to zero length, and their buffers are left untouched.
+ */
+int
+msg_receivev(object_t obj, struct iovec *uiov, int cnt)
+{
+	struct iovec iov[MAXMSGIOV];
+	int error;
+
+	if ((error = msg_getiov(uiov, cnt, iov)) != 0)
+		return error;
+	return msg_doreceive(obj, iov, cnt, uiov);
+}
+
+static int
+msg_doreceive(object_t obj, struct iovec *iov, int cnt, struct iovec *uiov)
+{
+	struct tstamp ts;
 	thread_t t;
 	size_t len;
-	int rc, error = 0;
+	int i, rc, error = 0;
 
-	if (!user_area(msg))
-		return EFAULT;
+	for (i = 0; i < cnt; i++) {
+		if (!user_area(iov[i].iov_base))
+			return EFAULT;
+	}
 
 	sched_lock();
 
@@ -223,7 +406,9 @@ msg_receive(object_t obj, void *msg, size_t size)
 		 * Block until someone sends a message.
 		 */
 		msg_enqueue(&obj->recvq, curthread);
+		timer_stamp(&ts);
 		rc = sched_sleep(&ipc_event);
+		timer_addtime(&curthread->ipcwait, &ts, NULL);
 		if (rc != 0) {
 			/*
 			 * Receive is failed due to some reasons.
@@ -255,27 +440,50 @@ msg_receive(object_t obj, void *msg, size_t size)
 	}
 
 	t = msg_dequeue(&obj->sendq);
+#ifdef CONFIG_IPCSTAT
+	obj->sendqlen--;
+#endif
 
 	/*
 	 * Copy out the message to the user-space.
 	 */
-	len = MIN(size, t->msgsize);
-	if (len > 0) {
-		if (copyout(t->msgaddr, msg, len)) {
-			msg_enqueue(&obj->sendq, t);
-			curthread->recvobj = NULL;
-			sched_unlock();
-			return EFAULT;
-		}
+	for (i = 0; i < cnt; i++) {
+		len = 0;
+		if (i < t->msgiovcnt)
+			len = MIN(iov[i].iov_len, t->msgiov[i].iov_len);
+		iov[i].iov_len = len;
+		if (len == 0)
+			continue;
+		if (msg_copy(t->task, t->msgiov[i].iov_base,
+			     iov[i].iov_base, len, 0))
+			goto fault;
 	}
+	if (uiov != NULL &&
+	    copyout(iov, uiov, sizeof(struct iovec) * (size_t)cnt))
+		goto fault;
 	/*
 	 * Detach the message from the target object.
 	 */
 	curthread->sender = t;
 	t->receiver = curthread;
+#ifdef CONFIG_IPCSTAT
+	timer_stamp(&curthread->recvstamp);
+	if (obj->stat != NULL)
+		obj->stat->nrecv++;
+#endif
+	TRACE(TR_MSG_RECV, obj, t);
 
 	sched_unlock();
 	return error;
+
+ fault:
+	msg_enqueue(&obj->sendq, t);
+#ifdef CONFIG_IPCSTAT
+	obj->sendqlen++;
+#endif
+	curthread->recvobj = NULL;
+	sched_unlock();
+	return EFAULT;
 }
 
 /*
@@ -286,12 +494,39 @@ msg_receive(object_t obj, void *msg, size_t size)
  */
 int
 msg_reply(object_t obj, void *msg, size_t size)
+{
+	struct iovec iov;
+
+	iov.iov_base = msg;
+	iov.iov_len = size;
+	return msg_doreply(obj, &iov, 1);
+}
+
+/*
+ * Send a reply message with the data segments.
+ */
+int
+msg_replyv(object_t obj, const struct iovec *uiov, int cnt)
+{
+	struct iovec iov[MAXMSGIOV];
+	int error;
+
+	if ((error = msg_getiov(uiov, cnt, iov)) != 0)
+		return error;
+	return msg_doreply(obj, iov, cnt);
+}
+
+static int
+msg_doreply(object_t obj, struct iovec *iov, int cnt)
 {
 	thread_t t;
 	size_t len;
+	int i;
 
-	if (!user_area(msg))
-		return EFAULT;
+	for (i = 0; i < cnt; i++) {
+		if (!user_area(iov[i].iov_base))
+			return EFAULT;
+	}
 
 	sched_lock();
 
@@ -312,9 +547,12 @@ msg_reply(object_t obj, void *msg, size_t size)
 	 * Copy a message to the sender's buffer.
 	 */
 	t = curthread->sender;
-	len = MIN(size, t->msgsize);
-	if (len > 0) {
-		if (copyin(msg, t->msgaddr, len)) {
+	for (i = 0; i < cnt && i < t->msgiovcnt; i++) {
+		len = MIN(iov[i].iov_len, t->msgiov[i].iov_len);
+		if (len == 0)
+			continue;
+		if (msg_copy(t->task, t->msgiov[i].iov_base,
+			     iov[i].iov_base, len, 1)) {
 			sched_unlock();
 			return EFAULT;
 		}
@@ -322,6 +560,10 @@ msg_reply(object_t obj, void *msg, size_t size)
 	/*
 	 * Wakeup sender with no error.
 	 */
+	TRACE(TR_MSG_REPLY, obj, t);
+#ifdef CONFIG_IPCSTAT
+	msg_replystat(obj, t);
+#endif
 	sched_unsleep(t, 0);
 	t->receiver = NULL;
 
@@ -333,6 +575,238 @@ msg_reply(object_t obj, void *msg, size_t size)
 	return 0;
 }
 
+#ifdef CONFIG_IPCSTAT
+/*
+ * Count a message sent to the object, and update the
+ * high-water mark of the send queue.
+ */
+static void
+msg_sendstat(object_t obj)
+{
+	struct ipcstat *st;
+
+	if ((st = obj->stat) == NULL) {
+		if ((st = kmem_alloc(sizeof(*st))) == NULL)
+			return;
+		memset(st, 0, sizeof(*st));
+		st->other.code = -1;
+		obj->stat = st;
+	}
+	st->nsend++;
+	if (obj->sendqlen > st->qmax)
+		st->qmax = obj->sendqlen;
+}
+
+/*
+ * Add a time in usec to the total.
+ */
+static void
+msg_addtime(struct timeval *tv, u_long usec)
+{
+
+	tv->tv_sec += usec / 1000000;
+	tv->tv_usec += usec % 1000000;
+	if (tv->tv_usec >= 1000000) {
+		tv->tv_usec -= 1000000;
+		tv->tv_sec++;
+	}
+}
+
+/*
+ * Account the round-trip time of the message from the
+ * sender t, and the time the receiver spent on it.
+ */
+static void
+msg_replystat(object_t obj, thread_t t)
+{
+	struct ipcstat *st;
+	struct msgcode *mc;
+	u_long rtt;
+	int i, n;
+
+	if ((st = obj->stat) == NULL)
+		return;
+
+	rtt = timer_elapsed(&t->sendstamp);
+	st->nreply++;
+	msg_addtime(&st->rtt, rtt);
+	if (rtt > st->rttmax)
+		st->rttmax = rtt;
+	timer_addtime(&st->busy, &curthread->recvstamp, NULL);
+
+	/*
+	 * Find the entry of the message code.
+	 */
+	mc = &st->other;
+	n = (int)((u_int)t->msgcode % NMSGCODE);
+	for (i = 0; i < NMSGCODE; i++) {
+		if (st->codes[n].hist.count == 0)
+			st->codes[n].code = t->msgcode;
+		if (st->codes[n].code == t->msgcode) {
+			mc = &st->codes[n];
+			break;
+		}
+		if (++n == NMSGCODE)
+			n = 0;
+	}
+	msg_addtime(&mc->rtt, rtt);
+	timer_histadd(&mc->hist, rtt);
+}
+#endif /* CONFIG_IPCSTAT */
+
+/*
+ * Post a message.
+ *
+ * The message is queued to the object and the current thread
+ * does not wait for any reply.  The size of the message must
+ * not exceed MSG_POSTSIZE.  If the queue is full, EAGAIN is
+ * returned without blocking.
+ */
+int
+msg_post(object_t obj, void *msg, size_t size)
+{
+	struct postq *pq;
+	struct postmsg *pm;
+	struct msg_header *hdr;
+
+	if (!user_area(msg))
+		return EFAULT;
+
+	if (size < sizeof(struct msg_header) || size > MSG_POSTSIZE)
+		return EINVAL;
+
+	sched_lock();
+
+	if (!object_valid(obj)) {
+		sched_unlock();
+		return EINVAL;
+	}
+	if ((pq = obj->postq) == NULL) {
+		if ((pq = kmem_alloc(sizeof(*pq))) == NULL) {
+			sched_unlock();
+			return ENOMEM;
+		}
+		pq->head = 0;
+		pq->count = 0;
+		obj->postq = pq;
+	}
+	if (pq->count >= MAXPOSTQ) {
+		sched_unlock();
+		return EAGAIN;
+	}
+	pm = &pq->msgs[(pq->head + pq->count) % MAXPOSTQ];
+	if (copyin(msg, pm->data, size)) {
+		sched_unlock();
+		return EFAULT;
+	}
+	pm->size = size;
+	hdr = (struct msg_header *)pm->data;
+	hdr->task = curtask;
+	pq->count++;
+
+	msg_postwakeup(obj, 0);
+	sched_unlock();
+	return 0;
+}
+
+/*
+ * Wait for a posted message.
+ *
+ * The caller passes an array of objects owned by its task, and
+ * gets the first posted message found in them.  The buffer must
+ * be able to hold MSG_POSTSIZE bytes.  The index of the object
+ * is stored in the status field of the message header.
+ *
+ * The timeout value 0 means no timeout, and MSG_NOWAIT returns
+ * EAGAIN immediately if there is no message.
+ */
+int
+msg_wait(object_t *objs, int nobjs, void *msg, u_long msec)
+{
+	object_t list[MAXWAITOBJ];
+	struct postwait wait[MAXWAITOBJ];
+	object_t obj;
+	struct postq *pq = NULL;
+	struct postmsg *pm;
+	struct msg_header *hdr;
+	struct tstamp ts;
+	u_long expire = 0, left;
+	int i, rc;
+
+	if (nobjs <= 0 || nobjs > MAXWAITOBJ)
+		return EINVAL;
+	if (copyin(objs, list, sizeof(object_t) * (size_t)nobjs))
+		return EFAULT;
+	if (!user_area(msg))
+		return EFAULT;
+
+	sched_lock();
+	if (msec != 0 && msec != MSG_NOWAIT)
+		expire = timer_ticks() + mstohz(msec);
+
+	for (;;) {
+		for (i = 0; i < nobjs; i++) {
+			obj = list[i];
+			if (!object_valid(obj)) {
+				sched_unlock();
+				return EINVAL;
+			}
+			if (obj->owner != curtask) {
+				sched_unlock();
+				return EACCES;
+			}
+			pq = obj->postq;
+			if (pq != NULL && pq->count > 0)
+				break;
+		}
+		if (i < nobjs)
+			break;
+
+		left = 0;
+		if (msec == MSG_NOWAIT) {
+			sched_unlock();
+			return EAGAIN;
+		} else if (msec != 0) {
+			if (time_after_eq(timer_ticks(), expire)) {
+				sched_unlock();
+				return ETIMEDOUT;
+			}
+			left = hztoms(expire - timer_ticks());
+			if (left == 0)
+				left = 1;
+		}
+		for (i = 0; i < nobjs; i++) {
+			wait[i].thread = curthread;
+			enqueue(&list[i]->postwaitq, &wait[i].link);
+		}
+		curthread->postwait = wait;
+		curthread->npostwait = nobjs;
+		timer_stamp(&ts);
+		rc = sched_tsleep(&post_event, left);
+		timer_addtime(&curthread->ipcwait, &ts, NULL);
+		for (i = 0; i < nobjs; i++)
+			queue_remove(&wait[i].link);
+		curthread->npostwait = 0;
+		if (rc == SLP_INTR) {
+			sched_unlock();
+			return EINTR;
+		}
+	}
+
+	pm = &pq->msgs[pq->head];
+	hdr = (struct msg_header *)pm->data;
+	hdr->status = i;
+	if (copyout(pm->data, msg, pm->size)) {
+		sched_unlock();
+		return EFAULT;
+	}
+	pq->head = (pq->head + 1) % MAXPOSTQ;
+	pq->count--;
+
+	sched_unlock();
+	return 0;
+}
+
 /*
  * Cancel pending message operation of the specified thread.
  * This is called when the thread is terminated.
@@ -356,14 +830,19 @@ msg_reply(object_t obj, void *msg, size_t size)
 void
 msg_cancel(thread_t t)
 {
+	int i;
 
 	sched_lock();
 
 	if (t->sendobj != NULL) {
 		if (t->receiver != NULL)
 			t->receiver->sender = NULL;
-		else
+		else {
 			queue_remove(&t->ipc_link);
+#ifdef CONFIG_IPCSTAT
+			t->sendobj->sendqlen--;
+#endif
+		}
 	}
 	if (t->recvobj != NULL) {
 		if (t->sender != NULL) {
@@ -372,6 +851,13 @@ msg_cancel(thread_t t)
 		} else
 			queue_remove(&t->ipc_link);
 	}
+	/*
+	 * Unlink the thread waiting for posted messages.  The
+	 * links are on its kernel stack.
+	 */
+	for (i = 0; i < t->npostwait; i++)
+		queue_remove(&t->postwait[i].link);
+	t->npostwait = 0;
 	sched_unlock();
 }
 
@@ -395,6 +881,9 @@ msg_abort(object_t obj)
 		t = queue_entry(q, struct thread, ipc_link);
 		sched_unsleep(t, SLP_INVAL);
 	}
+#ifdef CONFIG_IPCSTAT
+	obj->sendqlen = 0;
+#endif
 	/*
 	 * Force wakeup all threads waiting for receive.
 	 */
@@ -403,6 +892,15 @@ msg_abort(object_t obj)
 		t = queue_entry(q, struct thread, ipc_link);
 		sched_unsleep(t, SLP_INVAL);
 	}
+	/*
+	 * Discard posted messages, and let the waiting
+	 * threads find that the object is gone.
+	 */
+	if (obj->postq != NULL) {
+		kmem_free(obj->postq);
+		obj->postq = NULL;
+	}
+	msg_postwakeup(obj, 1);
 	sched_unlock();
 }
 
@@ -436,9 +934,34 @@ msg_enqueue(queue_t head, thread_t t)
 	enqueue(head, &t->ipc_link);
 }
 
+/*
+ * Wake up the threads waiting for a posted message on the
+ * object.  If the object is going away, the waiting threads
+ * are also unlinked from it, since the object is freed before
+ * they run again.
+ */
+static void
+msg_postwakeup(object_t obj, int unlink)
+{
+	queue_t q;
+	struct postwait *pw;
+
+	q = queue_first(&obj->postwaitq);
+	while (!queue_end(&obj->postwaitq, q)) {
+		pw = queue_entry(q, struct postwait, link);
+		q = queue_next(q);
+		if (unlink)
+			queue_init(&pw->link);
+		sched_unsleep(pw->thread, SLP_SUCCESS);
+	}
+	if (unlink)
+		queue_init(&obj->postwaitq);
+}
+
 void
 msg_init(void)
 {
 
 	event_init(&ipc_event, "ipc");
+	event_init(&post_event, "ipcpost");
 }
@@ -60,12 +60,14 @@
 #include <kmem.h>
 #include <sched.h>
 #include <task.h>
+#include <timer.h>
 #include <ipc.h>
 
 /* forward declarations */
 static object_t	object_find(const char *);
 
 static struct list	object_list;	/* list of all objects */
+static struct event	object_event;	/* event for object creation */
 
 /*
  * Create a new object.
@@ -117,17 +119,26 @@ object_create(const char *name, object_t *objp)
 		sched_unlock();
 		return ENOMEM;
 	}
-	if (name != NULL)
-		strlcpy(obj->name, str, MAXOBJNAME);
+	strlcpy(obj->name, str, MAXOBJNAME);
 
 	obj->owner = curtask;
 	queue_init(&obj->sendq);
 	queue_init(&obj->recvq);
+	obj->postq = NULL;
+	queue_init(&obj->postwaitq);
+#ifdef CONFIG_IPCSTAT
+	obj->sendqlen = 0;
+	obj->stat = NULL;
+#endif
 	list_insert(&curtask->objects, &obj->task_link);
 	curtask->nobjects++;
 	list_insert(&object_list, &obj->link);
 	copyout(&obj, objp, sizeof(obj));
 
+	/* Wake up the threads waiting for a new object. */
+	if (name != NULL)
+		sched_wakeup(&object_event);
+
 	sched_unlock();
 	return 0;
 }
@@ -159,6 +170,54 @@ object_lookup(const char *name, object_t *objp)
 	return 0;
 }
 
+/*
+ * Wait until the object with the specified name is created.
+ *
+ * This is used by the boot-time tasks to wait for another
+ * server without polling.  The caller thread is blocked
+ * until the object appears or the timeout (msec) expires.
+ * The timeout value 0 means no timeout.
+ */
+int
+object_wait(const char *name, object_t *objp, u_long msec)
+{
+	object_t obj;
+	char str[MAXOBJNAME];
+	u_long expire = 0, left;
+	int error, rc;
+
+	error = copyinstr(name, str, MAXOBJNAME);
+	if (error)
+		return error;
+
+	sched_lock();
+	if (msec != 0)
+		expire = timer_ticks() + mstohz(msec);
+
+	while ((obj = object_find(str)) == NULL) {
+		left = 0;
+		if (msec != 0) {
+			if (time_after_eq(timer_ticks(), expire)) {
+				sched_unlock();
+				return ETIMEDOUT;
+			}
+			left = hztoms(expire - timer_ticks());
+			if (left == 0)
+				left = 1;
+		}
+		rc = sched_tsleep(&object_event, left);
+		if (rc == SLP_INTR) {
+			sched_unlock();
+			return EINTR;
+		}
+	}
+	sched_unlock();
+
+	if (copyout(&obj, objp, sizeof(obj)))
+		return EFAULT;
+	return 0;
+}
+
 int
 object_valid(object_t obj)
 {
@@ -200,6 +259,10 @@ object_deallocate(object_t obj)
 	obj->owner->nobjects--;
 	list_remove(&obj->task_link);
 	list_remove(&obj->link);
+#ifdef CONFIG_IPCSTAT
+	if (obj->stat != NULL)
+		kmem_free(obj->stat);
+#endif
 	kmem_free(obj);
 }
 
@@ -242,9 +305,135 @@ object_cleanup(task_t task)
 	}
 }
 
+#ifdef CONFIG_IPCSTAT
+/*
+ * Return the average of the total time in usec.
+ * The fraction of the seconds is divided digit by digit,
+ * so that it does not overflow.
+ */
+static u_long
+object_avgtime(const struct timeval *tv, u_long n)
+{
+	u_long sec, rem, frac;
+	int i;
+
+	if (n == 0)
+		return 0;
+	sec = (u_long)tv->tv_sec / n;
+	rem = (u_long)tv->tv_sec % n;
+	frac = 0;
+	for (i = 0; i < 6; i++) {
+		rem *= 10;
+		frac = frac * 10 + rem / n;
+		rem %= n;
+	}
+	return sec * 1000000 + frac + (u_long)tv->tv_usec / n;
+}
+
+/*
+ * Return the IPC statistics of an object.
+ */
+int
+object_info(struct ipcinfo *info)
+{
+	struct ipcstat *st;
+	object_t obj;
+	list_t n;
+	int i = 0;
+
+	sched_lock();
+	for (n = list_first(&object_list); n != &object_list;
+	     n = list_next(n)) {
+		if (i++ != info->cookie)
+			continue;
+		obj = list_entry(n, struct object, link);
+		memset(info, 0, sizeof(*info));
+		info->cookie = i;
+		info->id = obj;
+		info->owner = obj->owner;
+		strlcpy(info->name, obj->name, MAXOBJNAME);
+		if ((st = obj->stat) != NULL) {
+			info->nsend = st->nsend;
+			info->nrecv = st->nrecv;
+			info->nreply = st->nreply;
+			info->qmax = st->qmax;
+			info->rttavg = object_avgtime(&st->rtt, st->nreply);
+			info->rttmax = st->rttmax;
+			info->busy = st->busy;
+		}
+		sched_unlock();
+		return 0;
+	}
+	sched_unlock();
+	return ESRCH;
+}
+
+/*
+ * Return the IPC statistics of a message code of an object.
+ * Only the codes which have been replied are returned.
+ */
+int
+object_codeinfo(struct msgcodeinfo *info)
+{
+	struct ipcstat *st;
+	struct msgcode *mc;
+	int i;
+
+	if (info->cookie < 0)
+		return EINVAL;
+
+	sched_lock();
+	if (!object_valid(info->object)) {
+		sched_unlock();
+		return EINVAL;
+	}
+	if ((st = info->object->stat) == NULL) {
+		sched_unlock();
+		return ESRCH;
+	}
+	for (i = info->cookie; i <= NMSGCODE; i++) {
+		mc = (i < NMSGCODE) ? &st->codes[i] : &st->other;
+		if (mc->hist.count != 0)
+			break;
+	}
+	if (i > NMSGCODE) {
+		sched_unlock();
+		return ESRCH;
+	}
+	info->cookie = i + 1;
+	info->code = mc->code;
+	info->rttavg = object_avgtime(&mc->rtt, mc->hist.count);
+	info->hist = mc->hist;
+	sched_unlock();
+	return 0;
+}
+
+/*
+ * Reset the IPC statistics of all objects.
+ */
+void
+object_statreset(void)
+{
+	object_t obj;
+	list_t n;
+
+	sched_lock();
+	for (n = list_first(&object_list); n != &object_list;
+	     n = list_next(n)) {
+		obj = list_entry(n, struct object, link);
+		if (obj->stat != NULL) {
+			memset(obj->stat, 0, sizeof(struct ipcstat));
+			obj->stat->other.code = -1;
+		}
+	}
+	sched_unlock();
+}
+#endif /* CONFIG_IPCSTAT */
+
 void
 object_init(void)
 {
 
 	list_init(&object_list);
+	event_init(&object_event, "object");
 }
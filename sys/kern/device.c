@@ -114,6 +114,7 @@ static const dkifn_t dkient[] = {
 	/* 35 */ DKIENT(sys_nosys),
 	/* 36 */ DKIENT(sys_nosys),
 #endif
+	/* 37 */ DKIENT(bootlog_mark),
 };
 
 /* list head of the devices */
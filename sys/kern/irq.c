@@ -65,6 +65,7 @@
 #include <thread.h>
 #include <irq.h>
 #include <hal.h>
+#include <trace.h>
 
 /* forward declarations */
 static void	irq_thread(void *);
@@ -169,6 +170,14 @@ irq_thread(void *arg)
 		irq->istreq--;
 		ASSERT(irq->istreq >= 0);
 
+#ifdef CONFIG_LATSTAT
+		if (irq->istpend) {
+			timer_histadd(&irq->istlat,
+				      timer_elapsed(&irq->iststamp));
+			irq->istpend = 0;
+		}
+#endif
+
 		/*
 		 * Call IST
 		 */
@@ -201,17 +210,25 @@ irq_handler(int vector)
 
 	/* Profile */
 	irq->count++;
+	TRACE(TR_IRQ_ENTER, vector, 0);
 
 	/*
 	 * Call ISR
 	 */
 	rc = (*irq->isr)(irq->data);
+	TRACE(TR_IRQ_EXIT, vector, rc);
 
 	if (rc == INT_CONTINUE) {
 		/*
 		 * Kick IST
 		 */
 		ASSERT(irq->ist != IST_NONE);
+#ifdef CONFIG_LATSTAT
+		if (irq->istreq == 0) {
+			timer_stamp(&irq->iststamp);
+			irq->istpend = 1;
+		}
+#endif
 		irq->istreq++;
 		sched_wakeup(&irq->istevt);
 		ASSERT(irq->istreq != 0);
@@ -244,10 +261,34 @@ irq_info(struct irqinfo *info)
 	info->priority = irq->priority;
 	info->istreq = irq->istreq;
 	info->thread = irq->thread;
+#ifdef CONFIG_LATSTAT
+	info->istlat = irq->istlat;
+#else
+	memset(&info->istlat, 0, sizeof(info->istlat));
+#endif
 	info->cookie = vec + 1;
 	return 0;
 }
 
+#ifdef CONFIG_LATSTAT
+/*
+ * Reset the latency histograms of all irqs.
+ */
+void
+irq_latreset(void)
+{
+	int vec, s;
+
+	s = splhigh();
+	for (vec = 0; vec < MAXIRQS; vec++) {
+		if (irq_table[vec])
+			memset(&irq_table[vec]->istlat, 0,
+			       sizeof(struct lathist));
+	}
+	splx(s);
+}
+#endif /* CONFIG_LATSTAT */
+
 /*
  * Start interrupt processing.
  */
@@ -0,0 +1,171 @@
+/*-
+ * Copyright (c) 2009, Kohsuke Ohtani
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the author nor the names of any co-contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * lockstat.c - lock contention statistics
+ *
+ * The statistics of the scheduler lock are kept for each call
+ * site of the outermost sched_lock().  The call sites are
+ * stored in a small hash table, and the sites which do not fit
+ * in the table are counted together with the call site 0.
+ * The statistics of the mutexes are kept in each mutex.
+ */
+
+#include <kernel.h>
+#include <sched.h>
+#include <sync.h>
+#include <sys/dbgctl.h>
+#include <lockstat.h>
+
+struct locksite {
+	vaddr_t		pc;		/* call site of sched_lock() */
+	struct lockcnt	cnt;		/* counters */
+};
+
+static struct locksite	locksite[NLOCKSITE];	/* call site table */
+static struct lockcnt	lockother;	/* sites not in the table */
+
+/*
+ * Count an acquisition of the lock.
+ */
+void
+lockstat_acquire(struct lockcnt *cnt, u_long wait, int contended)
+{
+
+	cnt->count++;
+	if (contended) {
+		cnt->contended++;
+		cnt->waittime += wait;
+		if (wait > cnt->waitmax)
+			cnt->waitmax = wait;
+	}
+}
+
+/*
+ * Record the release of the outermost scheduler lock.
+ * Called with interrupts disabled.
+ */
+void
+lockstat_sched(vaddr_t pc, u_long hold, u_long wait, int contended)
+{
+	struct lockcnt *cnt = &lockother;
+	int i, n;
+
+	n = (int)(pc >> 2);
+	for (i = 0; i < NLOCKSITE; i++) {
+		n &= NLOCKSITE - 1;
+		if (locksite[n].pc == 0)
+			locksite[n].pc = pc;
+		if (locksite[n].pc == pc) {
+			cnt = &locksite[n].cnt;
+			break;
+		}
+		n++;
+	}
+	lockstat_acquire(cnt, wait, contended);
+	if (hold > cnt->holdmax)
+		cnt->holdmax = hold;
+}
+
+/*
+ * Return the statistics of the next call site.
+ */
+static int
+lockstat_siteinfo(struct lockstat *ls)
+{
+	int i, s;
+
+	s = splhigh();
+	for (i = ls->cookie; i < NLOCKSITE; i++) {
+		if (locksite[i].pc != 0) {
+			ls->id = locksite[i].pc;
+			ls->cnt = locksite[i].cnt;
+			break;
+		}
+	}
+	if (i >= NLOCKSITE) {
+		if (i > NLOCKSITE || lockother.count == 0) {
+			splx(s);
+			return ESRCH;
+		}
+		ls->id = 0;
+		ls->cnt = lockother;
+	}
+	splx(s);
+	ls->task = NULL;
+	ls->cookie = i + 1;
+	return 0;
+}
+
+/*
+ * Lock statistics control.
+ */
+int
+lockstat_control(int cmd, void *data)
+{
+	struct lockstat ls;
+	int s, error = 0;
+
+	switch (cmd) {
+	case DBGC_LOCKSTAT:
+		if (copyin(data, &ls, sizeof(ls)))
+			return EFAULT;
+		if (ls.cookie < 0)
+			return EINVAL;
+		sched_lock();
+		switch (ls.type) {
+		case LS_SCHED:
+			error = lockstat_siteinfo(&ls);
+			break;
+		case LS_MUTEX:
+			error = mutex_lockstat(&ls);
+			break;
+		default:
+			error = EINVAL;
+			break;
+		}
+		sched_unlock();
+		if (!error && copyout(&ls, data, sizeof(ls)))
+			error = EFAULT;
+		break;
+	case DBGC_LOCKRESET:
+		sched_lock();
+		s = splhigh();
+		memset(locksite, 0, sizeof(locksite));
+		memset(&lockother, 0, sizeof(lockother));
+		splx(s);
+		mutex_lockreset();
+		sched_unlock();
+		break;
+	default:
+		error = EINVAL;
+		break;
+	}
+	return error;
+}
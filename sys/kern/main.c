@@ -44,6 +44,7 @@
 #include <ipc.h>
 #include <device.h>
 #include <sync.h>
+#include <system.h>
 #include <hal.h>
 
 /*
@@ -66,6 +67,12 @@ main(void)
 	diag_init();
 	DPRINTF((BANNER));
 
+	/*
+	 * Start the boot log.
+	 */
+	bootlog_init();
+	bootlog_mark("kernel");
+
 	/*
 	 * Initialize memory managers.
 	 */
@@ -77,6 +84,7 @@ main(void)
 	 * initialization.
 	 */
 	machine_startup();
+	bootlog_mark("machdep");
 
 	/*
 	 * Initialize kernel core.
@@ -89,6 +97,7 @@ main(void)
 	timer_init();
 	object_init();
 	msg_init();
+	bootlog_mark("core");
 
 	/*
 	 * Enable interrupt and
@@ -97,11 +106,13 @@ main(void)
 	irq_init();
 	clock_init();
 	device_init();
+	bootlog_mark("device");
 
 	/*
 	 * Set up boot tasks.
 	 */
 	task_bootstrap();
+	bootlog_mark("bootstrap");
 
 	/*
 	 * Start scheduler and
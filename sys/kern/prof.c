@@ -0,0 +1,154 @@
+/*-
+ * Copyright (c) 2009, Kohsuke Ohtani
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the author nor the names of any co-contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * prof.c - statistical sampling profiler
+ *
+ * When the profiler is started, the pc interrupted by the clock
+ * interrupt is sampled with the current task and thread at each
+ * tick.  The samples are stored in a ring buffer, and they are
+ * drained by the user tool with sys_debug(DBGC_PROFREAD).  The
+ * pc is resolved to a symbol by the host tool later.
+ */
+
+#include <kernel.h>
+#include <task.h>
+#include <hal.h>
+#include <sys/dbgctl.h>
+#include <prof.h>
+
+/* Number of samples copied out at once */
+#define PROF_CHUNK	16
+
+static struct prof_sample profbuf[NPROF];	/* sample buffer */
+static u_long		prof_head;	/* index to write next */
+static u_long		prof_tail;	/* index to read next */
+static u_long		prof_lost;	/* samples lost by overflow */
+static int		prof_enabled;	/* true if profiler is running */
+
+/*
+ * Take a sample.
+ * Called from the clock interrupt with interrupts disabled.
+ */
+void
+prof_tick(vaddr_t pc)
+{
+	struct prof_sample *ps;
+
+	if (!prof_enabled)
+		return;
+
+	if (prof_head - prof_tail >= NPROF) {
+		prof_lost++;
+		return;
+	}
+	ps = &profbuf[prof_head & (NPROF - 1)];
+	prof_head++;
+	ps->pc = pc;
+	ps->task = curtask;
+	ps->thread = curthread;
+}
+
+/*
+ * Copy the samples to the user buffer.
+ */
+static int
+prof_read(struct prof_req *ureq)
+{
+	struct prof_req req;
+	struct prof_sample buf[PROF_CHUNK];
+	struct bootinfo *bi;
+	int i, n, count = 0;
+	int s;
+
+	if (copyin(ureq, &req, sizeof(req)))
+		return EFAULT;
+	if (req.count < 0)
+		return EINVAL;
+
+	s = splhigh();
+	req.lost = prof_lost;
+	prof_lost = 0;
+	splx(s);
+
+	while (count < req.count) {
+		n = req.count - count;
+		if (n > PROF_CHUNK)
+			n = PROF_CHUNK;
+		s = splhigh();
+		for (i = 0; i < n && prof_tail != prof_head; i++) {
+			buf[i] = profbuf[prof_tail & (NPROF - 1)];
+			prof_tail++;
+		}
+		splx(s);
+		if (i == 0)
+			break;
+		if (copyout(buf, req.buf + count,
+			    sizeof(struct prof_sample) * (size_t)i))
+			return EFAULT;
+		count += i;
+	}
+	req.count = count;
+
+	machine_bootinfo(&bi);
+	req.drvtext = bi->driver.text;
+
+	if (copyout(&req, ureq, sizeof(req)))
+		return EFAULT;
+	return 0;
+}
+
+/*
+ * Profiler control.
+ */
+int
+prof_control(int cmd, void *data)
+{
+	int s, error = 0;
+
+	switch (cmd) {
+	case DBGC_PROFSTART:
+		s = splhigh();
+		prof_tail = prof_head;
+		prof_lost = 0;
+		prof_enabled = 1;
+		splx(s);
+		break;
+	case DBGC_PROFSTOP:
+		prof_enabled = 0;
+		break;
+	case DBGC_PROFREAD:
+		error = prof_read(data);
+		break;
+	default:
+		error = EINVAL;
+		break;
+	}
+	return error;
+}
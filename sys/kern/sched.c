@@ -88,12 +88,18 @@
 #include <task.h>
 #include <sched.h>
 #include <hal.h>
+#include <trace.h>
+#include <lockstat.h>
 
 static struct queue	runq[NPRI];	/* run queues */
 static struct queue	wakeq;		/* queue for waking threads */
 static struct queue	dpcq;		/* DPC queue */
 static struct event	dpc_event;	/* event for DPC */
 static int		maxpri;		/* highest priority in runq */
+static int		yielding;	/* true if current thread yields */
+#ifdef CONFIG_LATSTAT
+static struct lathist	schedlat[NLATBAND]; /* wakeup latency histograms */
+#endif
 
 /*
  * Search for highest-priority runnable thread.
@@ -186,6 +192,8 @@ wakeq_flush(void)
 		t->state &= ~TS_SLEEP;
 		if (t != curthread && t->state == TS_RUN)
 			runq_enqueue(t);
+		else
+			t->waking = 0;
 	}
 }
 
@@ -200,6 +208,48 @@ sched_setrun(thread_t t)
 
 	enqueue(&wakeq, &t->sched_link);
 	timer_stop(&t->timeout);
+	timer_stamp(&t->wkstamp);
+	t->waking = 1;
+}
+
+/*
+ * Bill the running time and count the switch of the
+ * previous thread, and measure the wakeup latency of the
+ * next thread.
+ */
+static void
+sched_account(thread_t prev, thread_t next)
+{
+	u_long lat;
+
+	timer_addtime(&prev->rtime, &prev->swstamp, &prev->rcycles);
+	if (prev->state != TS_RUN || yielding)
+		prev->nvcsw++;
+	else
+		prev->nivcsw++;
+
+	timer_stamp(&next->swstamp);
+	if (next->waking) {
+		lat = timer_elapsed(&next->wkstamp);
+		next->nwakeup++;
+		next->wklat += lat;
+		if (lat > next->wklatmax)
+			next->wklatmax = lat;
+		next->waking = 0;
+#ifdef CONFIG_LATSTAT
+		timer_histadd(&schedlat[next->priority / LATBANDPRI], lat);
+#endif
+	}
+#ifdef CONFIG_LOCKSTAT
+	/*
+	 * The time sleeping with the lock held is not
+	 * billed as the lock hold time.
+	 */
+	if (prev->lockpc != 0)
+		prev->lockheld += timer_elapsed(&prev->lockstamp);
+	if (next->lockpc != 0)
+		timer_stamp(&next->lockstamp);
+#endif
 }
 
 /*
@@ -233,9 +283,14 @@ sched_swtch(void)
 	 * If it's same with previous one, return.
 	 */
 	next = runq_dequeue();
-	if (next == prev)
+	if (next == prev) {
+		yielding = 0;
 		return;
+	}
+	sched_account(prev, next);
+	yielding = 0;
 	curthread = next;
+	TRACE(TR_SWITCH, prev, next);
 
 	/*
 	 * Switch to the new thread.
@@ -398,8 +453,10 @@ sched_yield(void)
 
 	sched_lock();
 
-	if (!queue_empty(&runq[curthread->priority]))
+	if (!queue_empty(&runq[curthread->priority])) {
 		curthread->resched = 1;
+		yielding = 1;
+	}
 
 	sched_unlock();		/* Switch a current thread here */
 }
@@ -518,7 +575,43 @@ sched_lock(void)
 {
 
 	curthread->locks++;
+#ifdef CONFIG_LOCKSTAT
+	if (curthread->locks == 1) {
+		curthread->lockpc = (vaddr_t)__builtin_return_address(0);
+		curthread->lockheld = 0;
+		timer_stamp(&curthread->lockstamp);
+	}
+#endif
+}
+
+#ifdef CONFIG_LOCKSTAT
+/*
+ * Record the statistics of the outermost scheduler lock.
+ * The lock is contended if any thread switch is pending.
+ * Called with interrupts disabled.
+ */
+static void
+sched_lockstat(void)
+{
+	thread_t t;
+	u_long hold, wait = 0;
+	int contended = 0;
+
+	if (curthread->lockpc == 0)
+		return;
+	hold = curthread->lockheld + timer_elapsed(&curthread->lockstamp);
+	if (!queue_empty(&wakeq)) {
+		t = queue_entry(queue_first(&wakeq), struct thread,
+				sched_link);
+		wait = timer_elapsed(&t->wkstamp);
+		contended = 1;
+	} else if (curthread->resched)
+		contended = 1;
+
+	lockstat_sched(curthread->lockpc, hold, wait, contended);
+	curthread->lockpc = 0;
 }
+#endif
 
 /*
  * sched_unlock - unlock scheduler.
@@ -537,6 +630,9 @@ sched_unlock(void)
 
 	s = splhigh();
 	if (curthread->locks == 1) {
+#ifdef CONFIG_LOCKSTAT
+		sched_lockstat();
+#endif
 		wakeq_flush();
 		while (curthread->resched) {
 			/*
@@ -560,6 +656,41 @@ sched_unlock(void)
 	splx(s);
 }
 
+#ifdef CONFIG_LATSTAT
+/*
+ * Return the wakeup latency histogram of a priority band.
+ */
+int
+sched_latinfo(struct latinfo *info)
+{
+	int band = info->cookie;
+	int s;
+
+	if (band < 0 || band >= NLATBAND)
+		return ESRCH;
+
+	s = splhigh();
+	info->pri = band * LATBANDPRI;
+	info->lat = schedlat[band];
+	splx(s);
+	info->cookie = band + 1;
+	return 0;
+}
+
+/*
+ * Reset all wakeup latency histograms.
+ */
+void
+sched_latreset(void)
+{
+	int s;
+
+	s = splhigh();
+	memset(schedlat, 0, sizeof(schedlat));
+	splx(s);
+}
+#endif /* CONFIG_LATSTAT */
+
 /*
  * Return the priority of the specified thread.
  */
@@ -41,6 +41,7 @@
 #include <device.h>
 #include <sync.h>
 #include <system.h>
+#include <trace.h>
 
 typedef register_t (*sysfn_t)(register_t, register_t, register_t, register_t);
 
@@ -140,6 +141,19 @@ static const struct sysent sysent[] = {
 	/* 57 */ SYSENT(2, sys_info),
 	/* 58 */ SYSENT(1, sys_time),
 	/* 59 */ SYSENT(2, sys_debug),
+	/* 60 */ SYSENT(3, vm_share),
+	/* 61 */ SYSENT(3, object_wait),
+	/* 62 */ SYSENT(1, sys_bootlog),
+	/* 63 */ SYSENT(3, msg_post),
+	/* 64 */ SYSENT(4, msg_wait),
+	/* 65 */ SYSENT(3, msg_sendv),
+	/* 66 */ SYSENT(3, msg_receivev),
+	/* 67 */ SYSENT(3, msg_replyv),
+#ifdef CONFIG_TRACE
+	/* 68 */ SYSENT(2, sys_trace),
+#else
+	/* 68 */ SYSENT(0, sys_nosys),
+#endif
 };
 
 #define NSYSCALL	(int)(sizeof(sysent) / sizeof(sysent[0]))
@@ -159,11 +173,15 @@ syscall_handler(register_t a1, register_t a2, register_t a3, register_t a4,
 	strace_entry(a1, a2, a3, a4, id);
 #endif
 
+	TRACE(TR_SYSCALL, id, a1);
+
 	if (id < NSYSCALL) {
 		callp = &sysent[id];
 		retval = (*callp->sy_call)(a1, a2, a3, a4);
 	}
 
+	TRACE(TR_SYSRET, id, retval);
+
 #ifdef DEBUG
 	strace_return(retval, id);
 #endif
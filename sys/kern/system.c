@@ -37,14 +37,23 @@
 #include <task.h>
 #include <vm.h>
 #include <irq.h>
+#include <ipc.h>
 #include <page.h>
 #include <device.h>
 #include <system.h>
 #include <hal.h>
 #include <sys/dbgctl.h>
+#include <prof.h>
+#include <lockstat.h>
+
+/* forward declarations */
+static int	bootlog_info(struct bootlog *);
 
 static char	infobuf[MAXINFOSZ];	/* common information buffer */
 
+static struct bootlog	bootlog[NBOOTLOG]; /* boot log records */
+static int		nbootlog;	/* number of boot log records */
+
 static const struct kerninfo kerninfo = {
 	"Prex",	HOSTNAME, VERSION, __DATE__, MACHINE
 };
@@ -84,6 +93,22 @@ sysinfo(int type, void *buf)
 	case INFO_IRQ:
 		error = irq_info(buf);
 		break;
+	case INFO_BOOTLOG:
+		error = bootlog_info(buf);
+		break;
+#ifdef CONFIG_LATSTAT
+	case INFO_LATENCY:
+		error = sched_latinfo(buf);
+		break;
+#endif
+#ifdef CONFIG_IPCSTAT
+	case INFO_IPC:
+		error = object_info(buf);
+		break;
+	case INFO_MSGCODE:
+		error = object_codeinfo(buf);
+		break;
+#endif
 	default:
 		error = EINVAL;
 		break;
@@ -131,6 +156,22 @@ sys_info(int type, void *buf)
 	case INFO_IRQ:
 		bufsz = sizeof(struct irqinfo);
 		break;
+	case INFO_BOOTLOG:
+		bufsz = sizeof(struct bootlog);
+		break;
+#ifdef CONFIG_LATSTAT
+	case INFO_LATENCY:
+		bufsz = sizeof(struct latinfo);
+		break;
+#endif
+#ifdef CONFIG_IPCSTAT
+	case INFO_IPC:
+		bufsz = sizeof(struct ipcinfo);
+		break;
+	case INFO_MSGCODE:
+		bufsz = sizeof(struct msgcodeinfo);
+		break;
+#endif
 	default:
 		sched_unlock();
 		return EINVAL;
@@ -176,6 +217,49 @@ sys_log(const char *str)
 int
 sys_debug(int cmd, void *data)
 {
+
+#ifdef CONFIG_LATSTAT
+	if (cmd == DBGC_LATRESET) {
+		/*
+		 * The latency histograms are available without DEBUG.
+		 */
+		if (!task_capable(CAP_DIAG))
+			return EPERM;
+		sched_latreset();
+		irq_latreset();
+		return 0;
+	}
+#endif
+#ifdef CONFIG_IPCSTAT
+	if (cmd == DBGC_IPCRESET) {
+		if (!task_capable(CAP_DIAG))
+			return EPERM;
+		object_statreset();
+		return 0;
+	}
+#endif
+#ifdef CONFIG_PROFILER
+	switch (cmd) {
+	case DBGC_PROFSTART:
+	case DBGC_PROFSTOP:
+	case DBGC_PROFREAD:
+		/*
+		 * The profiler is available without DEBUG.
+		 */
+		if (!task_capable(CAP_DIAG))
+			return EPERM;
+		return prof_control(cmd, data);
+	}
+#endif
+#ifdef CONFIG_LOCKSTAT
+	switch (cmd) {
+	case DBGC_LOCKSTAT:
+	case DBGC_LOCKRESET:
+		if (!task_capable(CAP_DIAG))
+			return EPERM;
+		return lockstat_control(cmd, data);
+	}
+#endif
 #ifdef DEBUG
 	int error = EINVAL;
 	task_t task = 0;
@@ -235,6 +319,86 @@ sys_time(u_long *ticks)
 	return copyout(&t, ticks, sizeof(t));
 }
 
+/*
+ * Record the time stamp of the boot stage.
+ *
+ * The boot log is used to find where the boot time goes.
+ * The records are kept until the system is shut down, and
+ * the new records are dropped when the log is full.
+ */
+void
+bootlog_mark(const char *name)
+{
+	struct bootlog *bl;
+
+	sched_lock();
+	if (nbootlog < NBOOTLOG) {
+		bl = &bootlog[nbootlog];
+		strlcpy(bl->name, name, MAXSTAGENAME);
+		bl->cycles = machine_cycles();
+		bl->ticks = timer_ticks();
+		bl->cookie = nbootlog++;
+	}
+	sched_unlock();
+}
+
+/*
+ * System call to record the time stamp of the boot stage.
+ * This is used by the boot tasks.
+ */
+int
+sys_bootlog(const char *name)
+{
+	char str[MAXSTAGENAME];
+	int error;
+
+	if (!task_capable(CAP_PROTSERV))
+		return EPERM;
+
+	if ((error = copyinstr(name, str, MAXSTAGENAME)) != 0)
+		return error;
+
+	bootlog_mark(str);
+	return 0;
+}
+
+/*
+ * Get the boot log record.
+ */
+static int
+bootlog_info(struct bootlog *info)
+{
+	int i = info->cookie;
+
+	if (i < 0 || i >= nbootlog)
+		return ESRCH;
+
+	*info = bootlog[i];
+	info->cookie = i + 1;
+	return 0;
+}
+
+/*
+ * Initialize the boot log.
+ * The time stamps taken by the OS loader are imported first.
+ */
+void
+bootlog_init(void)
+{
+	struct bootinfo *bi;
+	struct bootlog *bl;
+	int i;
+
+	machine_bootinfo(&bi);
+	for (i = 0; i < bi->nr_stamps && i < NBOOTSTAMPS; i++) {
+		bl = &bootlog[nbootlog];
+		strlcpy(bl->name, bi->stamps[i].name, MAXSTAGENAME);
+		bl->cycles = bi->stamps[i].cycles;
+		bl->ticks = 0;
+		bl->cookie = nbootlog++;
+	}
+}
+
 /*
  * nonexistent system call.
  */
@@ -455,6 +455,7 @@ thread_deallocate(thread_t t)
 		 * was killed in previous request.
 		 */
 		ASSERT(zombie != curthread);
+		context_cleanup(&zombie->ctx);
 		kmem_free(zombie->kstack);
 		zombie->kstack = NULL;
 		kmem_free(zombie);
@@ -469,6 +470,7 @@ thread_deallocate(thread_t t)
 		return;
 	}
 
+	context_cleanup(&t->ctx);
 	kmem_free(t->kstack);
 	t->kstack = NULL;
 	kmem_free(t);
@@ -503,6 +505,13 @@ thread_info(struct threadinfo *info)
 			strlcpy(info->taskname, t->task->name, MAXTASKNAME);
 			strlcpy(info->slpevt, t->slpevt ?
 				t->slpevt->name : "-", MAXEVTNAME);
+			info->rtime = t->rtime;
+			info->nvcsw = t->nvcsw;
+			info->nivcsw = t->nivcsw;
+			info->nwakeup = t->nwakeup;
+			info->wklat = t->nwakeup ? t->wklat / t->nwakeup : 0;
+			info->wklatmax = t->wklatmax;
+			info->ipcwait = t->ipcwait;
 			sched_unlock();
 			return 0;
 		}
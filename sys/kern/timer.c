@@ -39,10 +39,20 @@
 #include <kmem.h>
 #include <exception.h>
 #include <timer.h>
+#include <trace.h>
+#include <prof.h>
+#include <hal.h>
 #include <sys/signal.h>
 
+/*
+ * Microseconds per tick.
+ */
+#define TICK_USEC	(1000000 / HZ)
+
 static volatile u_long	lbolt;		/* ticks elapsed since bootup */
 static volatile u_long	idle_ticks;	/* total ticks for idle */
+static u_long		cycles_per_usec; /* rate of cpu cycle counter */
+static u_long		tick_cycles;	/* cycle counter at last tick */
 
 static struct event	timer_event;	/* event to wakeup a timer thread */
 static struct event	delay_event;	/* event for the thread delay */
@@ -365,6 +375,7 @@ timer_thread(void *dummy)
 			tmr->state = TM_STOP;
 			sched_lock();
 			spl0();
+			TRACE(TR_TIMER, tmr->func, tmr->arg);
 			(*tmr->func)(tmr->arg);
 
 			/*
@@ -378,6 +389,29 @@ timer_thread(void *dummy)
 	/* NOTREACHED */
 }
 
+/*
+ * Calibrate the rate of the cpu cycle counter with the
+ * clock tick.  The rate is smoothed to absorb the jitter
+ * of the interrupt latency.
+ */
+static void
+timer_calibrate(void)
+{
+	u_long now, rate;
+
+	if ((now = machine_cycles()) == 0)
+		return;		/* no cycle counter */
+
+	if (tick_cycles != 0) {
+		rate = (now - tick_cycles) / TICK_USEC;
+		if (cycles_per_usec == 0)
+			cycles_per_usec = rate;
+		else
+			cycles_per_usec = (cycles_per_usec * 7 + rate) / 8;
+	}
+	tick_cycles = now;
+}
+
 /*
  * Handle clock interrupts.
  *
@@ -399,6 +433,9 @@ timer_handler(void)
 	lbolt++;
 	if (curthread->priority == PRI_IDLE)
 		idle_ticks++;
+	timer_calibrate();
+
+	prof_tick(interrupt_pc());
 
 	while (!list_empty(&timer_list)) {
 		/*
@@ -440,6 +477,88 @@ timer_ticks(void)
 	return lbolt;
 }
 
+/*
+ * Take a time stamp.
+ */
+void
+timer_stamp(struct tstamp *ts)
+{
+
+	ts->cycles = machine_cycles();
+	ts->ticks = lbolt;
+}
+
+/*
+ * Return the time elapsed since the time stamp, in usec.
+ *
+ * The cycle counter is used for an interval shorter than
+ * half a second.  Otherwise, or if the cycle counter is not
+ * available, the tick count is used since the 32-bit cycle
+ * counter may wrap around.
+ */
+u_long
+timer_elapsed(struct tstamp *ts)
+{
+	u_long ticks;
+
+	ticks = lbolt - ts->ticks;
+	if (ticks >= HZ / 2 || cycles_per_usec == 0) {
+		if (ticks >= (u_long)-1 / TICK_USEC)
+			return (u_long)-1;
+		return ticks * TICK_USEC;
+	}
+	return (machine_cycles() - ts->cycles) / cycles_per_usec;
+}
+
+/*
+ * Add the time elapsed since the time stamp to tv.
+ * If rem is not NULL, the cycles less than one usec are
+ * kept in it and carried into the next call.
+ */
+void
+timer_addtime(struct timeval *tv, struct tstamp *ts, u_long *rem)
+{
+	u_long ticks, cycles, usec;
+
+	ticks = lbolt - ts->ticks;
+	if (ticks >= HZ / 2 || cycles_per_usec == 0) {
+		tv->tv_sec += ticks / HZ;
+		usec = (ticks % HZ) * TICK_USEC;
+		if (rem != NULL)
+			*rem = 0;
+	} else {
+		cycles = machine_cycles() - ts->cycles;
+		if (rem != NULL)
+			cycles += *rem;
+		usec = cycles / cycles_per_usec;
+		if (rem != NULL)
+			*rem = cycles % cycles_per_usec;
+	}
+	tv->tv_usec += usec;
+	while (tv->tv_usec >= 1000000) {
+		tv->tv_usec -= 1000000;
+		tv->tv_sec++;
+	}
+}
+
+/*
+ * Add a latency in usec to the log2 histogram.
+ */
+void
+timer_histadd(struct lathist *hist, u_long usec)
+{
+	int n = 0;
+
+	hist->count++;
+	if (usec > hist->max)
+		hist->max = usec;
+	while (usec != 0 && n < NLATBUCKET - 1) {
+		usec >>= 1;
+		n++;
+	}
+	hist->bucket[n]++;
+}
+
 /*
  * Return timer information.
  */
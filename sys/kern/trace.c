@@ -0,0 +1,164 @@
+/*-
+ * Copyright (c) 2009, Kohsuke Ohtani
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the author nor the names of any co-contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * trace.c - kernel event trace
+ *
+ * The trace buffer is a ring of fixed size records.  It works
+ * as a flight recorder: when the buffer is full, the oldest
+ * record is overwritten and counted as lost.  The records are
+ * drained by the user tool with sys_trace(TRACE_READ).
+ *
+ * Each record is stamped with the cpu cycle counter and the
+ * timer ticks.  The events are selected by the category mask,
+ * which is tested inline by the TRACE() macro.
+ */
+
+#include <kernel.h>
+#include <task.h>
+#include <timer.h>
+#include <hal.h>
+#include <trace.h>
+
+/* Number of records copied out at once */
+#define TRACE_CHUNK	8
+
+u_long	trace_mask = TRC_DEFAULT;	/* enabled categories */
+
+static struct trace_rec	tracebuf[NTRACE];	/* trace records */
+static u_long		trace_head;	/* index to write next */
+static u_long		trace_tail;	/* index to read next */
+static u_long		trace_lost;	/* records lost by overflow */
+
+/*
+ * Record a trace event.
+ * This may be called with interrupt level.
+ */
+void
+trace_event(int type, u_long a0, u_long a1)
+{
+	struct trace_rec *tr;
+	int s;
+
+	s = splhigh();
+	if (trace_head - trace_tail >= NTRACE) {
+		trace_tail++;
+		trace_lost++;
+	}
+	tr = &tracebuf[trace_head & (NTRACE - 1)];
+	trace_head++;
+	tr->cycles = machine_cycles();
+	tr->ticks = timer_ticks();
+	tr->thread = curthread;
+	tr->type = type;
+	tr->arg[0] = a0;
+	tr->arg[1] = a1;
+	splx(s);
+}
+
+/*
+ * Copy the trace records to the user buffer.
+ * The records are copied in small chunks so that interrupts
+ * are not blocked during copyout().
+ */
+static int
+trace_read(struct trace_req *ureq)
+{
+	struct trace_req req;
+	struct trace_rec buf[TRACE_CHUNK];
+	int i, n, count = 0;
+	int s, error;
+
+	if (copyin(ureq, &req, sizeof(req)))
+		return EFAULT;
+	if (req.count < 0)
+		return EINVAL;
+
+	s = splhigh();
+	req.lost = trace_lost;
+	trace_lost = 0;
+	splx(s);
+
+	while (count < req.count) {
+		n = req.count - count;
+		if (n > TRACE_CHUNK)
+			n = TRACE_CHUNK;
+		s = splhigh();
+		for (i = 0; i < n && trace_tail != trace_head; i++) {
+			buf[i] = tracebuf[trace_tail & (NTRACE - 1)];
+			trace_tail++;
+		}
+		splx(s);
+		if (i == 0)
+			break;
+		error = copyout(buf, req.buf + count,
+				sizeof(struct trace_rec) * (size_t)i);
+		if (error)
+			return EFAULT;
+		count += i;
+	}
+	req.count = count;
+	if (copyout(&req, ureq, sizeof(req)))
+		return EFAULT;
+	return 0;
+}
+
+/*
+ * Trace control system call.
+ */
+int
+sys_trace(int cmd, void *data)
+{
+	int s, error = 0;
+
+	if (!task_capable(CAP_DIAG))
+		return EPERM;
+
+	switch (cmd) {
+	case TRACE_SETMASK:
+		trace_mask = (u_long)data & TRC_ALL;
+		break;
+	case TRACE_GETMASK:
+		error = copyout(&trace_mask, data, sizeof(trace_mask));
+		break;
+	case TRACE_READ:
+		error = trace_read(data);
+		break;
+	case TRACE_CLEAR:
+		s = splhigh();
+		trace_tail = trace_head;
+		trace_lost = 0;
+		splx(s);
+		break;
+	default:
+		error = EINVAL;
+		break;
+	}
+	return error;
+}
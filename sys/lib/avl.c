@@ -0,0 +1,191 @@
+/*-
+ * Copyright (c) 2009, Kohsuke Ohtani
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the author nor the names of any co-contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * avl.c - AVL tree library
+ */
+
+/*
+ * The AVL tree is a self-balancing binary search tree.  The
+ * heights of two child sub trees differ by at most one, so
+ * the search time is O(log n) in the worst case.
+ *
+ * The node does not have a parent link.  So, the insert and
+ * remove operations are done by the recursive calls.  Since
+ * the depth of recursion is limited to the tree height, it
+ * does not exhaust the kernel stack.
+ */
+
+#include <kernel.h>
+#include <avl.h>
+
+#define HEIGHT(n)	((n) != NULL ? (n)->height : 0)
+
+static void
+fix_height(struct avlnode *n)
+{
+	int hl, hr;
+
+	hl = HEIGHT(n->left);
+	hr = HEIGHT(n->right);
+	n->height = (hl > hr ? hl : hr) + 1;
+}
+
+static struct avlnode *
+rotate_right(struct avlnode *n)
+{
+	struct avlnode *l = n->left;
+
+	n->left = l->right;
+	l->right = n;
+	fix_height(n);
+	fix_height(l);
+	return l;
+}
+
+static struct avlnode *
+rotate_left(struct avlnode *n)
+{
+	struct avlnode *r = n->right;
+
+	n->right = r->left;
+	r->left = n;
+	fix_height(n);
+	fix_height(r);
+	return r;
+}
+
+/*
+ * Balance the sub tree and return its new root.
+ */
+static struct avlnode *
+balance(struct avlnode *n)
+{
+	int bf;
+
+	fix_height(n);
+	bf = HEIGHT(n->left) - HEIGHT(n->right);
+	if (bf > 1) {
+		if (HEIGHT(n->left->left) < HEIGHT(n->left->right))
+			n->left = rotate_left(n->left);
+		return rotate_right(n);
+	}
+	if (bf < -1) {
+		if (HEIGHT(n->right->right) < HEIGHT(n->right->left))
+			n->right = rotate_right(n->right);
+		return rotate_left(n);
+	}
+	return n;
+}
+
+static struct avlnode *
+do_insert(struct avlnode *root, struct avlnode *node, avlcmp_t cmp)
+{
+
+	if (root == NULL)
+		return node;
+	if (cmp(node, root) < 0)
+		root->left = do_insert(root->left, node, cmp);
+	else
+		root->right = do_insert(root->right, node, cmp);
+	return balance(root);
+}
+
+/*
+ * Remove the leftmost node from the sub tree.
+ */
+static struct avlnode *
+remove_min(struct avlnode *n, struct avlnode **minp)
+{
+
+	if (n->left == NULL) {
+		*minp = n;
+		return n->right;
+	}
+	n->left = remove_min(n->left, minp);
+	return balance(n);
+}
+
+static struct avlnode *
+do_remove(struct avlnode *root, struct avlnode *node, avlcmp_t cmp)
+{
+	struct avlnode *min, *right;
+
+	if (root == NULL)
+		return NULL;	/* not found */
+
+	if (root == node) {
+		if (node->right == NULL)
+			return node->left;
+		/*
+		 * Replace the node with the leftmost node
+		 * of the right sub tree.
+		 */
+		right = remove_min(node->right, &min);
+		min->left = node->left;
+		min->right = right;
+		return balance(min);
+	}
+	if (cmp(node, root) < 0)
+		root->left = do_remove(root->left, node, cmp);
+	else
+		root->right = do_remove(root->right, node, cmp);
+	return balance(root);
+}
+
+void
+avl_init(struct avltree *tree, avlcmp_t cmp)
+{
+
+	tree->root = NULL;
+	tree->cmp = cmp;
+}
+
+/*
+ * Insert the node into the tree.
+ */
+void
+avl_insert(struct avltree *tree, struct avlnode *node)
+{
+
+	node->left = node->right = NULL;
+	node->height = 1;
+	tree->root = do_insert(tree->root, node, tree->cmp);
+}
+
+/*
+ * Remove the node from the tree.
+ * The key of the node must not be changed after insertion.
+ */
+void
+avl_remove(struct avltree *tree, struct avlnode *node)
+{
+
+	tree->root = do_remove(tree->root, node, tree->cmp);
+}
@@ -86,15 +86,43 @@ strnlen(const char *str, size_t count)
 	return (size_t)(tmp - str);
 }
 
+/*
+ * Memory functions.
+ * These are not compiled if the HAL provides the optimized version
+ * by "options ASMSTRING". The aligned data is processed by word.
+ */
+#ifndef CONFIG_ASMSTRING
+
+#define WSIZE	sizeof(u_long)
+#define WMASK	(WSIZE - 1)
+
 void *
 memcpy(void *dest, const void *src, size_t count)
 {
-	char *tmp = (char *)dest, *s = (char *)src;
+	char *d = (char *)dest;
+	const char *s = (const char *)src;
 
 	ASSERT(count != 0);
 
+	if ((((vaddr_t)d | (vaddr_t)s) & WMASK) == 0) {
+		while (count >= WSIZE * 4) {
+			((u_long *)d)[0] = ((const u_long *)s)[0];
+			((u_long *)d)[1] = ((const u_long *)s)[1];
+			((u_long *)d)[2] = ((const u_long *)s)[2];
+			((u_long *)d)[3] = ((const u_long *)s)[3];
+			d += WSIZE * 4;
+			s += WSIZE * 4;
+			count -= WSIZE * 4;
+		}
+		while (count >= WSIZE) {
+			*(u_long *)d = *(const u_long *)s;
+			d += WSIZE;
+			s += WSIZE;
+			count -= WSIZE;
+		}
+	}
 	while (count--)
-		*tmp++ = *s++;
+		*d++ = *s++;
 
 	return dest;
 }
@@ -103,11 +131,49 @@ void *
 memset(void *dest, int ch, size_t count)
 {
 	char *p = (char *)dest;
+	u_long w;
 
 	ASSERT(count != 0);
 
+	/* Align the destination */
+	while (count != 0 && ((vaddr_t)p & WMASK) != 0) {
+		*p++ = (char)ch;
+		count--;
+	}
+	w = (u_long)(u_char)ch;
+	w |= w << 8;
+	w |= w << 16;
+	while (count >= WSIZE) {
+		*(u_long *)p = w;
+		p += WSIZE;
+		count -= WSIZE;
+	}
 	while (count--)
 		*p++ = (char)ch;
 
 	return dest;
 }
+
+int
+memcmp(const void *s1, const void *s2, size_t count)
+{
+	const u_char *p1 = s1, *p2 = s2;
+
+	if ((((vaddr_t)p1 | (vaddr_t)p2) & WMASK) == 0) {
+		/* Skip equal words */
+		while (count >= WSIZE &&
+		       *(const u_long *)p1 == *(const u_long *)p2) {
+			p1 += WSIZE;
+			p2 += WSIZE;
+			count -= WSIZE;
+		}
+	}
+	while (count--) {
+		if (*p1 != *p2)
+			return *p1 - *p2;
+		p1++;
+		p2++;
+	}
+	return 0;
+}
+#endif /* !CONFIG_ASMSTRING */
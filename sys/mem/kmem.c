@@ -309,15 +309,28 @@ kmem_free(void *ptr)
 /*
  * Map specified virtual address to the kernel address
  * Returns kernel address on success, or NULL if no mapped memory.
+ *
+ * The kernel address is linear, so the area must be physically
+ * contiguous. A caller which handles a buffer in a paged segment
+ * has to map it page by page.
  */
 void *
 kmem_map(void *addr, size_t size)
 {
+	vaddr_t va, start, end;
 	paddr_t pa;
 
 	pa = vm_translate((vaddr_t)addr, size);
 	if (pa == 0)
 		return NULL;
+
+	start = trunc_page((vaddr_t)addr);
+	end = trunc_page((vaddr_t)addr + size - 1);
+	for (va = start + PAGE_SIZE; va <= end && va > start;
+	     va += PAGE_SIZE) {
+		if (vm_translate(va, 1) != trunc_page(pa) + (va - start))
+			return NULL;
+	}
 	return ptokv(pa);
 }
 
@@ -48,6 +48,7 @@
 #include <page.h>
 #include <sched.h>
 #include <hal.h>
+#include <trace.h>
 
 /*
  * The page structure is put on the head of the first page of
@@ -114,6 +115,7 @@ page_alloc(psize_t psize)
 		blk->next->prev = tmp;
 	}
 	used_size += (psize_t)size;
+	TRACE(TR_PAGE_ALLOC, kvtop(blk), size);
 	sched_unlock();
 	return kvtop(blk);
 }
@@ -172,6 +174,7 @@ page_free(paddr_t paddr, psize_t psize)
 		blk->next->prev = blk->prev;
 	}
 	used_size -= (psize_t)size;
+	TRACE(TR_PAGE_FREE, paddr, size);
 	sched_unlock();
 }
 
@@ -39,9 +39,11 @@
  * is shared with old map.
  *
  * Since this kernel does not do page out to the physical storage,
- * it is guaranteed that the allocated memory is always continuing
- * and existing. Thereby, a kernel and drivers can be constructed
- * very simply.
+ * it is guaranteed that the allocated memory is always existing.
+ * The pages of a segment are normally physically continuing.
+ * Thereby, a kernel and drivers can be constructed very simply.
+ * Only when no continuous block is left for a large segment, it
+ * is backed by separate pages. (SEG_PAGED)
  */
 
 #include <kernel.h>
@@ -54,17 +56,28 @@
 #include <vm.h>
 
 /* forward declarations */
-static void	   seg_init(struct seg *);
-static struct seg *seg_create(struct seg *, vaddr_t, size_t);
+static void	   seg_init(vm_map_t);
+static int	   seg_addrcmp(const struct avlnode *, const struct avlnode *);
+static int	   seg_sizecmp(const struct avlnode *, const struct avlnode *);
+static void	   seg_index(vm_map_t, struct seg *);
+static void	   seg_resize(vm_map_t, struct seg *, size_t);
+static struct seg *seg_create(vm_map_t, struct seg *, vaddr_t, size_t);
 static void	   seg_delete(struct seg *, struct seg *);
-static struct seg *seg_lookup(struct seg *, vaddr_t, size_t);
-static struct seg *seg_alloc(struct seg *, size_t);
-static void	   seg_free(struct seg *, struct seg *);
-static struct seg *seg_reserve(struct seg *, vaddr_t, size_t);
+static struct seg *seg_lookup(vm_map_t, vaddr_t, size_t);
+static struct seg *seg_alloc(vm_map_t, size_t);
+static void	   seg_free(vm_map_t, struct seg *);
+static struct seg *seg_reserve(vm_map_t, vaddr_t, size_t);
+static int	   seg_pagealloc(struct seg *);
+static void	   seg_pagefree(struct seg *, int);
+static int	   seg_pageref(struct seg *, struct seg *, size_t);
+static int	   seg_pagemap(pgd_t, struct seg *, int);
+static void	   seg_pagecopy(struct seg *, struct seg *);
+static void	   seg_pagezero(struct seg *);
 static int	   do_allocate(vm_map_t, void **, size_t, int);
 static int	   do_free(vm_map_t, void *);
 static int	   do_attribute(vm_map_t, void *, int);
 static int	   do_map(vm_map_t, void *, size_t, void **);
+static int	   do_share(vm_map_t, vm_map_t, void *, void **);
 static vm_map_t	   do_dup(vm_map_t);
 
 
@@ -120,7 +133,6 @@ do_allocate(vm_map_t map, void **addr, size_t size, int anywhere)
 {
 	struct seg *seg;
 	vaddr_t start, end;
-	paddr_t pa;
 
 	if (size == 0)
 		return EINVAL;
@@ -132,14 +144,14 @@ do_allocate(vm_map_t map, void **addr, size_t size, int anywhere)
 	 */
 	if (anywhere) {
 		size = round_page(size);
-		if ((seg = seg_alloc(&map->head, size)) == NULL)
+		if ((seg = seg_alloc(map, size)) == NULL)
 			return ENOMEM;
 	} else {
 		start = trunc_page((vaddr_t)*addr);
 		end = round_page(start + size);
 		size = (size_t)(end - start);
 
-		if ((seg = seg_reserve(&map->head, start, size)) == NULL)
+		if ((seg = seg_reserve(map, start, size)) == NULL)
 			return ENOMEM;
 	}
 	seg->flags = SEG_READ | SEG_WRITE;
@@ -147,24 +159,22 @@ do_allocate(vm_map_t map, void **addr, size_t size, int anywhere)
 	/*
 	 * Allocate physical pages, and map them into virtual address
 	 */
-	if ((pa = page_alloc(size)) == 0)
+	if (seg_pagealloc(seg))
 		goto err1;
 
-	if (mmu_map(map->pgd, pa, seg->addr, size, PG_WRITE))
+	if (seg_pagemap(map->pgd, seg, PG_WRITE))
 		goto err2;
 
-	seg->phys = pa;
-
 	/* Zero fill */
-	memset(ptokv(pa), 0, seg->size);
+	seg_pagezero(seg);
 	*addr = (void *)seg->addr;
 	map->total += size;
 	return 0;
 
  err2:
-	page_free(pa, size);
+	seg_pagefree(seg, 1);
  err1:
-	seg_free(&map->head, seg);
+	seg_free(map, seg);
 	return ENOMEM;
 }
 
@@ -214,7 +224,7 @@ do_free(vm_map_t map, void *addr)
 	/*
 	 * Find the target segment.
 	 */
-	seg = seg_lookup(&map->head, va, 1);
+	seg = seg_lookup(map, va, 1);
 	if (seg == NULL || seg->addr != va || (seg->flags & SEG_FREE))
 		return EINVAL;
 
@@ -226,11 +236,10 @@ do_free(vm_map_t map, void *addr)
 	/*
 	 * Relinquish use of the page if it is not shared and mapped.
 	 */
-	if (!(seg->flags & SEG_SHARED) && !(seg->flags & SEG_MAPPED))
-		page_free(seg->phys, seg->size);
+	seg_pagefree(seg, !(seg->flags & (SEG_SHARED | SEG_MAPPED)));
 
 	map->total -= seg->size;
-	seg_free(&map->head, seg);
+	seg_free(map, seg);
 
 	return 0;
 }
@@ -275,9 +284,8 @@ vm_attribute(task_t task, void *addr, int attr)
 static int
 do_attribute(vm_map_t map, void *addr, int attr)
 {
-	struct seg *seg;
+	struct seg *seg, copy;
 	int new_flags, map_type;
-	paddr_t old_pa, new_pa;
 	vaddr_t va;
 
 	va = trunc_page((vaddr_t)addr);
@@ -285,7 +293,7 @@ do_attribute(vm_map_t map, void *addr, int attr)
 	/*
 	 * Find the target segment.
 	 */
-	seg = seg_lookup(&map->head, va, 1);
+	seg = seg_lookup(map, va, 1);
 	if (seg == NULL || seg->addr != va || (seg->flags & SEG_FREE)) {
 		return EINVAL;	/* not allocated */
 	}
@@ -316,22 +324,23 @@ do_attribute(vm_map_t map, void *addr, int attr)
 	 */
 	if (seg->flags & SEG_SHARED) {
 
-		old_pa = seg->phys;
-
 		/* Allocate new physical page. */
-		if ((new_pa = page_alloc(seg->size)) == 0)
+		copy = *seg;
+		if (seg_pagealloc(&copy))
 			return ENOMEM;
 
 		/* Copy source page */
-		memcpy(ptokv(new_pa), ptokv(old_pa), seg->size);
+		seg_pagecopy(&copy, seg);
 
 		/* Map new segment */
-		if (mmu_map(map->pgd, new_pa, seg->addr, seg->size,
-			    map_type)) {
-			page_free(new_pa, seg->size);
+		if (seg_pagemap(map->pgd, &copy, map_type)) {
+			seg_pagefree(&copy, 1);
 			return ENOMEM;
 		}
-		seg->phys = new_pa;
+		seg_pagefree(seg, 0);
+		seg->flags = copy.flags;
+		seg->phys = copy.phys;
+		seg->pages = copy.pages;
 
 		/* Unlink from shared list */
 		seg->sh_prev->sh_next = seg->sh_next;
@@ -340,11 +349,10 @@ do_attribute(vm_map_t map, void *addr, int attr)
 			seg->sh_prev->flags &= ~SEG_SHARED;
 		seg->sh_next = seg->sh_prev = seg;
 	} else {
-		if (mmu_map(map->pgd, seg->phys, seg->addr, seg->size,
-			    map_type))
+		if (seg_pagemap(map->pgd, seg, map_type))
 			return ENOMEM;
 	}
-	seg->flags = new_flags;
+	seg->flags = new_flags | (seg->flags & SEG_PAGED);
 	return 0;
 }
 
@@ -388,7 +396,6 @@ do_map(vm_map_t map, void *addr, size_t size, void **alloc)
 	struct seg *seg, *cur, *tgt;
 	vm_map_t curmap;
 	vaddr_t start, end;
-	paddr_t pa;
 	size_t offset;
 	int map_type;
 	void *tmp;
@@ -411,7 +418,7 @@ do_map(vm_map_t map, void *addr, size_t size, void **alloc)
 	/*
 	 * Find the segment that includes target address
 	 */
-	seg = seg_lookup(&map->head, start, size);
+	seg = seg_lookup(map, start, size);
 	if (seg == NULL || (seg->flags & SEG_FREE))
 		return EINVAL;	/* not allocated */
 	tgt = seg;
@@ -420,7 +427,7 @@ do_map(vm_map_t map, void *addr, size_t size, void **alloc)
 	 * Find the free segment in current task
 	 */
 	curmap = curtask->map;
-	if ((seg = seg_alloc(&curmap->head, size)) == NULL)
+	if ((seg = seg_alloc(curmap, size)) == NULL)
 		return ENOMEM;
 	cur = seg;
 
@@ -432,14 +439,16 @@ do_map(vm_map_t map, void *addr, size_t size, void **alloc)
 	else
 		map_type = PG_READ;
 
-	pa = tgt->phys + (paddr_t)(start - tgt->addr);
-	if (mmu_map(curmap->pgd, pa, cur->addr, size, map_type)) {
-		seg_free(&curmap->head, seg);
+	cur->flags = (tgt->flags & ~SEG_PAGED) | SEG_MAPPED;
+	if (seg_pageref(cur, tgt, (size_t)(start - tgt->addr))) {
+		seg_free(curmap, seg);
+		return ENOMEM;
+	}
+	if (seg_pagemap(curmap->pgd, cur, map_type)) {
+		seg_pagefree(cur, 0);
+		seg_free(curmap, seg);
 		return ENOMEM;
 	}
-
-	cur->flags = tgt->flags | SEG_MAPPED;
-	cur->phys = pa;
 
 	tmp = (void *)(cur->addr + offset);
 	copyout(&tmp, alloc, sizeof(tmp));
@@ -448,6 +457,106 @@ do_map(vm_map_t map, void *addr, size_t size, void **alloc)
 	return 0;
 }
 
+/**
+ * vm_share - share current task's memory with another task.
+ *
+ * The "addr" argument points to a memory segment previously
+ * allocated through a call to vm_allocate(). The whole segment
+ * is mapped into the target task with the same attribute, and
+ * the physical pages are shared by both tasks. The pages are
+ * released when the last task frees the segment. The shared
+ * segment is inherited as is by the child task at fork.
+ */
+int
+vm_share(task_t target, void *addr, void **alloc)
+{
+	int error;
+
+	sched_lock();
+	if (!task_valid(target)) {
+		sched_unlock();
+		return ESRCH;
+	}
+	if (target == curtask) {
+		sched_unlock();
+		return EINVAL;
+	}
+	if (!task_capable(CAP_EXTMEM)) {
+		sched_unlock();
+		return EPERM;
+	}
+	if (!user_area(addr)) {
+		sched_unlock();
+		return EFAULT;
+	}
+
+	error = do_share(curtask->map, target->map, addr, alloc);
+
+	sched_unlock();
+	return error;
+}
+
+static int
+do_share(vm_map_t map, vm_map_t tgtmap, void *addr, void **alloc)
+{
+	struct seg *seg, *dest;
+	int map_type;
+	void *tmp;
+
+	/* check fault */
+	tmp = NULL;
+	if (copyout(&tmp, alloc, sizeof(tmp)))
+		return EFAULT;
+
+	/*
+	 * Find the source segment.
+	 * The mapped segment can not be shared because its
+	 * pages are owned by another task.
+	 */
+	seg = seg_lookup(map, (vaddr_t)addr, 1);
+	if (seg == NULL || seg->addr != (vaddr_t)addr ||
+	    (seg->flags & (SEG_FREE | SEG_MAPPED)))
+		return EINVAL;
+
+	if (tgtmap->total + seg->size >= MAXMEM)
+		return ENOMEM;
+
+	/*
+	 * Find the free segment in target task
+	 */
+	if ((dest = seg_alloc(tgtmap, seg->size)) == NULL)
+		return ENOMEM;
+	dest->flags = (seg->flags & ~SEG_PAGED) | SEG_SHARED;
+	if (seg_pageref(dest, seg, 0)) {
+		dest->flags &= ~SEG_SHARED;
+		seg_free(tgtmap, dest);
+		return ENOMEM;
+	}
+
+	map_type = (seg->flags & SEG_WRITE) ? PG_WRITE : PG_READ;
+	if (seg_pagemap(tgtmap->pgd, dest, map_type)) {
+		seg_pagefree(dest, 0);
+		dest->flags &= ~SEG_SHARED;
+		seg_free(tgtmap, dest);
+		return ENOMEM;
+	}
+
+	/*
+	 * Link to the shared list of the source segment.
+	 */
+	seg->flags |= SEG_SHARED;
+	dest->sh_prev = seg;
+	dest->sh_next = seg->sh_next;
+	seg->sh_next->sh_prev = dest;
+	seg->sh_next = dest;
+
+	tgtmap->total += seg->size;
+
+	tmp = (void *)dest->addr;
+	copyout(&tmp, alloc, sizeof(tmp));
+	return 0;
+}
+
 /*
  * Create new virtual memory space.
  * No memory is inherited.
@@ -471,7 +580,7 @@ vm_create(void)
 		kmem_free(map);
 		return NULL;
 	}
-	seg_init(&map->head);
+	seg_init(map);
 	return map;
 }
 
@@ -496,10 +605,8 @@ vm_terminate(vm_map_t map)
 				seg->size, PG_UNMAP);
 
 			/* Free segment if it is not shared and mapped */
-			if (!(seg->flags & SEG_SHARED) &&
-			    !(seg->flags & SEG_MAPPED)) {
-				page_free(seg->phys, seg->size);
-			}
+			seg_pagefree(seg, !(seg->flags &
+					    (SEG_SHARED | SEG_MAPPED)));
 		}
 		tmp = seg;
 		seg = seg->next;
@@ -563,6 +670,9 @@ do_dup(vm_map_t org_map)
 	 */
 	*tmp = *src;
 	tmp->next = tmp->prev = tmp;
+	avl_init(&new_map->segtree, seg_addrcmp);
+	avl_init(&new_map->freetree, seg_sizecmp);
+	seg_index(new_map, tmp);
 
 	if (src == src->next)	/* Blank memory ? */
 		return new_map;
@@ -586,6 +696,7 @@ do_dup(vm_map_t org_map)
 			tmp->next->prev = dest;
 			tmp->next = dest;
 			tmp = dest;
+			seg_index(new_map, dest);
 		}
 		if (src->flags == SEG_FREE) {
 			/*
@@ -600,13 +711,16 @@ do_dup(vm_map_t org_map)
 
 			if (!(dest->flags & SEG_SHARED)) {
 				/* Allocate new physical page. */
-				dest->phys = page_alloc(src->size);
-				if (dest->phys == 0)
+				if (seg_pagealloc(dest))
 					return NULL;
 
 				/* Copy source page */
-				memcpy(ptokv(dest->phys), ptokv(src->phys),
-				       src->size);
+				seg_pagecopy(dest, src);
+			} else {
+				/* Take own list of the shared pages */
+				dest->flags &= ~SEG_PAGED;
+				if (seg_pageref(dest, src, 0))
+					return NULL;
 			}
 			/* Map the segment to virtual address */
 			if (dest->flags & SEG_WRITE)
@@ -614,8 +728,7 @@ do_dup(vm_map_t org_map)
 			else
 				map_type = PG_READ;
 
-			if (mmu_map(new_map->pgd, dest->phys, dest->addr,
-				    dest->size, map_type))
+			if (seg_pagemap(new_map->pgd, dest, map_type))
 				return NULL;
 		}
 		src = src->next;
@@ -736,6 +849,31 @@ vm_translate(vaddr_t addr, size_t size)
 	return mmu_extract(curtask->map->pgd, addr, size);
 }
 
+/*
+ * Translate a virtual address of the specified task.
+ */
+paddr_t
+vm_translate_task(task_t task, vaddr_t addr, size_t size)
+{
+
+	return mmu_extract(task->map->pgd, addr, size);
+}
+
+/*
+ * Check if the task can write the specified area.
+ * The segments shared by vm_dup() are never writable.
+ */
+int
+vm_writable(task_t task, vaddr_t addr, size_t size)
+{
+	struct seg *seg;
+
+	seg = seg_lookup(task->map, addr, size);
+	if (seg == NULL || (seg->flags & (SEG_WRITE | SEG_FREE)) != SEG_WRITE)
+		return 0;
+	return 1;
+}
+
 int
 vm_info(struct vminfo *info)
 {
@@ -782,24 +920,91 @@ vm_init(void)
 	kernel_map.pgd = pgd;
 	mmu_switch(pgd);
 
-	seg_init(&kernel_map.head);
+	seg_init(&kernel_map);
 	kernel_task.map = &kernel_map;
 }
 
 
 /*
- * Initialize segment.
+ * Compare functions for the segment trees.
+ *
+ * The address tree holds all segments of the map, and it is
+ * used to find the segment which includes an address.  The
+ * free tree holds only free segments sorted by size, and it
+ * is used to find the best-fit free segment.  The address is
+ * the second key of the free tree to make the key unique.
+ */
+static int
+seg_addrcmp(const struct avlnode *a, const struct avlnode *b)
+{
+	const struct seg *sa = avl_entry(a, struct seg, anode);
+	const struct seg *sb = avl_entry(b, struct seg, anode);
+
+	if (sa->addr == sb->addr)
+		return 0;
+	return (sa->addr < sb->addr) ? -1 : 1;
+}
+
+static int
+seg_sizecmp(const struct avlnode *a, const struct avlnode *b)
+{
+	const struct seg *sa = avl_entry(a, struct seg, fnode);
+	const struct seg *sb = avl_entry(b, struct seg, fnode);
+
+	if (sa->size != sb->size)
+		return (sa->size < sb->size) ? -1 : 1;
+	if (sa->addr == sb->addr)
+		return 0;
+	return (sa->addr < sb->addr) ? -1 : 1;
+}
+
+/*
+ * Initialize segments of the map.
  */
 static void
-seg_init(struct seg *seg)
+seg_init(vm_map_t map)
 {
+	struct seg *seg = &map->head;
 
 	seg->next = seg->prev = seg;
 	seg->sh_next = seg->sh_prev = seg;
 	seg->addr = PAGE_SIZE;
 	seg->phys = 0;
+	seg->pages = NULL;
 	seg->size = USERLIMIT - PAGE_SIZE;
 	seg->flags = SEG_FREE;
+
+	avl_init(&map->segtree, seg_addrcmp);
+	avl_init(&map->freetree, seg_sizecmp);
+	seg_index(map, seg);
+}
+
+/*
+ * Add the segment to the trees of the map.
+ */
+static void
+seg_index(vm_map_t map, struct seg *seg)
+{
+
+	avl_insert(&map->segtree, &seg->anode);
+	if (seg->flags & SEG_FREE)
+		avl_insert(&map->freetree, &seg->fnode);
+}
+
+/*
+ * Change the size of the segment.
+ * The free segment must be moved in the free tree.
+ */
+static void
+seg_resize(vm_map_t map, struct seg *seg, size_t size)
+{
+
+	if (seg->flags & SEG_FREE) {
+		avl_remove(&map->freetree, &seg->fnode);
+		seg->size = size;
+		avl_insert(&map->freetree, &seg->fnode);
+	} else
+		seg->size = size;
 }
 
 /*
@@ -807,7 +1012,7 @@ seg_init(struct seg *seg)
  * Returns segment on success, or NULL on failure.
  */
 static struct seg *
-seg_create(struct seg *prev, vaddr_t addr, size_t size)
+seg_create(vm_map_t map, struct seg *prev, vaddr_t addr, size_t size)
 {
 	struct seg *seg;
 
@@ -817,6 +1022,7 @@ seg_create(struct seg *prev, vaddr_t addr, size_t size)
 	seg->addr = addr;
 	seg->size = size;
 	seg->phys = 0;
+	seg->pages = NULL;
 	seg->flags = SEG_FREE;
 	seg->sh_next = seg->sh_prev = seg;
 
@@ -825,11 +1031,14 @@ seg_create(struct seg *prev, vaddr_t addr, size_t size)
 	prev->next->prev = seg;
 	prev->next = seg;
 
+	seg_index(map, seg);
 	return seg;
 }
 
 /*
  * Delete specified segment.
+ * This is used to discard all segments of the map.  So, the
+ * segment is not removed from the trees.
  */
 static void
 seg_delete(struct seg *head, struct seg *seg)
@@ -850,63 +1059,79 @@ seg_delete(struct seg *head, struct seg *seg)
 
 /*
  * Find the segment at the specified address.
+ *
+ * Since the segments cover whole user space without gap, the
+ * candidate is the last segment which starts at or before
+ * the address.
  */
 static struct seg *
-seg_lookup(struct seg *head, vaddr_t addr, size_t size)
+seg_lookup(vm_map_t map, vaddr_t addr, size_t size)
 {
-	struct seg *seg;
-
-	seg = head;
-	do {
-		if (seg->addr <= addr &&
-		    seg->addr + seg->size >= addr + size) {
-			return seg;
-		}
-		seg = seg->next;
-	} while (seg != head);
+	struct avlnode *n;
+	struct seg *seg, *found = NULL;
+
+	n = map->segtree.root;
+	while (n != NULL) {
+		seg = avl_entry(n, struct seg, anode);
+		if (seg->addr <= addr) {
+			found = seg;
+			n = n->right;
+		} else
+			n = n->left;
+	}
+	if (found != NULL && found->addr + found->size >= addr + size)
+		return found;
 	return NULL;
 }
 
 /*
  * Allocate free segment for specified size.
+ *
+ * The smallest free segment which can hold the size is
+ * chosen to keep the large free space.
  */
 static struct seg *
-seg_alloc(struct seg *head, size_t size)
+seg_alloc(vm_map_t map, size_t size)
 {
-	struct seg *seg;
+	struct avlnode *n;
+	struct seg *seg, *best = NULL;
+
+	n = map->freetree.root;
+	while (n != NULL) {
+		seg = avl_entry(n, struct seg, fnode);
+		if (seg->size >= size) {
+			best = seg;
+			n = n->left;
+		} else
+			n = n->right;
+	}
+	if ((seg = best) == NULL)
+		return NULL;
 
-	seg = head;
-	do {
-		if ((seg->flags & SEG_FREE) && seg->size >= size) {
-			if (seg->size != size) {
-				/*
-				 * Split this segment and return its head.
-				 */
-				if (seg_create(seg,
-					       seg->addr + size,
-					       seg->size - size) == NULL)
-					return NULL;
-			}
-			seg->size = size;
-			return seg;
-		}
-		seg = seg->next;
-	} while (seg != head);
-	return NULL;
+	if (seg->size != size) {
+		/*
+		 * Split this segment and return its head.
+		 */
+		if (seg_create(map, seg, seg->addr + size,
+			       seg->size - size) == NULL)
+			return NULL;
+	}
+	avl_remove(&map->freetree, &seg->fnode);
+	seg->size = size;
+	seg->flags = 0;
+	return seg;
 }
 
 /*
  * Delete specified free segment.
  */
 static void
-seg_free(struct seg *head, struct seg *seg)
+seg_free(vm_map_t map, struct seg *seg)
 {
 	struct seg *prev, *next;
 
 	ASSERT(seg->flags != SEG_FREE);
 
-	seg->flags = SEG_FREE;
-
 	/*
 	 * If it is shared segment, unlink from shared list.
 	 */
@@ -915,12 +1140,17 @@ seg_free(struct seg *head, struct seg *seg)
 		seg->sh_next->sh_prev = seg->sh_prev;
 		if (seg->sh_prev == seg->sh_next)
 			seg->sh_prev->flags &= ~SEG_SHARED;
+		seg->sh_next = seg->sh_prev = seg;
 	}
+	seg->flags = SEG_FREE;
+
 	/*
 	 * If next segment is free, merge with it.
 	 */
 	next = seg->next;
-	if (next != head && (next->flags & SEG_FREE)) {
+	if (next != &map->head && (next->flags & SEG_FREE)) {
+		avl_remove(&map->segtree, &next->anode);
+		avl_remove(&map->freetree, &next->fnode);
 		seg->next = next->next;
 		next->next->prev = seg;
 		seg->size += next->size;
@@ -930,19 +1160,22 @@ seg_free(struct seg *head, struct seg *seg)
 	 * If previous segment is free, merge with it.
 	 */
 	prev = seg->prev;
-	if (seg != head && (prev->flags & SEG_FREE)) {
+	if (seg != &map->head && (prev->flags & SEG_FREE)) {
+		avl_remove(&map->segtree, &seg->anode);
 		prev->next = seg->next;
 		seg->next->prev = prev;
-		prev->size += seg->size;
+		seg_resize(map, prev, prev->size + seg->size);
 		kmem_free(seg);
+		return;
 	}
+	avl_insert(&map->freetree, &seg->fnode);
 }
 
 /*
  * Reserve the segment at the specified address/size.
  */
 static struct seg *
-seg_reserve(struct seg *head, vaddr_t addr, size_t size)
+seg_reserve(vm_map_t map, vaddr_t addr, size_t size)
 {
 	struct seg *seg, *prev, *next;
 	size_t diff;
@@ -950,7 +1183,7 @@ seg_reserve(struct seg *head, vaddr_t addr, size_t size)
 	/*
 	 * Find the block which includes specified block.
 	 */
-	seg = seg_lookup(head, addr, size);
+	seg = seg_lookup(map, addr, size);
 	if (seg == NULL || !(seg->flags & SEG_FREE))
 		return NULL;
 
@@ -961,25 +1194,189 @@ seg_reserve(struct seg *head, vaddr_t addr, size_t size)
 	if (seg->addr != addr) {
 		prev = seg;
 		diff = (size_t)(addr - seg->addr);
-		seg = seg_create(prev, addr, prev->size - diff);
+		seg = seg_create(map, prev, addr, prev->size - diff);
 		if (seg == NULL)
 			return NULL;
-		prev->size = diff;
+		seg_resize(map, prev, diff);
 	}
 	/*
 	 * Check next segment to split segment.
 	 */
 	if (seg->size != size) {
-		next = seg_create(seg, seg->addr + size, seg->size - size);
+		next = seg_create(map, seg, seg->addr + size,
+				  seg->size - size);
 		if (next == NULL) {
 			if (prev) {
 				/* Undo previous seg_create() operation */
-				seg_free(head, seg);
+				avl_remove(&map->freetree, &seg->fnode);
+				seg->flags = 0;
+				seg_free(map, seg);
 			}
 			return NULL;
 		}
-		seg->size = size;
+		seg_resize(map, seg, size);
 	}
+	avl_remove(&map->freetree, &seg->fnode);
 	seg->flags = 0;
 	return seg;
 }
+
+/*
+ * Allocate physical pages for the segment.
+ *
+ * A continuous block is used if possible.  Otherwise, a large
+ * segment is backed by separate pages, and the list of its
+ * page frames is kept in one more page block.
+ */
+static int
+seg_pagealloc(struct seg *seg)
+{
+	paddr_t pa, *pages;
+	size_t i, npages;
+
+	seg->flags &= ~SEG_PAGED;
+	seg->pages = NULL;
+	if ((pa = page_alloc(seg->size)) != 0) {
+		seg->phys = pa;
+		return 0;
+	}
+	npages = seg->size / PAGE_SIZE;
+	if (npages < 2)
+		return ENOMEM;
+
+	pa = page_alloc(round_page(npages * sizeof(paddr_t)));
+	if (pa == 0)
+		return ENOMEM;
+	pages = ptokv(pa);
+	for (i = 0; i < npages; i++) {
+		if ((pages[i] = page_alloc(PAGE_SIZE)) == 0) {
+			while (i-- > 0)
+				page_free(pages[i], PAGE_SIZE);
+			page_free(pa, round_page(npages * sizeof(paddr_t)));
+			return ENOMEM;
+		}
+	}
+	seg->phys = pages[0];
+	seg->pages = pages;
+	seg->flags |= SEG_PAGED;
+	return 0;
+}
+
+/*
+ * Release the page frame list of the segment.
+ * The pages are also freed if "frames" is true.
+ */
+static void
+seg_pagefree(struct seg *seg, int frames)
+{
+	size_t i, npages;
+
+	if (!(seg->flags & SEG_PAGED)) {
+		if (frames)
+			page_free(seg->phys, seg->size);
+		return;
+	}
+	npages = seg->size / PAGE_SIZE;
+	if (frames) {
+		for (i = 0; i < npages; i++)
+			page_free(seg->pages[i], PAGE_SIZE);
+	}
+	page_free(kvtop(seg->pages), round_page(npages * sizeof(paddr_t)));
+	seg->flags &= ~SEG_PAGED;
+	seg->pages = NULL;
+}
+
+/*
+ * Make the segment refer to the pages of another segment
+ * starting at the specified offset.  A paged segment gets
+ * its own copy of the page frame list.
+ */
+static int
+seg_pageref(struct seg *seg, struct seg *src, size_t offset)
+{
+	paddr_t pa, *pages;
+	size_t i, npages;
+
+	if (!(src->flags & SEG_PAGED)) {
+		seg->phys = src->phys + (paddr_t)offset;
+		seg->pages = NULL;
+		return 0;
+	}
+	npages = seg->size / PAGE_SIZE;
+	pa = page_alloc(round_page(npages * sizeof(paddr_t)));
+	if (pa == 0)
+		return ENOMEM;
+	pages = ptokv(pa);
+	for (i = 0; i < npages; i++)
+		pages[i] = src->pages[offset / PAGE_SIZE + i];
+
+	seg->phys = pages[0];
+	seg->pages = pages;
+	seg->flags |= SEG_PAGED;
+	return 0;
+}
+
+/*
+ * Map the pages of the segment with the specified type.
+ * The physically continuing pages are mapped at once.
+ */
+static int
+seg_pagemap(pgd_t pgd, struct seg *seg, int type)
+{
+	size_t i, j, npages;
+
+	if (!(seg->flags & SEG_PAGED))
+		return mmu_map(pgd, seg->phys, seg->addr, seg->size, type);
+
+	npages = seg->size / PAGE_SIZE;
+	for (i = 0; i < npages; i = j) {
+		for (j = i + 1; j < npages; j++) {
+			if (seg->pages[j] !=
+			    seg->pages[i] + (paddr_t)((j - i) * PAGE_SIZE))
+				break;
+		}
+		if (mmu_map(pgd, seg->pages[i],
+			    seg->addr + (vaddr_t)(i * PAGE_SIZE),
+			    (j - i) * PAGE_SIZE, type))
+			return ENOMEM;
+	}
+	return 0;
+}
+
+/*
+ * Copy the contents of the segment to another segment.
+ * Both segments must have the same size.
+ */
+static void
+seg_pagecopy(struct seg *dest, struct seg *src)
+{
+	size_t i;
+
+	if (!((dest->flags | src->flags) & SEG_PAGED)) {
+		memcpy(ptokv(dest->phys), ptokv(src->phys), src->size);
+		return;
+	}
+	for (i = 0; i < src->size / PAGE_SIZE; i++) {
+		memcpy(ptokv((dest->flags & SEG_PAGED) ? dest->pages[i] :
+			     dest->phys + (paddr_t)(i * PAGE_SIZE)),
+		       ptokv((src->flags & SEG_PAGED) ? src->pages[i] :
+			     src->phys + (paddr_t)(i * PAGE_SIZE)),
+		       PAGE_SIZE);
+	}
+}
+
+/*
+ * Fill the pages of the segment with zero.
+ */
+static void
+seg_pagezero(struct seg *seg)
+{
+	size_t i;
+
+	if (!(seg->flags & SEG_PAGED)) {
+		memset(ptokv(seg->phys), 0, seg->size);
+		return;
+	}
+	for (i = 0; i < seg->size / PAGE_SIZE; i++)
+		memset(ptokv(seg->pages[i]), 0, PAGE_SIZE);
+}
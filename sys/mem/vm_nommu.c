@@ -59,6 +59,7 @@ static int	   do_allocate(vm_map_t, void **, size_t, int);
 static int	   do_free(vm_map_t, void *);
 static int	   do_attribute(vm_map_t, void *, int);
 static int	   do_map(vm_map_t, void *, size_t, void **);
+static int	   do_share(vm_map_t, vm_map_t, void *, void **);
 
 
 static struct vm_map	kernel_map;	/* vm mapping for kernel */
@@ -360,6 +361,79 @@ do_map(vm_map_t map, void *addr, size_t size, void **alloc)
 	return 0;
 }
 
+/*
+ * Share current task's memory with another task.
+ * The target task gets the same address because all tasks run
+ * in one address space.
+ */
+int
+vm_share(task_t target, void *addr, void **alloc)
+{
+	int error;
+
+	sched_lock();
+	if (!task_valid(target)) {
+		sched_unlock();
+		return ESRCH;
+	}
+	if (target == curtask) {
+		sched_unlock();
+		return EINVAL;
+	}
+	if (!task_capable(CAP_EXTMEM)) {
+		sched_unlock();
+		return EPERM;
+	}
+	if (!user_area(addr)) {
+		sched_unlock();
+		return EFAULT;
+	}
+
+	error = do_share(curtask->map, target->map, addr, alloc);
+
+	sched_unlock();
+	return error;
+}
+
+static int
+do_share(vm_map_t map, vm_map_t tgtmap, void *addr, void **alloc)
+{
+	struct seg *seg, *dest;
+	void *tmp;
+
+	/* check fault */
+	tmp = NULL;
+	if (copyout(&tmp, alloc, sizeof(tmp)))
+		return EFAULT;
+
+	seg = seg_lookup(&map->head, (vaddr_t)addr, 1);
+	if (seg == NULL || seg->addr != (vaddr_t)addr ||
+	    (seg->flags & (SEG_FREE | SEG_MAPPED)))
+		return EINVAL;
+
+	if (tgtmap->total + seg->size >= MAXMEM)
+		return ENOMEM;
+
+	/*
+	 * Create new segment to share
+	 */
+	if ((dest = seg_create(&tgtmap->head, seg->addr, seg->size)) == NULL)
+		return ENOMEM;
+	dest->flags = seg->flags | SEG_SHARED;
+	dest->phys = seg->phys;
+
+	seg->flags |= SEG_SHARED;
+	dest->sh_prev = seg;
+	dest->sh_next = seg->sh_next;
+	seg->sh_next->sh_prev = dest;
+	seg->sh_next = dest;
+
+	tgtmap->total += seg->size;
+
+	copyout(&addr, alloc, sizeof(addr));
+	return 0;
+}
+
 /*
  * Create new virtual memory space.
  * No memory is inherited.
@@ -496,6 +570,23 @@ vm_translate(vaddr_t addr, size_t size)
 	return (paddr_t)addr;
 }
 
+paddr_t
+vm_translate_task(task_t task, vaddr_t addr, size_t size)
+{
+
+	return (paddr_t)addr;
+}
+
+/*
+ * No memory is protected without MMU.
+ */
+int
+vm_writable(task_t task, vaddr_t addr, size_t size)
+{
+
+	return 1;
+}
+
 int
 vm_info(struct vminfo *info)
 {
@@ -75,6 +75,7 @@
 #include <thread.h>
 #include <task.h>
 #include <sync.h>
+#include <lockstat.h>
 
 /* forward declarations */
 static int	mutex_valid(mutex_t);
@@ -82,6 +83,11 @@ static int	mutex_copyin(mutex_t *, mutex_t *);
 static int	prio_inherit(thread_t);
 static void	prio_uninherit(thread_t);
 
+#ifdef CONFIG_LOCKSTAT
+static struct list	mutex_list = { &mutex_list, &mutex_list };
+					/* list of all mutexes */
+#endif
+
 /*
  * Initialize a mutex.
  *
@@ -115,6 +121,10 @@ mutex_init(mutex_t *mp)
 	sched_lock();
 	list_insert(&self->mutexes, &m->task_link);
 	self->nsyncs++;
+#ifdef CONFIG_LOCKSTAT
+	memset(&m->stat, 0, sizeof(m->stat));
+	list_insert(&mutex_list, &m->stat_link);
+#endif
 	sched_unlock();
 	return 0;
 }
@@ -128,6 +138,9 @@ mutex_deallocate(mutex_t m)
 
 	m->owner->nsyncs--;
 	list_remove(&m->task_link);
+#ifdef CONFIG_LOCKSTAT
+	list_remove(&m->stat_link);
+#endif
 	kmem_free(m);
 }
 
@@ -188,6 +201,11 @@ mutex_lock(mutex_t *mp)
 {
 	mutex_t m;
 	int error, rc;
+#ifdef CONFIG_LOCKSTAT
+	struct tstamp ts;
+	u_long wait = 0;
+	int contended = 0;
+#endif
 
 	sched_lock();
 	if ((error = mutex_copyin(mp, &m)) != 0) {
@@ -219,16 +237,27 @@ mutex_lock(mutex_t *mp)
 				sched_unlock();
 				return error;
 			}
+#ifdef CONFIG_LOCKSTAT
+			timer_stamp(&ts);
+#endif
 			rc = sched_sleep(&m->event);
 			curthread->mutex_waiting = NULL;
 			if (rc == SLP_INTR) {
 				sched_unlock();
 				return EINTR;
 			}
+#ifdef CONFIG_LOCKSTAT
+			wait = timer_elapsed(&ts);
+			contended = 1;
+#endif
 		}
 		m->locks = 1;
 		m->holder = curthread;
 		list_insert(&curthread->mutexes, &m->link);
+#ifdef CONFIG_LOCKSTAT
+		lockstat_acquire(&m->stat, wait, contended);
+		timer_stamp(&m->holdstamp);
+#endif
 	}
 	sched_unlock();
 	return 0;
@@ -259,6 +288,10 @@ mutex_trylock(mutex_t *mp)
 			m->locks = 1;
 			m->holder = curthread;
 			list_insert(&curthread->mutexes, &m->link);
+#ifdef CONFIG_LOCKSTAT
+			lockstat_acquire(&m->stat, 0, 0);
+			timer_stamp(&m->holdstamp);
+#endif
 		}
 	}
 	sched_unlock();
@@ -274,6 +307,9 @@ mutex_unlock(mutex_t *mp)
 {
 	mutex_t m;
 	int error;
+#ifdef CONFIG_LOCKSTAT
+	u_long hold;
+#endif
 
 	sched_lock();
 	if ((error = mutex_copyin(mp, &m)) != 0) {
@@ -286,6 +322,11 @@ mutex_unlock(mutex_t *mp)
 		return EPERM;
 	}
 	if (--m->locks == 0) {
+#ifdef CONFIG_LOCKSTAT
+		hold = timer_elapsed(&m->holdstamp);
+		if (hold > m->stat.holdmax)
+			m->stat.holdmax = hold;
+#endif
 		list_remove(&m->link);
 		prio_uninherit(curthread);
 		/*
@@ -357,6 +398,50 @@ mutex_setpri(thread_t t, int pri)
 		prio_inherit(t);
 }
 
+#ifdef CONFIG_LOCKSTAT
+/*
+ * Return the statistics of the next mutex.
+ * Called with scheduling locked.
+ */
+int
+mutex_lockstat(struct lockstat *ls)
+{
+	mutex_t m;
+	list_t n;
+	int i = 0;
+
+	for (n = list_first(&mutex_list); n != &mutex_list;
+	     n = list_next(n)) {
+		if (i++ == ls->cookie) {
+			m = list_entry(n, struct mutex, stat_link);
+			ls->id = (u_long)m;
+			ls->task = m->owner;
+			ls->cnt = m->stat;
+			ls->cookie = i;
+			return 0;
+		}
+	}
+	return ESRCH;
+}
+
+/*
+ * Reset the statistics of all mutexes.
+ * Called with scheduling locked.
+ */
+void
+mutex_lockreset(void)
+{
+	mutex_t m;
+	list_t n;
+
+	for (n = list_first(&mutex_list); n != &mutex_list;
+	     n = list_next(n)) {
+		m = list_entry(n, struct mutex, stat_link);
+		memset(&m->stat, 0, sizeof(m->stat));
+	}
+}
+#endif /* CONFIG_LOCKSTAT */
+
 /*
  * Check if the specified mutex is valid.
  */
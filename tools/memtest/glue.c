@@ -0,0 +1,453 @@
+/*-
+ * Copyright (c) 2009, Kohsuke Ohtani
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the author nor the names of any co-contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * glue.c - kernel side of the memtest driver.
+ */
+
+#include <kernel.h>
+#include <sched.h>
+#include <task.h>
+#include <page.h>
+#include <kmem.h>
+#include <vm.h>
+#include <avl.h>
+#include <sys/queue.h>
+#include <sys/list.h>
+
+#include "memtest.h"
+
+#define NNODES		64	/* nodes for the queue and list tests */
+
+extern struct task	host_task;
+
+unsigned long
+hk_pagesize(void)
+{
+
+	return PAGE_SIZE;
+}
+
+unsigned long
+hk_ramfree(void)
+{
+	struct meminfo info;
+
+	page_info(&info);
+	return info.free;
+}
+
+void *
+hk_page_alloc(unsigned long size)
+{
+	paddr_t pa;
+
+	if ((pa = page_alloc(size)) == 0)
+		return NULL;
+	return ptokv(pa);
+}
+
+void
+hk_page_free(void *addr, unsigned long size)
+{
+
+	page_free(kvtop(addr), size);
+}
+
+void *
+hk_kmem_alloc(unsigned long size)
+{
+
+	return kmem_alloc(size);
+}
+
+void
+hk_kmem_free(void *addr)
+{
+
+	kmem_free(addr);
+}
+
+/*
+ * Create the address space of the test task.
+ */
+int
+hk_vm_begin(void)
+{
+
+	sched_lock();
+	host_task.map = vm_create();
+	sched_unlock();
+	return host_task.map == NULL ? ENOMEM : 0;
+}
+
+void
+hk_vm_end(void)
+{
+
+	vm_terminate(host_task.map);
+	host_task.map = NULL;
+}
+
+int
+hk_vm_allocate(unsigned long *addr, unsigned long size, int anywhere)
+{
+	void *uaddr = (void *)*addr;
+	int error;
+
+	error = vm_allocate(&host_task, &uaddr, size, anywhere);
+	*addr = (unsigned long)uaddr;
+	return error;
+}
+
+int
+hk_vm_free(unsigned long addr)
+{
+
+	return vm_free(&host_task, (void *)addr);
+}
+
+int
+hk_vm_attribute(unsigned long addr, int writable)
+{
+
+	return vm_attribute(&host_task, (void *)addr,
+			    writable ? PROT_READ | PROT_WRITE : PROT_READ);
+}
+
+/*
+ * Duplicate the address space as fork does, and throw it away.
+ */
+int
+hk_vm_fork(void)
+{
+	vm_map_t map;
+
+	if ((map = vm_dup(host_task.map)) == NULL)
+		return ENOMEM;
+	vm_terminate(map);
+	return 0;
+}
+
+/*
+ * Check the order and the balance of the tree.  Returns the
+ * number of nodes, or -1 if the tree is broken.
+ */
+static int
+avl_check(struct avlnode *n, avlcmp_t cmp, struct avlnode *lo,
+	  struct avlnode *hi)
+{
+	int hl, hr, cl, cr;
+
+	if (n == NULL)
+		return 0;
+	if ((lo != NULL && cmp(lo, n) >= 0) ||
+	    (hi != NULL && cmp(n, hi) >= 0))
+		return -1;
+	hl = n->left != NULL ? n->left->height : 0;
+	hr = n->right != NULL ? n->right->height : 0;
+	if (n->height != (hl > hr ? hl : hr) + 1 || hl - hr > 1 ||
+	    hr - hl > 1)
+		return -1;
+	if ((cl = avl_check(n->left, cmp, lo, n)) < 0 ||
+	    (cr = avl_check(n->right, cmp, n, hi)) < 0)
+		return -1;
+	return cl + cr + 1;
+}
+
+/*
+ * Check the segments of the test task.
+ *
+ * The segments must cover the user space without gap, the
+ * free segments must be merged, and the trees must index all
+ * segments and all free segments.
+ */
+const char *
+hk_vm_check(int *nsegs, int *nfree)
+{
+	vm_map_t map = host_task.map;
+	struct seg *seg;
+	vaddr_t end;
+	int n = 0, nf = 0;
+
+	seg = &map->head;
+	end = PAGE_SIZE;
+	do {
+		if (seg->addr != end)
+			return "segments are not continuous";
+		if (seg->size == 0 || seg->size & PAGE_MASK)
+			return "bad segment size";
+		if ((seg->flags & SEG_FREE) && seg != &map->head &&
+		    (seg->prev->flags & SEG_FREE))
+			return "free segments are not merged";
+		if (seg->flags & SEG_FREE)
+			nf++;
+		n++;
+		end = seg->addr + seg->size;
+		seg = seg->next;
+	} while (seg != &map->head);
+
+	if (end != USERLIMIT)
+		return "segments do not cover the user space";
+	if (avl_check(map->segtree.root, map->segtree.cmp,
+		      NULL, NULL) != n)
+		return "broken address tree";
+	if (avl_check(map->freetree.root, map->freetree.cmp,
+		      NULL, NULL) != nf)
+		return "broken free tree";
+	*nsegs = n;
+	*nfree = nf;
+	return NULL;
+}
+
+/*
+ * Random operations on the queue and the list.
+ *
+ * The order of the nodes is kept in an array, and the linked
+ * structure is compared with it in both directions after each
+ * operation.
+ */
+struct qnode {
+	struct queue	q;
+	struct list	l;
+	int		on;		/* linked? */
+};
+
+static struct qnode	nodes[NNODES];
+static int		order[NNODES];
+static int		nlinked;
+static unsigned long	rndval;
+
+static int
+rnd(int n)
+{
+
+	rndval = rndval * 1103515245 + 12345;
+	return (int)((rndval >> 16) % (unsigned long)n);
+}
+
+static int
+pick(int on)
+{
+	int i;
+
+	i = rnd(NNODES);
+	while (nodes[i].on != on)
+		i = (i + 1) % NNODES;
+	return i;
+}
+
+static int
+order_find(int i)
+{
+	int pos;
+
+	for (pos = 0; order[pos] != i; pos++)
+		;
+	return pos;
+}
+
+static void
+order_insert(int pos, int i)
+{
+	int j;
+
+	for (j = nlinked; j > pos; j--)
+		order[j] = order[j - 1];
+	order[pos] = i;
+	nlinked++;
+	nodes[i].on = 1;
+}
+
+static void
+order_remove(int i)
+{
+	int j;
+
+	for (j = order_find(i); j < nlinked - 1; j++)
+		order[j] = order[j + 1];
+	nlinked--;
+	nodes[i].on = 0;
+}
+
+static void
+order_reset(void)
+{
+	int i;
+
+	for (i = 0; i < NNODES; i++)
+		nodes[i].on = 0;
+	nlinked = 0;
+}
+
+static const char *
+queue_verify(queue_t head)
+{
+	queue_t q;
+	int i;
+
+	q = head;
+	for (i = 0; i < nlinked; i++) {
+		q = q->next;
+		if (q != &nodes[order[i]].q)
+			return "queue: bad forward link";
+	}
+	if (q->next != head)
+		return "queue: bad forward end";
+	q = head;
+	for (i = nlinked - 1; i >= 0; i--) {
+		q = q->prev;
+		if (q != &nodes[order[i]].q)
+			return "queue: bad backward link";
+	}
+	if (q->prev != head)
+		return "queue: bad backward end";
+	return NULL;
+}
+
+const char *
+hk_queue_test(unsigned long seed, int nops)
+{
+	struct queue head;
+	const char *msg;
+	queue_t q;
+	int i, pos;
+
+	rndval = seed;
+	order_reset();
+	queue_init(&head);
+	while (nops-- > 0) {
+		switch (rnd(4)) {
+		case 0:
+			if (nlinked == NNODES)
+				break;
+			i = pick(0);
+			enqueue(&head, &nodes[i].q);
+			order_insert(nlinked, i);
+			break;
+		case 1:
+			q = dequeue(&head);
+			if (nlinked == 0) {
+				if (q != NULL)
+					return "dequeue: not empty";
+				break;
+			}
+			if (q != &nodes[order[0]].q)
+				return "dequeue: wrong node";
+			order_remove(order[0]);
+			break;
+		case 2:
+			if (nlinked == NNODES)
+				break;
+			i = pick(0);
+			if (nlinked == 0 || rnd(4) == 0) {
+				queue_insert(&head, &nodes[i].q);
+				pos = 0;
+			} else {
+				pos = order_find(pick(1));
+				queue_insert(&nodes[order[pos]].q,
+					     &nodes[i].q);
+				pos++;
+			}
+			order_insert(pos, i);
+			break;
+		case 3:
+			if (nlinked == 0)
+				break;
+			i = pick(1);
+			queue_remove(&nodes[i].q);
+			order_remove(i);
+			break;
+		}
+		if ((msg = queue_verify(&head)) != NULL)
+			return msg;
+	}
+	return NULL;
+}
+
+static const char *
+list_verify(list_t head)
+{
+	list_t n;
+	int i;
+
+	n = list_first(head);
+	for (i = 0; i < nlinked; i++, n = list_next(n)) {
+		if (list_end(head, n) ||
+		    list_entry(n, struct qnode, l) != &nodes[order[i]])
+			return "list: bad forward link";
+	}
+	if (!list_end(head, n))
+		return "list: bad forward end";
+	n = list_last(head);
+	for (i = nlinked - 1; i >= 0; i--, n = list_prev(n)) {
+		if (list_end(head, n) ||
+		    list_entry(n, struct qnode, l) != &nodes[order[i]])
+			return "list: bad backward link";
+	}
+	if (!list_end(head, n))
+		return "list: bad backward end";
+	if (list_empty(head) != (nlinked == 0))
+		return "list: bad empty state";
+	return NULL;
+}
+
+const char *
+hk_list_test(unsigned long seed, int nops)
+{
+	struct list head;
+	const char *msg;
+	int i, pos;
+
+	rndval = seed;
+	order_reset();
+	list_init(&head);
+	while (nops-- > 0) {
+		if (nlinked < NNODES && (nlinked == 0 || rnd(2) == 0)) {
+			i = pick(0);
+			if (nlinked == 0 || rnd(4) == 0) {
+				list_insert(&head, &nodes[i].l);
+				pos = 0;
+			} else {
+				pos = order_find(pick(1));
+				list_insert(&nodes[order[pos]].l,
+					    &nodes[i].l);
+				pos++;
+			}
+			order_insert(pos, i);
+		} else {
+			i = pick(1);
+			list_remove(&nodes[i].l);
+			order_remove(i);
+		}
+		if ((msg = list_verify(&head)) != NULL)
+			return msg;
+	}
+	return NULL;
+}
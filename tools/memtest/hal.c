@@ -0,0 +1,197 @@
+/*-
+ * Copyright (c) 2009, Kohsuke Ohtani
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the author nor the names of any co-contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * hal.c - stub HAL and kernel services for the host build.
+ *
+ * The physical memory is a block of the host memory, and the
+ * kernel address of a page is its host address.  The MMU is not
+ * emulated; the mapping requests always succeed.
+ */
+
+#include <kernel.h>
+#include <sched.h>
+#include <task.h>
+#include <page.h>
+#include <kmem.h>
+#include <vm.h>
+#include <hal.h>
+
+#include "memtest.h"
+
+struct thread	*curthread;
+struct task	kernel_task;
+
+struct task	host_task;		/* task running the tests */
+static struct thread host_thread;
+static struct bootinfo host_bootinfo;
+static uint32_t	host_pgd[1];		/* dummy page directory */
+static int	host_locks;		/* nest count of sched_lock() */
+
+/*
+ * Set up the memory and initialize the memory managers.
+ */
+void
+hk_init(void *ram, u_long size)
+{
+	struct physmem *mem;
+
+	mem = &host_bootinfo.ram[0];
+	mem->base = kvtop(ram);
+	mem->size = size;
+	mem->type = MT_USABLE;
+	host_bootinfo.nr_rams = 1;
+
+	host_thread.task = &host_task;
+	curthread = &host_thread;
+
+	page_init();
+	kmem_init();
+	vm_init();
+}
+
+int
+hk_locked(void)
+{
+
+	return host_locks;
+}
+
+void
+machine_bootinfo(struct bootinfo **bip)
+{
+
+	*bip = &host_bootinfo;
+}
+
+void
+machine_abort(void)
+{
+
+	host_abort(NULL, 0, "machine_abort");
+}
+
+pgd_t
+mmu_newmap(void)
+{
+
+	return host_pgd;
+}
+
+void
+mmu_terminate(pgd_t pgd)
+{
+}
+
+int
+mmu_map(pgd_t pgd, paddr_t pa, vaddr_t va, size_t size, int type)
+{
+
+	return 0;
+}
+
+void
+mmu_switch(pgd_t pgd)
+{
+}
+
+paddr_t
+mmu_extract(pgd_t pgd, vaddr_t va, size_t size)
+{
+
+	return 0;
+}
+
+int
+copyin(const void *uaddr, void *kaddr, size_t len)
+{
+
+	memcpy(kaddr, uaddr, len);
+	return 0;
+}
+
+int
+copyout(const void *kaddr, void *uaddr, size_t len)
+{
+
+	memcpy(uaddr, kaddr, len);
+	return 0;
+}
+
+void
+sched_lock(void)
+{
+
+	host_locks++;
+}
+
+void
+sched_unlock(void)
+{
+
+	if (--host_locks < 0)
+		host_abort(__FILE__, __LINE__, "sched_unlock: not locked");
+}
+
+int
+task_valid(task_t task)
+{
+
+	return task == &host_task || task == &kernel_task;
+}
+
+int
+task_capable(cap_t cap)
+{
+
+	return 1;
+}
+
+void
+panic(const char *msg)
+{
+
+	host_abort(NULL, 0, msg);
+}
+
+void
+assert(const char *file, int line, const char *exp)
+{
+
+	host_abort(file, line, exp);
+}
+
+/*
+ * The kernel is built with printf renamed to kprintf, so that
+ * the debug messages do not mix with the results.
+ */
+void
+kprintf(const char *fmt, ...)
+{
+}
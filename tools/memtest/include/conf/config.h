@@ -0,0 +1,9 @@
+/*
+ * Kernel configuration for the host build.
+ */
+#define CONFIG_MACHINE host
+#define CONFIG_PROFILE
+#define CONFIG_HZ 1000
+#define CONFIG_TIME_SLICE 50
+#define CONFIG_OPEN_MAX 16
+#define CONFIG_MMU y
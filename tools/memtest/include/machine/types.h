@@ -0,0 +1 @@
+#include <x86/types.h>
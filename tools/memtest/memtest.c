@@ -0,0 +1,689 @@
+/*-
+ * Copyright (c) 2009, Kohsuke Ohtani
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the author nor the names of any co-contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * memtest.c - host benchmark and fuzz driver for the kernel
+ * memory managers.
+ *
+ * This is a host tool.  The page allocator, the kernel memory
+ * allocator, the VM segments and the queue/list helpers are
+ * built from the kernel sources with a stub HAL, and driven by
+ * random operations.  All allocated memory is tagged, and the
+ * tags and the accounting of the allocators are checked while
+ * running.  The latency of each operation is recorded, and the
+ * fragmentation is reported at the end of each test.
+ *
+ * usage: memtest [-s seed] [-n ops] [-m ramkb] [-f runs] [-p ns]
+ *                [test ...]
+ *
+ * The tests are page, kmem, vm and queue; all are run by
+ * default.  With -f, the tests are repeated with the seeds
+ * starting from the given seed, and only the failures are
+ * reported.  With -p, a p99 latency over the given nsec is
+ * counted as a failure.
+ *
+ * The results are printed one per line as
+ *
+ *	<test> <metric> <value> <unit>
+ *
+ * and all other lines start with '#'.  The exit status is 1 if
+ * any check fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "memtest.h"
+
+#define MAXSLOTS	4096	/* max live blocks */
+#define MAXSEGS		512	/* max live segments */
+#define VMWINDOW	4096	/* pages of the fixed allocations */
+#define CHECKINT	1024	/* interval of the full checks */
+
+struct slot {
+	unsigned char	*addr;		/* kernel address */
+	unsigned long	vaddr;		/* user address of segment */
+	unsigned long	size;		/* requested size */
+	unsigned long	tag;		/* tag written to the block */
+};
+
+struct lat {
+	const char	*name;
+	unsigned long	*ns;		/* samples */
+	unsigned long	n;
+};
+
+static unsigned long	seed = 1;
+static unsigned long	nops = 200000;
+static unsigned long	ramsize = 16 * 1024 * 1024;
+static unsigned long	p99limit;
+static int		quiet;
+static int		failed;
+static const char	*curtest = "init";
+
+static unsigned char	*ram;
+static unsigned long	pagesz;
+static unsigned long long rndstate;
+static struct slot	slots[MAXSLOTS];
+static int		nlive;
+static unsigned long	nexttag;
+
+static void
+usage(void)
+{
+
+	fputs("usage: memtest [-s seed] [-n ops] [-m ramkb] [-f runs] "
+	      "[-p ns] [test ...]\n", stderr);
+	exit(1);
+}
+
+void *
+host_alloc(unsigned long size)
+{
+	void *p;
+
+	if (posix_memalign(&p, 1024 * 1024, size) != 0) {
+		fputs("memtest: out of memory\n", stderr);
+		exit(1);
+	}
+	return p;
+}
+
+void
+host_abort(const char *file, int line, const char *msg)
+{
+
+	fflush(stdout);
+	if (file != NULL)
+		fprintf(stderr, "memtest: seed %lu: %s: %s:%d: %s\n",
+			seed, curtest, file, line, msg);
+	else
+		fprintf(stderr, "memtest: seed %lu: %s: panic: %s\n",
+			seed, curtest, msg);
+	exit(1);
+}
+
+static void
+fail(const char *msg)
+{
+
+	fflush(stdout);
+	fprintf(stderr, "memtest: seed %lu: %s: %s\n", seed, curtest, msg);
+	exit(1);
+}
+
+static unsigned long
+rnd(void)
+{
+
+	rndstate ^= rndstate >> 12;
+	rndstate ^= rndstate << 25;
+	rndstate ^= rndstate >> 27;
+	return (unsigned long)((rndstate * 2685821657736338717ULL) >> 32);
+}
+
+static unsigned long
+now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long)ts.tv_sec * 1000000000UL +
+	    (unsigned long)ts.tv_nsec;
+}
+
+static void
+lat_init(struct lat *l, const char *name)
+{
+
+	l->name = name;
+	l->n = 0;
+	if ((l->ns = malloc(sizeof(unsigned long) * nops)) == NULL)
+		fail("out of memory");
+}
+
+static void
+lat_add(struct lat *l, unsigned long ns)
+{
+
+	if (l->n < nops)
+		l->ns[l->n++] = ns;
+}
+
+static int
+cmp_ulong(const void *a, const void *b)
+{
+	unsigned long x = *(const unsigned long *)a;
+	unsigned long y = *(const unsigned long *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static void
+lat_report(struct lat *l)
+{
+	static const struct {
+		const char	*name;
+		unsigned long	permil;
+	} pct[] = {
+		{ "p50", 500 }, { "p90", 900 }, { "p99", 990 },
+		{ "p999", 999 },
+	};
+	unsigned long v;
+	size_t i;
+
+	if (l->n > 0) {
+		qsort(l->ns, l->n, sizeof(unsigned long), cmp_ulong);
+		for (i = 0; i < sizeof(pct) / sizeof(pct[0]); i++) {
+			v = l->ns[l->n * pct[i].permil / 1000];
+			if (!quiet)
+				printf("%s %s_%s %lu ns\n", curtest, l->name,
+				       pct[i].name, v);
+			if (p99limit && pct[i].permil == 990 &&
+			    v > p99limit) {
+				fprintf(stderr, "memtest: seed %lu: %s: "
+					"%s p99 %lu ns over the limit\n",
+					seed, curtest, l->name, v);
+				failed = 1;
+			}
+		}
+		if (!quiet)
+			printf("%s %s_max %lu ns\n", curtest, l->name,
+			       l->ns[l->n - 1]);
+	}
+	free(l->ns);
+}
+
+static void
+report(const char *metric, unsigned long value, const char *unit)
+{
+
+	if (!quiet)
+		printf("%s %s %lu %s\n", curtest, metric, value, unit);
+}
+
+/*
+ * Tag each page of a block, or every byte of a small block.
+ */
+static void
+tag_fill(struct slot *s, int bytes)
+{
+	unsigned long off;
+
+	s->tag = ++nexttag;
+	if (bytes) {
+		memset(s->addr, (int)(s->tag & 0xff), s->size);
+		return;
+	}
+	for (off = 0; off < s->size; off += pagesz)
+		memcpy(s->addr + off, &s->tag, sizeof(s->tag));
+}
+
+static void
+tag_check(struct slot *s, int bytes)
+{
+	unsigned long off, tag;
+
+	for (off = 0; off < s->size; off += bytes ? 1 : pagesz) {
+		if (bytes) {
+			if (s->addr[off] != (unsigned char)(s->tag & 0xff))
+				fail("block is corrupted");
+		} else {
+			memcpy(&tag, s->addr + off, sizeof(tag));
+			if (tag != s->tag)
+				fail("page is corrupted");
+		}
+	}
+}
+
+static void
+check_range(unsigned char *p, unsigned long size, unsigned long align)
+{
+
+	if (p < ram || p + size > ram + ramsize)
+		fail("block is out of memory");
+	if ((unsigned long)p % align)
+		fail("block is not aligned");
+}
+
+static void
+check_unlocked(void)
+{
+
+	if (hk_locked())
+		fail("scheduler is left locked");
+}
+
+static void
+slot_remove(int i)
+{
+
+	slots[i] = slots[--nlive];
+}
+
+/*
+ * Find the largest block which can be allocated now.
+ */
+static unsigned long
+largest_block(void)
+{
+	unsigned long lo = 0, hi, mid;
+	void *p;
+
+	hi = hk_ramfree() / pagesz;
+	while (lo < hi) {
+		mid = (lo + hi + 1) / 2;
+		if ((p = hk_page_alloc(mid * pagesz)) != NULL) {
+			hk_page_free(p, mid * pagesz);
+			lo = mid;
+		} else
+			hi = mid - 1;
+	}
+	return lo * pagesz;
+}
+
+static void
+report_frag(void)
+{
+	unsigned long ramfree, largest;
+
+	ramfree = hk_ramfree();
+	largest = largest_block();
+	report("free", ramfree / 1024, "KB");
+	report("largest", largest / 1024, "KB");
+	report("frag", ramfree ? 100 - largest * 100 / ramfree : 0, "%");
+}
+
+/*
+ * Size of a page block in pages: mostly small, sometimes large.
+ */
+static unsigned long
+rnd_pages(void)
+{
+	unsigned long r = rnd() % 100;
+
+	if (r < 70)
+		return 1 + rnd() % 4;
+	if (r < 95)
+		return 5 + rnd() % 60;
+	return 65 + rnd() % 192;
+}
+
+/*
+ * Size of a kmem block.  kmem_alloc() panics for a block near
+ * a page, so the size stays well below it.
+ */
+static unsigned long
+rnd_bytes(void)
+{
+	unsigned long edge[] = { 1, 15, 16, 17, 31, 32, 33, 64, 0, 0 };
+	unsigned long kmax, r;
+
+	kmax = pagesz - 128;
+	edge[8] = pagesz / 2;
+	edge[9] = kmax;
+	r = rnd() % 100;
+	if (r < 5)
+		return edge[rnd() % 10];
+	if (r < 60)
+		return 1 + rnd() % 128;
+	if (r < 90)
+		return 129 + rnd() % 896;
+	return 1025 + rnd() % (kmax - 1024);
+}
+
+static void
+test_page(void)
+{
+	struct lat la, lf;
+	unsigned long base, live = 0, size, t, op;
+	struct slot *s;
+	int i;
+
+	lat_init(&la, "alloc");
+	lat_init(&lf, "free");
+	base = hk_ramfree();
+	for (op = 0; op < nops; op++) {
+		if (nlive < MAXSLOTS && (nlive == 0 || rnd() % 100 < 55)) {
+			size = rnd_pages() * pagesz;
+			if (rnd() % 4 == 0)
+				size -= rnd() % pagesz;
+			t = now();
+			s = &slots[nlive];
+			s->addr = hk_page_alloc(size);
+			lat_add(&la, now() - t);
+			if (s->addr != NULL) {
+				s->size = (size + pagesz - 1) & ~(pagesz - 1);
+				check_range(s->addr, s->size, pagesz);
+				tag_fill(s, 0);
+				live += s->size;
+				nlive++;
+			}
+		} else {
+			i = (int)(rnd() % (unsigned long)nlive);
+			s = &slots[i];
+			tag_check(s, 0);
+			t = now();
+			hk_page_free(s->addr, s->size);
+			lat_add(&lf, now() - t);
+			live -= s->size;
+			slot_remove(i);
+		}
+		check_unlocked();
+		if (op % CHECKINT == 0 && hk_ramfree() != base - live)
+			fail("free size is wrong");
+	}
+	lat_report(&la);
+	lat_report(&lf);
+	report("live", live / 1024, "KB");
+	report_frag();
+
+	while (nlive > 0) {
+		tag_check(&slots[0], 0);
+		hk_page_free(slots[0].addr, slots[0].size);
+		slot_remove(0);
+	}
+	if (hk_ramfree() != base)
+		fail("pages are leaked");
+	if (largest_block() != base)
+		fail("free pages are not merged");
+}
+
+static void
+test_kmem(void)
+{
+	struct lat la, lf;
+	unsigned long base, live = 0, used, t, op;
+	struct slot *s;
+	int i;
+
+	lat_init(&la, "alloc");
+	lat_init(&lf, "free");
+	base = hk_ramfree();
+	for (op = 0; op < nops; op++) {
+		if (nlive < MAXSLOTS && (nlive == 0 || rnd() % 100 < 55)) {
+			s = &slots[nlive];
+			s->size = rnd_bytes();
+			t = now();
+			s->addr = hk_kmem_alloc(s->size);
+			lat_add(&la, now() - t);
+			if (s->addr != NULL) {
+				check_range(s->addr, s->size, sizeof(void *));
+				tag_fill(s, 1);
+				live += s->size;
+				nlive++;
+			}
+		} else {
+			i = (int)(rnd() % (unsigned long)nlive);
+			s = &slots[i];
+			tag_check(s, 1);
+			t = now();
+			hk_kmem_free(s->addr);
+			lat_add(&lf, now() - t);
+			live -= s->size;
+			slot_remove(i);
+		}
+		check_unlocked();
+	}
+	lat_report(&la);
+	lat_report(&lf);
+
+	/*
+	 * Utilization is the requested bytes per the bytes of
+	 * the pages used by the allocator.
+	 */
+	used = base - hk_ramfree();
+	report("live", live / 1024, "KB");
+	report("pages", used / pagesz, "pages");
+	report("util", used ? live * 100 / used : 100, "%");
+	report_frag();
+
+	while (nlive > 0) {
+		tag_check(&slots[0], 1);
+		hk_kmem_free(slots[0].addr);
+		slot_remove(0);
+	}
+	if (hk_ramfree() != base)
+		fail("pages are leaked");
+}
+
+static int
+seg_overlap(unsigned long addr, unsigned long size)
+{
+	int i;
+
+	for (i = 0; i < nlive; i++) {
+		if (addr < slots[i].vaddr + slots[i].size &&
+		    slots[i].vaddr < addr + size)
+			return 1;
+	}
+	return 0;
+}
+
+static void
+vm_check(int *nsegs, int *nfree)
+{
+	const char *msg;
+
+	if ((msg = hk_vm_check(nsegs, nfree)) != NULL)
+		fail(msg);
+}
+
+static void
+test_vm(void)
+{
+	struct lat la, lf;
+	unsigned long base, before, addr, size, t, op, r;
+	int i, error, anywhere, nsegs, nfree;
+
+	lat_init(&la, "allocate");
+	lat_init(&lf, "free");
+	base = hk_ramfree();
+	if (hk_vm_begin() != 0)
+		fail("vm_create failed");
+	for (op = 0; op < nops; op++) {
+		r = rnd() % 1000;
+		if (nlive == 0 || (nlive < MAXSEGS && r < 600)) {
+			/*
+			 * Allocate at any address or at the fixed
+			 * address in a small window.
+			 */
+			anywhere = r < 450;
+			size = rnd_pages() * pagesz - rnd() % pagesz;
+			addr = anywhere ? 0 : pagesz * (1 + rnd() % VMWINDOW);
+			t = now();
+			error = hk_vm_allocate(&addr, size, anywhere);
+			lat_add(&la, now() - t);
+			if (error == 0) {
+				size = (size + pagesz - 1) & ~(pagesz - 1);
+				if (addr % pagesz)
+					fail("segment is not aligned");
+				if (seg_overlap(addr, size))
+					fail("segments overlap");
+				slots[nlive].vaddr = addr;
+				slots[nlive].size = size;
+				nlive++;
+			}
+		} else if (r < 930) {
+			i = (int)(rnd() % (unsigned long)nlive);
+			t = now();
+			error = hk_vm_free(slots[i].vaddr);
+			lat_add(&lf, now() - t);
+			if (error)
+				fail("vm_free failed");
+			slot_remove(i);
+		} else if (r < 960) {
+			/*
+			 * Free the address which is not allocated.
+			 */
+			addr = pagesz * (1 + rnd() % VMWINDOW);
+			for (i = 0; i < nlive; i++) {
+				if (slots[i].vaddr == addr)
+					break;
+			}
+			if (i == nlive && hk_vm_free(addr) == 0)
+				fail("vm_free succeeded for bad address");
+		} else if (r < 998) {
+			i = (int)(rnd() % (unsigned long)nlive);
+			if (hk_vm_attribute(slots[i].vaddr, (int)(rnd() & 1)))
+				fail("vm_attribute failed");
+		} else {
+			before = hk_ramfree();
+			if (hk_vm_fork() == 0 && hk_ramfree() != before)
+				fail("vm_dup leaked pages");
+		}
+		check_unlocked();
+		if (op % CHECKINT == 0)
+			vm_check(&nsegs, &nfree);
+	}
+	lat_report(&la);
+	lat_report(&lf);
+	vm_check(&nsegs, &nfree);
+	report("segs", (unsigned long)nsegs, "segs");
+	report("freesegs", (unsigned long)nfree, "segs");
+	report_frag();
+
+	while (nlive > 0) {
+		if (hk_vm_free(slots[0].vaddr))
+			fail("vm_free failed");
+		slot_remove(0);
+	}
+	vm_check(&nsegs, &nfree);
+	if (nsegs != 1)
+		fail("free segments are not merged");
+	hk_vm_end();
+	if (hk_ramfree() != base)
+		fail("pages are leaked");
+}
+
+static void
+test_queue(void)
+{
+	const char *msg;
+
+	if ((msg = hk_queue_test(seed, (int)nops)) != NULL)
+		fail(msg);
+	report("queue_ops", nops, "ops");
+	if ((msg = hk_list_test(seed, (int)nops)) != NULL)
+		fail(msg);
+	report("list_ops", nops, "ops");
+}
+
+static const struct {
+	const char	*name;
+	void		(*func)(void);
+} testtab[] = {
+	{ "page",	test_page },
+	{ "kmem",	test_kmem },
+	{ "vm",		test_vm },
+	{ "queue",	test_queue },
+};
+
+#define NTESTS	(int)(sizeof(testtab) / sizeof(testtab[0]))
+
+static void
+run(int argc, char *argv[])
+{
+	int i, j;
+
+	for (i = 0; i < NTESTS; i++) {
+		if (argc > 0) {
+			for (j = 0; j < argc; j++) {
+				if (!strcmp(argv[j], testtab[i].name))
+					break;
+			}
+			if (j == argc)
+				continue;
+		}
+		curtest = testtab[i].name;
+		rndstate = seed * 0x9e3779b97f4a7c15ULL + (unsigned)i + 1;
+		testtab[i].func();
+	}
+}
+
+int
+main(int argc, char *argv[])
+{
+	unsigned long runs = 0, r;
+	int ch, i;
+
+	while ((ch = getopt(argc, argv, "s:n:m:f:p:")) != -1) {
+		switch (ch) {
+		case 's':
+			seed = strtoul(optarg, NULL, 0);
+			break;
+		case 'n':
+			nops = strtoul(optarg, NULL, 0);
+			break;
+		case 'm':
+			ramsize = strtoul(optarg, NULL, 0) * 1024;
+			break;
+		case 'f':
+			runs = strtoul(optarg, NULL, 0);
+			break;
+		case 'p':
+			p99limit = strtoul(optarg, NULL, 0);
+			break;
+		default:
+			usage();
+		}
+	}
+	argc -= optind;
+	argv += optind;
+	for (i = 0; i < argc; i++) {
+		for (ch = 0; ch < NTESTS; ch++) {
+			if (!strcmp(argv[i], testtab[ch].name))
+				break;
+		}
+		if (ch == NTESTS)
+			usage();
+	}
+	if (nops == 0 || ramsize < 1024 * 1024)
+		usage();
+
+	ram = host_alloc(ramsize);
+	hk_init(ram, ramsize);
+	pagesz = hk_pagesize();
+
+	if (runs > 0) {
+		quiet = 1;
+		for (r = 0; r < runs; r++, seed++)
+			run(argc, argv);
+		printf("# %lu runs ok\n", runs);
+		return failed;
+	}
+	printf("# memtest seed %lu ops %lu ram %lu KB page %lu\n",
+	       seed, nops, ramsize / 1024, pagesz);
+	printf("# test metric value unit\n");
+	run(argc, argv);
+	return failed;
+}
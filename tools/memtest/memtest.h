@@ -0,0 +1,72 @@
+/*-
+ * Copyright (c) 2009, Kohsuke Ohtani
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the author nor the names of any co-contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * memtest.h - interface between the memtest driver and the kernel.
+ *
+ * The kernel modules are built without the host headers, so
+ * only the basic C types are used here.
+ */
+
+#ifndef _MEMTEST_H
+#define _MEMTEST_H
+
+/*
+ * Provided by the driver
+ */
+void	*host_alloc(unsigned long size);
+void	 host_abort(const char *file, int line, const char *msg);
+
+/*
+ * Provided by the kernel side
+ */
+void	 hk_init(void *ram, unsigned long size);
+unsigned long hk_pagesize(void);
+unsigned long hk_ramfree(void);
+int	 hk_locked(void);
+
+void	*hk_page_alloc(unsigned long size);
+void	 hk_page_free(void *addr, unsigned long size);
+
+void	*hk_kmem_alloc(unsigned long size);
+void	 hk_kmem_free(void *addr);
+
+int	 hk_vm_begin(void);
+void	 hk_vm_end(void);
+int	 hk_vm_allocate(unsigned long *addr, unsigned long size,
+			int anywhere);
+int	 hk_vm_free(unsigned long addr);
+int	 hk_vm_attribute(unsigned long addr, int writable);
+int	 hk_vm_fork(void);
+const char *hk_vm_check(int *nsegs, int *nfree);
+
+const char *hk_queue_test(unsigned long seed, int nops);
+const char *hk_list_test(unsigned long seed, int nops);
+
+#endif /* !_MEMTEST_H */
@@ -0,0 +1,417 @@
+/*-
+ * Copyright (c) 2009, Kohsuke Ohtani
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the author nor the names of any co-contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * profsym.c - resolve the samples of the prof command to symbols.
+ *
+ * This is a host tool.  It reads the output of the prof command
+ * and the ELF files that have the symbol tables, and prints the
+ * number of samples for each function.
+ *
+ * usage: profsym [-n lines] profile kernel driver [name=file ...]
+ *
+ * "kernel" and "driver" are the unstripped images of the kernel
+ * and the driver module.  The image of each task is given as
+ * "name=file", where name is the task name shown by ps.  If the
+ * name is omitted, the base name of the file is used.
+ *
+ * The kernel and the tasks must be linked at the address where
+ * they run.  The driver is relocated to the address reported by
+ * the kernel.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#define EI_NIDENT	16
+#define ELFDATA2MSB	2
+#define SHT_SYMTAB	2
+#define SHF_EXECINSTR	0x4
+#define STT_NOTYPE	0
+#define STT_FUNC	2
+#define SHN_UNDEF	0
+#define SHN_LORESERVE	0xff00
+
+#define MAXIMAGES	32
+#define MAXTASKS	256
+#define MAXNAME		32
+
+struct sym {
+	uint32_t	addr;
+	const char	*name;
+};
+
+struct image {
+	char		name[MAXNAME];	/* image name */
+	struct sym	*syms;		/* symbols sorted by address */
+	int		nsyms;
+	uint32_t	lo, hi;		/* text range */
+	uint32_t	offset;		/* load offset */
+};
+
+struct task {
+	uint32_t	id;
+	char		name[MAXNAME];
+};
+
+struct entry {
+	const struct image *img;
+	const char	*sym;
+	const char	*task;
+	unsigned long	count;
+};
+
+static struct image	images[MAXIMAGES];
+static int		nimages;
+static struct task	tasks[MAXTASKS];
+static int		ntasks;
+static struct entry	*entries;
+static int		nentries;
+static int		maxentries;
+
+static int		big_endian;
+
+static uint16_t
+get16(const unsigned char *p)
+{
+
+	if (big_endian)
+		return (uint16_t)((p[0] << 8) | p[1]);
+	return (uint16_t)((p[1] << 8) | p[0]);
+}
+
+static uint32_t
+get32(const unsigned char *p)
+{
+
+	if (big_endian)
+		return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+		    ((uint32_t)p[2] << 8) | p[3];
+	return ((uint32_t)p[3] << 24) | ((uint32_t)p[2] << 16) |
+	    ((uint32_t)p[1] << 8) | p[0];
+}
+
+static void *
+xmalloc(size_t size)
+{
+	void *p;
+
+	if ((p = malloc(size)) == NULL) {
+		fputs("profsym: out of memory\n", stderr);
+		exit(1);
+	}
+	return p;
+}
+
+static int
+symcmp(const void *a, const void *b)
+{
+	const struct sym *s1 = a, *s2 = b;
+
+	if (s1->addr < s2->addr)
+		return -1;
+	return s1->addr > s2->addr;
+}
+
+/*
+ * Load the text range and the function symbols of an ELF file.
+ */
+static void
+load_image(const char *name, const char *path)
+{
+	struct image *img;
+	unsigned char *buf, *sh, *sym;
+	const char *strtab;
+	uint32_t shoff, addr, size, flags;
+	uint16_t shentsize, shnum, shndx;
+	long len;
+	FILE *fp;
+	int i, j, n, type;
+
+	if (nimages >= MAXIMAGES) {
+		fputs("profsym: too many images\n", stderr);
+		exit(1);
+	}
+	if ((fp = fopen(path, "rb")) == NULL) {
+		perror(path);
+		exit(1);
+	}
+	fseek(fp, 0, SEEK_END);
+	len = ftell(fp);
+	rewind(fp);
+	buf = xmalloc((size_t)len);
+	if (fread(buf, 1, (size_t)len, fp) != (size_t)len) {
+		perror(path);
+		exit(1);
+	}
+	fclose(fp);
+
+	if (len < 52 || memcmp(buf, "\177ELF", 4) != 0 || buf[4] != 1) {
+		fprintf(stderr, "profsym: %s: not an ELF32 file\n", path);
+		exit(1);
+	}
+	big_endian = (buf[5] == ELFDATA2MSB);
+
+	img = &images[nimages++];
+	strncpy(img->name, name, MAXNAME - 1);
+	img->lo = 0xffffffff;
+	img->hi = 0;
+
+	shoff = get32(buf + 32);
+	shentsize = get16(buf + 46);
+	shnum = get16(buf + 48);
+
+	/* Find the text range. */
+	for (i = 0; i < shnum; i++) {
+		sh = buf + shoff + i * shentsize;
+		flags = get32(sh + 8);
+		addr = get32(sh + 12);
+		size = get32(sh + 20);
+		if (!(flags & SHF_EXECINSTR) || size == 0)
+			continue;
+		if (addr < img->lo)
+			img->lo = addr;
+		if (addr + size > img->hi)
+			img->hi = addr + size;
+	}
+
+	/* Load the symbols. */
+	for (i = 0; i < shnum; i++) {
+		sh = buf + shoff + i * shentsize;
+		if (get32(sh + 4) != SHT_SYMTAB)
+			continue;
+		strtab = (const char *)buf +
+		    get32(buf + shoff + get32(sh + 24) * shentsize + 16);
+		n = (int)(get32(sh + 20) / 16);
+		img->syms = xmalloc(sizeof(struct sym) * (size_t)n);
+		for (j = 0; j < n; j++) {
+			sym = buf + get32(sh + 16) + j * 16;
+			type = sym[12] & 0xf;
+			shndx = get16(sym + 14);
+			if (type != STT_FUNC && type != STT_NOTYPE)
+				continue;
+			if (shndx == SHN_UNDEF || shndx >= SHN_LORESERVE)
+				continue;
+			if (strtab[get32(sym)] == '\0' ||
+			    strtab[get32(sym)] == '$' ||
+			    strtab[get32(sym)] == '.')
+				continue;
+			img->syms[img->nsyms].addr = get32(sym + 4);
+			img->syms[img->nsyms].name = strtab + get32(sym);
+			img->nsyms++;
+		}
+		break;
+	}
+	if (img->nsyms == 0)
+		fprintf(stderr, "profsym: %s: no symbols\n", path);
+	qsort(img->syms, (size_t)img->nsyms, sizeof(struct sym), symcmp);
+}
+
+static const char *
+lookup_sym(const struct image *img, uint32_t pc)
+{
+	int lo, hi, mid;
+
+	pc -= img->offset;
+	lo = 0;
+	hi = img->nsyms - 1;
+	if (hi < 0 || pc < img->syms[0].addr)
+		return "?";
+	while (lo < hi) {
+		mid = (lo + hi + 1) / 2;
+		if (img->syms[mid].addr <= pc)
+			lo = mid;
+		else
+			hi = mid - 1;
+	}
+	return img->syms[lo].name;
+}
+
+static const struct image *
+find_image(const char *name)
+{
+	int i;
+
+	for (i = 2; i < nimages; i++) {
+		if (!strncmp(images[i].name, name, MAXNAME))
+			return &images[i];
+	}
+	return NULL;
+}
+
+static const char *
+task_name(uint32_t id)
+{
+	int i;
+
+	for (i = 0; i < ntasks; i++) {
+		if (tasks[i].id == id)
+			return tasks[i].name;
+	}
+	return "?";
+}
+
+static void
+add_sample(const struct image *img, const char *sym, const char *task)
+{
+	struct entry *e;
+	int i;
+
+	for (i = 0; i < nentries; i++) {
+		e = &entries[i];
+		if (e->img == img && e->sym == sym && e->task == task) {
+			e->count++;
+			return;
+		}
+	}
+	if (nentries >= maxentries) {
+		maxentries = maxentries ? maxentries * 2 : 256;
+		entries = realloc(entries, sizeof(struct entry) *
+				  (size_t)maxentries);
+		if (entries == NULL) {
+			fputs("profsym: out of memory\n", stderr);
+			exit(1);
+		}
+	}
+	e = &entries[nentries++];
+	e->img = img;
+	e->sym = sym;
+	e->task = task;
+	e->count = 1;
+}
+
+static int
+entcmp(const void *a, const void *b)
+{
+	const struct entry *e1 = a, *e2 = b;
+
+	if (e1->count > e2->count)
+		return -1;
+	return e1->count < e2->count;
+}
+
+static void
+usage(void)
+{
+
+	fputs("usage: profsym [-n lines] profile kernel driver "
+	      "[name=file ...]\n", stderr);
+	exit(1);
+}
+
+int
+main(int argc, char *argv[])
+{
+	const struct image *img;
+	const char *name, *sym, *task;
+	char line[128], *p;
+	unsigned long pc, tid, thr, total = 0;
+	unsigned long drvtext = 0;
+	FILE *fp;
+	int i, limit = 50;
+
+	if (argc > 2 && !strcmp(argv[1], "-n")) {
+		limit = atoi(argv[2]);
+		argv += 2;
+		argc -= 2;
+	}
+	if (argc < 4)
+		usage();
+
+	load_image("kernel", argv[2]);
+	load_image("driver", argv[3]);
+	for (i = 4; i < argc; i++) {
+		if ((p = strchr(argv[i], '=')) != NULL) {
+			*p = '\0';
+			load_image(argv[i], p + 1);
+		} else {
+			name = strrchr(argv[i], '/');
+			load_image(name ? name + 1 : argv[i], argv[i]);
+		}
+	}
+
+	if ((fp = fopen(argv[1], "r")) == NULL) {
+		perror(argv[1]);
+		exit(1);
+	}
+	if (fgets(line, sizeof(line), fp) == NULL ||
+	    strncmp(line, "prex-profile", 12) != 0) {
+		fprintf(stderr, "profsym: %s: not a profile\n", argv[1]);
+		exit(1);
+	}
+
+	/* The task names and the driver address come last. */
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		if (!strncmp(line, "drvtext ", 8))
+			drvtext = strtoul(line + 8, NULL, 16);
+		else if (!strncmp(line, "task ", 5) && ntasks < MAXTASKS) {
+			tasks[ntasks].id = (uint32_t)strtoul(line + 5, &p, 16);
+			sscanf(p, "%31s", tasks[ntasks].name);
+			ntasks++;
+		}
+	}
+	images[1].offset = (uint32_t)drvtext - images[1].lo;
+	images[1].lo += images[1].offset;
+	images[1].hi += images[1].offset;
+
+	rewind(fp);
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		if (sscanf(line, "%lx %lx %lx", &pc, &tid, &thr) != 3)
+			continue;
+		task = task_name((uint32_t)tid);
+		if (pc >= images[0].lo && pc < images[0].hi)
+			img = &images[0];
+		else if (pc >= images[1].lo && pc < images[1].hi)
+			img = &images[1];
+		else
+			img = find_image(task);
+		sym = img ? lookup_sym(img, (uint32_t)pc) : "?";
+		add_sample(img, sym, task);
+		total++;
+	}
+	fclose(fp);
+
+	if (total == 0) {
+		puts("no samples");
+		exit(0);
+	}
+	qsort(entries, (size_t)nentries, sizeof(struct entry), entcmp);
+
+	printf("   COUNT      %%  TASK         IMAGE        SYMBOL\n");
+	for (i = 0; i < nentries && i < limit; i++) {
+		printf("%8lu %6.2f  %-12s %-12s %s\n", entries[i].count,
+		       entries[i].count * 100.0 / total, entries[i].task,
+		       entries[i].img ? entries[i].img->name : "?",
+		       entries[i].sym);
+	}
+	printf("%8lu samples\n", total);
+	return 0;
+}
@@ -42,6 +42,7 @@ x *
 
 #define PSFX	0x01
 #define PSFL	0x02
+#define PSFC	0x04
 
 struct procinfo {
 	pid_t	pid;
@@ -86,7 +87,7 @@ main(int argc, char *argv[])
 	int ch, rc, ps_flag = 0;
 	pid_t last_pid = -2;
 
-	while ((ch = getopt(argc, argv, "lx")) != -1)
+	while ((ch = getopt(argc, argv, "clx")) != -1)
 		switch(ch) {
 		case 'x':
 			ps_flag |= PSFX;
@@ -94,10 +95,13 @@ main(int argc, char *argv[])
 		case 'l':
 			ps_flag |= PSFL;
 			break;
+		case 'c':
+			ps_flag |= PSFC;
+			break;
 
 		case '?':
 		default:
-			fprintf(stderr, "usage: ps [-lx]\n");
+			fprintf(stderr, "usage: ps [-clx]\n");
 			exit(1);
 		}
 	argc -= optind;
@@ -106,7 +110,10 @@ main(int argc, char *argv[])
 	if (object_lookup("!proc", &procobj))
 		exit(1);
 
-	if (ps_flag & PSFL)
+	if (ps_flag & PSFC)
+		printf("  PID          RTIME  NVCSW NIVCSW WAKEUP"
+		       "  LATAVG  LATMAX      IPCWAIT CMD\n");
+	else if (ps_flag & PSFL)
 		printf("  PID  PPID PRI STAT POL      TIME WCHAN       CMD\n");
 	else
 		printf("  PID     TIME CMD\n");
@@ -125,7 +132,23 @@ main(int argc, char *argv[])
 			if (pstat(ti.task, &pi) && !(ps_flag & PSFX))
 				continue;
 
-			if (ps_flag & PSFL) {
+			if (ps_flag & PSFC) {
+				/*
+				 * CPU accounting of each thread.
+				 */
+				if (pi.pid == -1)
+					printf("    -"); /* kernel */
+				else
+					printf("%5d", pi.pid);
+
+				printf(" %7ld.%06ld %6lu %6lu %6lu "
+				       "%7lu %7lu %5ld.%06ld %-11s\n",
+				       ti.rtime.tv_sec, ti.rtime.tv_usec,
+				       ti.nvcsw, ti.nivcsw, ti.nwakeup,
+				       ti.wklat, ti.wklatmax,
+				       ti.ipcwait.tv_sec, ti.ipcwait.tv_usec,
+				       ti.taskname);
+			} else if (ps_flag & PSFL) {
 				if (pi.pid == -1)
 					printf("    -     -"); /* kernel */
 				else
@@ -0,0 +1,353 @@
+/*
+ * Copyright (c) 2009, Kohsuke Ohtani
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the author nor the names of any co-contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+/*
+ * __pipe.c - shared memory pipe support.
+ *
+ * The data of a pipe is stored in the ring buffer which is shared
+ * between the file system server and the tasks using the pipe.
+ * read()/write() on a pipe copy data to/from the ring directly,
+ * and the server is called only when a thread has to sleep or
+ * the pipe is opened or closed.
+ *
+ * The ring mapping for each file descriptor is cached in this
+ * task. The descriptors from pipe() or inherited from exec() are
+ * checked by FS_PIPEMAP at the first access. The server creates
+ * the ring at that time, so the size of a new pipe can still be
+ * changed by F_SETPIPE_SZ.
+ *
+ * The ring lock is never waited for without a limit. If it is
+ * held too long, the holder may have been killed while holding
+ * it, and the server is asked to check the holder and release
+ * the lock.
+ */
+
+#include <sys/prex.h>
+#include <sys/posix.h>
+#include <ipc/fs.h>
+#include <ipc/ipc.h>
+
+#include <limits.h>
+#include <string.h>
+#include <errno.h>
+
+#define PIPE_UNKNOWN	0		/* not checked yet */
+#define PIPE_NONE	0x10		/* no ring for this descriptor */
+
+#define PIPE_LOCKTMO	1000		/* msec to wait for the ring lock */
+
+/* sem_wait() which returns EINTR */
+extern int _sem_wait(sem_t *, unsigned long);
+
+struct pipefd {
+	struct pipe_ring *ring;		/* mapped ring */
+	int	flags;			/* FREAD/FWRITE or PIPE_* */
+};
+
+static struct pipefd pipe_fds[OPEN_MAX];
+static mutex_t pipe_lock = MUTEX_INITIALIZER;
+
+/*
+ * Map the error of a semaphore operation.  The semaphores are
+ * gone if the server has released the ring.
+ */
+static int
+sem_error(int error)
+{
+
+	return (error == EINTR) ? EINTR : EBADF;
+}
+
+/*
+ * Lock the ring.
+ * The holder is recorded, so that the server can release the
+ * lock if the holder thread dies.
+ */
+static int
+lock_ring(int fd, struct pipe_ring *pr)
+{
+	int error;
+
+	for (;;) {
+		error = _sem_wait(&pr->pr_lock, PIPE_LOCKTMO);
+		if (error == 0)
+			break;
+		if (error != ETIMEDOUT)
+			return sem_error(error);
+		if (ioctl(fd, FIFOIOC_RECOVER, NULL) != 0)
+			return EBADF;
+	}
+	pr->pr_owner = thread_self();
+	return 0;
+}
+
+static void
+unlock_ring(struct pipe_ring *pr)
+{
+
+	pr->pr_owner = 0;
+	sem_post(&pr->pr_lock);
+}
+
+/*
+ * Sleep on the semaphore of the ring, and lock the ring again.
+ * The caller has counted itself in *nwait with the lock held.
+ * If the wait fails, the count is taken back.
+ */
+static int
+wait_ring(int fd, struct pipe_ring *pr, sem_t *sem, int *nwait)
+{
+	int error;
+
+	unlock_ring(pr);
+	if ((error = _sem_wait(sem, 0)) != 0) {
+		if (lock_ring(fd, pr) == 0) {
+			if (*nwait > 0)
+				(*nwait)--;
+			unlock_ring(pr);
+		}
+		return sem_error(error);
+	}
+	return lock_ring(fd, pr);
+}
+
+static void
+wakeup_waiters(sem_t *sem, int *nwait)
+{
+
+	while (*nwait > 0) {
+		(*nwait)--;
+		sem_post(sem);
+	}
+}
+
+/*
+ * Read data from the pipe ring.
+ * Returns 0 with *result = 0 at the end of file.
+ */
+int
+__pipe_read(int fd, struct pipe_ring *pr, void *buf, size_t size,
+	    size_t *result)
+{
+	char *p = buf;
+	size_t len, n;
+	int error;
+
+	if ((error = lock_ring(fd, pr)) != 0)
+		return error;
+
+	while (pr->pr_count == 0) {
+		if (pr->pr_writers == 0) {
+			unlock_ring(pr);
+			*result = 0;
+			return 0;
+		}
+		pr->pr_rwait++;
+		error = wait_ring(fd, pr, &pr->pr_rsem, &pr->pr_rwait);
+		if (error != 0)
+			return error;
+	}
+
+	len = MIN(size, pr->pr_count);
+	n = MIN(len, pr->pr_size - pr->pr_start);
+	memcpy(p, &pr->pr_buf[pr->pr_start], n);
+	if (len > n)
+		memcpy(p + n, pr->pr_buf, len - n);
+
+	pr->pr_start += len;
+	if (pr->pr_start >= pr->pr_size)
+		pr->pr_start -= pr->pr_size;
+	pr->pr_count -= len;
+
+	/*
+	 * Wake writers only when the ring drains to the low
+	 * water mark, so that they can refill it in bulk.
+	 */
+	if (pr->pr_count <= pr->pr_lowat)
+		wakeup_waiters(&pr->pr_wsem, &pr->pr_wwait);
+
+	unlock_ring(pr);
+	*result = len;
+	return 0;
+}
+
+/*
+ * Write data to the pipe ring.
+ * A write of PIPE_BUF bytes or less is never interleaved with
+ * the data from other writers.
+ */
+int
+__pipe_write(int fd, struct pipe_ring *pr, const void *buf, size_t size,
+	     size_t *result)
+{
+	const char *p = buf;
+	size_t pos, nfree, len, n, count = 0;
+	int error;
+
+	if ((error = lock_ring(fd, pr)) != 0)
+		return error;
+
+	while (size > 0) {
+		if (pr->pr_readers == 0) {
+			error = EPIPE;
+			break;
+		}
+		nfree = pr->pr_size - pr->pr_count;
+		if (nfree == 0 || (size <= PIPE_BUF && nfree < size)) {
+			pr->pr_wwait++;
+			error = wait_ring(fd, pr, &pr->pr_wsem, &pr->pr_wwait);
+			if (error != 0)
+				goto out;
+			continue;
+		}
+		len = MIN(size, nfree);
+		pos = pr->pr_start + pr->pr_count;
+		if (pos >= pr->pr_size)
+			pos -= pr->pr_size;
+		n = MIN(len, pr->pr_size - pos);
+		memcpy(&pr->pr_buf[pos], p, n);
+		if (len > n)
+			memcpy(pr->pr_buf, p + n, len - n);
+		pr->pr_count += len;
+
+		p += len;
+		size -= len;
+		count += len;
+
+		wakeup_waiters(&pr->pr_rsem, &pr->pr_rwait);
+	}
+	unlock_ring(pr);
+ out:
+	if (count > 0)
+		error = 0;
+	*result = count;
+	return error;
+}
+
+/*
+ * Return the pipe ring mapped for the file descriptor, or NULL
+ * if the descriptor must be handled by the server. "mode" is
+ * FREAD or FWRITE.
+ */
+struct pipe_ring *
+__pipe_lookup(int fd, int mode)
+{
+	struct pipefd *pf;
+	struct msg m;
+
+	if (fd < 0 || fd >= OPEN_MAX)
+		return NULL;
+
+	pf = &pipe_fds[fd];
+	if (pf->flags == PIPE_UNKNOWN) {
+		mutex_lock(&pipe_lock);
+		if (pf->flags == PIPE_UNKNOWN) {
+			m.hdr.code = FS_PIPEMAP;
+			m.data[0] = fd;
+			if (__fs_obj != 0 &&
+			    msg_send(__fs_obj, &m, sizeof(m)) == 0 &&
+			    m.hdr.status == 0) {
+				pf->ring = (struct pipe_ring *)m.data[0];
+				pf->flags = m.data[1];
+			} else
+				pf->flags = PIPE_NONE;
+		}
+		mutex_unlock(&pipe_lock);
+	}
+	if (!(pf->flags & mode))
+		return NULL;
+	return pf->ring;
+}
+
+/*
+ * Set the state of the new file descriptor.
+ * "mode" is 0 if the descriptor is not a pipe. If "pr" is NULL
+ * for a pipe, the ring is looked up at the first access.
+ */
+void
+__pipe_setfd(int fd, struct pipe_ring *pr, int mode)
+{
+
+	if (fd < 0 || fd >= OPEN_MAX)
+		return;
+
+	mutex_lock(&pipe_lock);
+	pipe_fds[fd].ring = pr;
+	if (mode == 0)
+		pipe_fds[fd].flags = PIPE_NONE;
+	else
+		pipe_fds[fd].flags = (pr != NULL) ? mode : PIPE_UNKNOWN;
+	mutex_unlock(&pipe_lock);
+}
+
+/*
+ * Copy the state of the file descriptor for dup().
+ */
+void
+__pipe_dupfd(int oldfd, int newfd)
+{
+
+	if (oldfd < 0 || oldfd >= OPEN_MAX)
+		return;
+	if (newfd < 0 || newfd >= OPEN_MAX)
+		return;
+
+	mutex_lock(&pipe_lock);
+	pipe_fds[newfd] = pipe_fds[oldfd];
+	mutex_unlock(&pipe_lock);
+}
+
+/*
+ * Forget the closed file descriptor.
+ * The ring is unmapped when no descriptor refers it.
+ */
+void
+__pipe_closefd(int fd)
+{
+	struct pipe_ring *pr;
+	int i;
+
+	if (fd < 0 || fd >= OPEN_MAX)
+		return;
+
+	mutex_lock(&pipe_lock);
+	pr = pipe_fds[fd].ring;
+	pipe_fds[fd].ring = NULL;
+	pipe_fds[fd].flags = PIPE_UNKNOWN;
+	if (pr != NULL) {
+		for (i = 0; i < OPEN_MAX; i++) {
+			if (pipe_fds[i].ring == pr)
+				break;
+		}
+		if (i == OPEN_MAX)
+			vm_free(task_self(), pr);
+	}
+	mutex_unlock(&pipe_lock);
+}
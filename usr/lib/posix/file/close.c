@@ -39,5 +39,8 @@ close(int fd)
 
 	m.hdr.code = FS_CLOSE;
 	m.data[0] = fd;
-	return __posix_call(__fs_obj, &m, sizeof(m), 1);
+	if (__posix_call(__fs_obj, &m, sizeof(m), 1) != 0)
+		return -1;
+	__pipe_closefd(fd);
+	return 0;
 }
@@ -41,5 +41,6 @@ dup(int oldfd)
 	m.data[0] = oldfd;
 	if (__posix_call(__fs_obj, &m, sizeof(m), 1) != 0)
 		return -1;
+	__pipe_dupfd(oldfd, m.data[0]);
 	return m.data[0];
 }
@@ -44,5 +44,9 @@ dup2(int oldfd, int newfd)
 	m.data[1] = newfd;
 	if (__posix_call(__fs_obj, &m, sizeof(m), 1) != 0)
 		return -1;
+	if (oldfd != newfd) {
+		__pipe_closefd(newfd);
+		__pipe_dupfd(oldfd, newfd);
+	}
 	return m.data[0];
 }
@@ -53,5 +53,6 @@ open(const char *path, int flags, ...)
 	strlcpy(m.path, (char *)path, PATH_MAX);
 	if (__posix_call(__fs_obj, &m, sizeof(m), 0) != 0)
 		return -1;
+	__pipe_setfd(m.fd, NULL, 0);
 	return m.fd;
 }
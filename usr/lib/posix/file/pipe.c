@@ -42,5 +42,9 @@ pipe(int fd[2])
 		return -1;
 	fd[0] = m.data[0];
 	fd[1] = m.data[1];
+
+	/* The shared ring is mapped at the first read/write. */
+	__pipe_setfd(fd[0], NULL, FREAD);
+	__pipe_setfd(fd[1], NULL, FWRITE);
 	return 0;
 }
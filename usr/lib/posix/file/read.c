@@ -38,11 +38,34 @@ int
 read(int fd, void *buf, size_t len)
 {
 	struct io_msg m;
+	struct iovec iov[2];
+	struct pipe_ring *pr;
+	size_t count;
+	int error;
+
+	if ((pr = __pipe_lookup(fd, FREAD)) != NULL) {
+		if ((error = __pipe_read(fd, pr, buf, len, &count)) != 0) {
+			errno = error;
+			return -1;
+		}
+		return (int)count;
+	}
 
 	m.hdr.code = FS_READ;
 	m.fd = fd;
-	m.buf = buf;
 	m.size = len;
+	if (len <= MAX_FSDATA) {
+		/* Pass the data with the message. */
+		m.buf = NULL;
+		iov[0].iov_base = &m;
+		iov[0].iov_len = sizeof(m);
+		iov[1].iov_base = buf;
+		iov[1].iov_len = len;
+		if (__posix_callv(__fs_obj, iov, 2, 0) != 0)
+			return -1;
+		return (int)m.size;
+	}
+	m.buf = buf;
 	if (__posix_call(__fs_obj, &m, sizeof(m), 0) != 0)
 		return -1;
 	return (int)m.size;
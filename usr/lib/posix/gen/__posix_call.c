@@ -64,3 +64,32 @@ __posix_call(object_t obj, void *msg, size_t size, int restart)
 	}
 	return 0;
 }
+
+/*
+ * Send a message with the data segments to POSIX server.
+ * The first segment holds the message.
+ */
+int
+__posix_callv(object_t obj, const struct iovec *iov, int cnt, int restart)
+{
+	struct msg_header *hdr = iov[0].iov_base;
+	int error;
+
+	if (obj == 0) {
+		errno = ENOSYS;
+		return -1;
+	}
+
+	do {
+		error = msg_sendv(obj, iov, cnt);
+	} while (error == EINTR && restart);
+
+	if (error) {
+		errno = (error == EINTR) ? EINTR : ENOSYS;
+		return -1;
+	} else if (hdr->status) {
+		errno = hdr->status;
+		return -1;
+	}
+	return 0;
+}
@@ -36,144 +36,394 @@
 #include <stdlib.h>
 #include "malloc.h"
 
+/*
+ * Size-class memory allocator.
+ *
+ * Small objects are served from single page spans which hold the
+ * objects of one size class.  Each class keeps a list of spans
+ * with free objects, so both malloc() and free() of a small object
+ * take constant time.  Larger objects get a run of pages from the
+ * page heap.  The page heap takes memory from the VM in chunks, and
+ * returns a chunk to the VM when all of its pages are free again.
+ */
+
 #ifdef _REENTRANT
 static mutex_t malloc_lock = MUTEX_INITIALIZER;
 #endif
 
-static struct header *more_core(size_t size);
+const size_t __malloc_size[NCLASSES] = {
+	16, 32, 48, 64, 96, 128, 192, 256,
+	384, 512, 672, 1008, 1344, 2032
+};
 
-static struct header free_list;		/* start of free list */
-static struct header *scan_head;	/* start point to scan */
+struct malloc_stat __malloc_stat;
+void (*__malloc_tcstat)(void);
+
+static u_char class_table[(MAX_SMALL >> 4) + 1]; /* size -> class */
+static struct span partial[NCLASSES];	/* spans with free objects */
+static struct span free_runs;		/* free page runs, sorted */
+static size_t chunk_next;		/* pages of next chunk */
+
+static void
+malloc_init(void)
+{
+	int i, c;
+
+	c = 0;
+	for (i = 0; i <= (MAX_SMALL >> 4); i++) {
+		if ((size_t)(i << 4) > __malloc_size[c])
+			c++;
+		class_table[i] = (u_char)c;
+	}
+	for (i = 0; i < NCLASSES; i++)
+		partial[i].next = partial[i].prev = &partial[i];
+	free_runs.next = free_runs.prev = &free_runs;
+	chunk_next = CHUNK_MIN;
+}
 
 /*
- * Simple memory allocator from K&R
+ * Return the size class for the specified size,
+ * or -1 if it is not a small object.
  */
-void *
-malloc(size_t size)
+int
+__malloc_class(size_t size)
 {
-	struct header *p, *prev;
 
-	if (size == 0)		/* sanity check */
-		return NULL;
-	size = ROUNDUP(size + sizeof(struct header));
+	if (chunk_next == 0)
+		malloc_init();
+	if (size > MAX_SMALL)
+		return -1;
+	return class_table[(size + ALIGN_MASK) >> 4];
+}
 
-	MALLOC_LOCK();
+static void
+span_insert(struct span *prev, struct span *s)
+{
 
-	if (scan_head == NULL) {
-		/* Initialize */
-		free_list.next = &free_list;
-		free_list.size = 0;
-		free_list.vm_size = 0;
-		scan_head = &free_list;
-	}
-	prev = scan_head;
-	for (p = prev->next;; prev = p, p = p->next) {
-		if (p->size >= size) {	/* big enough */
-			if (p->size == size)	/* exactly */
-				prev->next = p->next;
-			else {			/* allocate tail end */
-				p->size -= size;
-				p = (struct header *)((char *)p + p->size);
-				p->size = size;
-				p->vm_size = 0;
-			}
-#ifdef DEBUG_MALLOC
-			p->magic = MALLOC_MAGIC;
-#endif
-			scan_head = prev;
+	s->prev = prev;
+	s->next = prev->next;
+	prev->next->prev = s;
+	prev->next = s;
+}
+
+static void
+span_remove(struct span *s)
+{
+
+	s->prev->next = s->next;
+	s->next->prev = s->prev;
+}
+
+/*
+ * Map a new chunk and add it to the free page runs.
+ */
+static int
+chunk_grow(size_t npages)
+{
+	struct span *s, *prev;
+	size_t size;
+
+	if (npages < chunk_next)
+		npages = chunk_next;
+	size = npages * PAGE_SIZE;
+	if (vm_allocate(task_self(), (void *)&s, size, 1))
+		return -1;
+	if (chunk_next < CHUNK_MAX)
+		chunk_next *= 2;
+
+	__malloc_stat.nchunks++;
+	__malloc_stat.vm_size += size;
+	__malloc_stat.nvmalloc++;
+
+	s->class = SPAN_FREE;
+	s->npages = npages;
+	s->chunk = (char *)s;
+	s->chunk_pages = npages;
+
+	/* Insert it in address order */
+	for (prev = &free_runs; prev->next != &free_runs; prev = prev->next) {
+		if (prev->next > s)
 			break;
-		}
-		if (p == scan_head) {
-			if ((p = more_core(size)) == NULL)
+	}
+	span_insert(prev, s);
+	return 0;
+}
+
+/*
+ * Allocate a run of pages from the page heap.
+ */
+static struct span *
+page_alloc(size_t npages)
+{
+	struct span *s, *rest;
+
+	if (npages > HUGE_PAGES) {
+		/* Map it directly */
+		if (vm_allocate(task_self(), (void *)&s,
+				npages * PAGE_SIZE, 1))
+			return NULL;
+		__malloc_stat.vm_size += npages * PAGE_SIZE;
+		__malloc_stat.nvmalloc++;
+		s->class = SPAN_HUGE;
+		s->npages = npages;
+		s->chunk = (char *)s;
+		s->chunk_pages = npages;
+		return s;
+	}
+	for (;;) {
+		for (s = free_runs.next; s != &free_runs; s = s->next) {
+			if (s->npages >= npages)
 				break;
 		}
+		if (s != &free_runs)
+			break;
+		if (chunk_grow(npages))
+			return NULL;
 	}
-	MALLOC_UNLOCK();
+	if (s->npages > npages) {
+		/* Split off the tail */
+		rest = (struct span *)((char *)s + npages * PAGE_SIZE);
+		rest->class = SPAN_FREE;
+		rest->npages = s->npages - npages;
+		rest->chunk = s->chunk;
+		rest->chunk_pages = s->chunk_pages;
+		span_insert(s, rest);
+		s->npages = npages;
+	}
+	span_remove(s);
+	return s;
+}
 
-	if (p == NULL) {
-#ifdef DEBUG_MALLOC
-		sys_panic("malloc: out of memory");
-#endif
-		return NULL;
+/*
+ * Return a run of pages to the page heap.
+ */
+static void
+page_free(struct span *s)
+{
+	struct span *prev, *next;
+
+	if (s->class == SPAN_HUGE) {
+		__malloc_stat.vm_size -= s->npages * PAGE_SIZE;
+		__malloc_stat.nvmfree++;
+		vm_free(task_self(), s);
+		return;
+	}
+	s->class = SPAN_FREE;
+
+	for (prev = &free_runs; prev->next != &free_runs; prev = prev->next) {
+		if (prev->next > s)
+			break;
+	}
+	next = prev->next;
+
+	/* Join to the upper run */
+	if (next != &free_runs && next->chunk == s->chunk &&
+	    (char *)s + s->npages * PAGE_SIZE == (char *)next) {
+		s->npages += next->npages;
+		span_remove(next);
+	}
+	/* Join to the lower run */
+	if (prev != &free_runs && prev->chunk == s->chunk &&
+	    (char *)prev + prev->npages * PAGE_SIZE == (char *)s) {
+		prev->npages += s->npages;
+		s = prev;
+	} else
+		span_insert(prev, s);
+
+	/*
+	 * Give the whole chunk back to the VM, but keep the last
+	 * one to avoid mapping it again on the next allocation.
+	 */
+	if (s->npages == s->chunk_pages && __malloc_stat.nchunks > 1) {
+		span_remove(s);
+		__malloc_stat.nchunks--;
+		__malloc_stat.vm_size -= s->npages * PAGE_SIZE;
+		__malloc_stat.nvmfree++;
+		vm_free(task_self(), s);
 	}
-	return (void *)(p + 1);
 }
 
 /*
- * Create new block and insert it to the free list.
+ * Create a new span for the specified size class.
  */
-static struct header *more_core(size_t size)
+static struct span *
+span_create(int c)
 {
-	struct header *p, *prev;
+	struct span *s;
+	char *obj;
+	void **link;
+	size_t size;
+	int i, n;
 
-	size = round_page(size);
-	if (vm_allocate(task_self(), (void *)&p, size, 1))
+	if ((s = page_alloc(1)) == NULL)
 		return NULL;
-	p->size = size;
-	p->vm_size = size;
+	size = __malloc_size[c];
+	n = (int)((PAGE_SIZE - SPAN_HDR) / size);
 
-	/* Insert to free list */
-	for (prev = scan_head; !(p > prev && p < prev->next); prev = prev->next) {
-		if (prev >= prev->next && (p > prev || p < prev->next))
-			break;
+	s->class = (short)c;
+	s->nfree = (short)n;
+	obj = (char *)s + SPAN_HDR;
+	s->freelist = obj;
+	for (i = 0; i < n - 1; i++) {
+		link = (void **)obj;
+		obj += size;
+		*link = obj;
+	}
+	*(void **)obj = NULL;
+
+	span_insert(&partial[c], s);
+	__malloc_stat.class[c].nspans++;
+	return s;
+}
+
+static void *
+small_alloc(int c)
+{
+	struct span *s;
+	void *p;
+
+	s = partial[c].next;
+	if (s == &partial[c]) {
+		if ((s = span_create(c)) == NULL)
+			return NULL;
+	}
+	p = s->freelist;
+	s->freelist = *(void **)p;
+	if (--s->nfree == 0)
+		span_remove(s);
+
+	__malloc_stat.class[c].nalloc++;
+	__malloc_stat.class[c].inuse++;
+	return p;
+}
+
+static void
+small_free(struct span *s, void *p)
+{
+	int c = s->class;
+
+	*(void **)p = s->freelist;
+	s->freelist = p;
+	if (s->nfree++ == 0)
+		span_insert(&partial[c], s);
+
+	__malloc_stat.class[c].nfree++;
+	__malloc_stat.class[c].inuse--;
+
+	/*
+	 * Release an empty span unless it is the only one
+	 * left for this class.
+	 */
+	if ((size_t)s->nfree == (PAGE_SIZE - SPAN_HDR) / __malloc_size[c] &&
+	    (s->next != &partial[c] || s->prev != &partial[c])) {
+		span_remove(s);
+		__malloc_stat.class[c].nspans--;
+		page_free(s);
 	}
-	p->next = prev->next;
-	prev->next = p;
-	scan_head = prev;
-	return prev;
+}
+
+static void *
+large_alloc(size_t size)
+{
+	struct span *s;
+	size_t npages;
+
+	if (size > (size_t)-1 - SPAN_HDR - PAGE_SIZE)
+		return NULL;
+	npages = round_page(size + SPAN_HDR) / PAGE_SIZE;
+	if ((s = page_alloc(npages)) == NULL)
+		return NULL;
+	if (s->class != SPAN_HUGE)
+		s->class = SPAN_LARGE;
+
+	__malloc_stat.nlarge++;
+	__malloc_stat.large_pages += npages;
+	return (char *)s + SPAN_HDR;
+}
+
+void *
+malloc(size_t size)
+{
+	void *p;
+	int c;
+
+	if (size == 0)		/* sanity check */
+		return NULL;
+
+	MALLOC_LOCK();
+	if ((c = __malloc_class(size)) >= 0)
+		p = small_alloc(c);
+	else
+		p = large_alloc(size);
+	MALLOC_UNLOCK();
+
+	if (p == NULL) {
+#ifdef DEBUG_MALLOC
+		sys_panic("malloc: out of memory");
+#endif
+		return NULL;
+	}
+	return p;
 }
 
 void
 free(void *addr)
 {
-	struct header *p, *prev;
+	struct span *s;
 
 	if (addr == NULL)
 		return;
 
-	MALLOC_LOCK();
-	p = (struct header *)addr - 1;
+	s = PTR_SPAN(addr);
 #ifdef DEBUG_MALLOC
-	if (p->magic != MALLOC_MAGIC)
+	if (s->class >= NCLASSES || s->class == SPAN_FREE ||
+	    (s->class < 0 && addr != (char *)s + SPAN_HDR))
 		sys_panic("free: invalid pointer");
-	p->magic = 0;
 #endif
-	for (prev = scan_head; !(p > prev && p < prev->next); prev = prev->next) {
-		if (prev >= prev->next && (p > prev || p < prev->next))
+	MALLOC_LOCK();
+	if (s->class >= 0)
+		small_free(s, addr);
+	else {
+		__malloc_stat.large_pages -= s->npages;
+		page_free(s);
+	}
+	MALLOC_UNLOCK();
+}
+
+/*
+ * Take up to n objects of the size class c.  They are linked
+ * through their first word.  Returns the number of objects.
+ */
+int
+__malloc_getbatch(int c, void **list, int n)
+{
+	void *p;
+	int i;
+
+	*list = NULL;
+	MALLOC_LOCK();
+	for (i = 0; i < n; i++) {
+		if ((p = small_alloc(c)) == NULL)
 			break;
+		*(void **)p = *list;
+		*list = p;
 	}
-	if ((prev->next->vm_size == 0) &&	/* join to upper block */
-	    ((char *)p + p->size == (char *)prev->next)) {
-		p->size += prev->next->size;
-		p->next = prev->next->next;
-	} else {
-		p->next = prev->next;
-	}
-	if ((p->vm_size == 0) &&	/* join to lower block */
-	    ((char *)prev + prev->size == (char *)p)) {
-		prev->size += p->size;
-		prev->next = p->next;
-	} else {
-		prev->next = p;
-	}
-	/* Deallocate pool */
-	if (p->size == p->vm_size) {
-		prev->next = p->next;
-		vm_free(task_self(), p);
-	}
-	scan_head = prev;
 	MALLOC_UNLOCK();
+	return i;
 }
 
-#ifdef DEBUG_MALLOC
+/*
+ * Free the list of objects.
+ */
 void
-mstat(void)
+__malloc_putbatch(void *list)
 {
-	struct header *p;
+	void *p;
 
-	printf("mstat: task=%x\n", task_self());
-	for (p = free_list.next; p != &free_list; p = p->next) {
-		printf("mstat: addr=%x size=%d next=%x\n", p, p->size, p->next);
+	MALLOC_LOCK();
+	while ((p = list) != NULL) {
+		list = *(void **)p;
+		small_free(PTR_SPAN(p), p);
 	}
+	MALLOC_UNLOCK();
 }
-#endif
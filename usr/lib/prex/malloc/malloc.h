@@ -32,8 +32,6 @@
 
 /* #define DEBUG_MALLOC	1 */
 
-#define MALLOC_MAGIC	(int)0xBAADF00D	/* "bad food" from LocalAlloc :) */
-
 #ifdef _REENTRANT
 #define MALLOC_LOCK()	mutex_lock(&malloc_lock);
 #define MALLOC_UNLOCK()	mutex_unlock(&malloc_lock);
@@ -46,11 +44,72 @@
 #define ALIGN_MASK      (ALIGN_SIZE - 1)
 #define ROUNDUP(size)   (((u_long)(size) + ALIGN_MASK) & ~ALIGN_MASK)
 
-struct header {
-	struct header *next;
-	size_t size;
-	size_t vm_size;
-#ifdef DEBUG_MALLOC
-	int magic;
-#endif
+/*
+ * Small requests are rounded up to one of the following size
+ * classes and carved out of single page spans.  Anything larger
+ * than MAX_SMALL gets its own run of pages.
+ */
+#define NCLASSES	14
+#define MAX_SMALL	2032
+
+/*
+ * Pages are taken from the VM in chunks.  The first chunk is
+ * small and the chunk size doubles up to CHUNK_MAX pages, so that
+ * a tiny task does not pay for a large heap.  Page runs bigger
+ * than half of CHUNK_MAX are mapped directly.
+ */
+#define CHUNK_MIN	4
+#define CHUNK_MAX	16
+#define HUGE_PAGES	(CHUNK_MAX / 2)
+
+/* Span types other than a size class */
+#define SPAN_FREE	-1		/* free page run */
+#define SPAN_LARGE	-2		/* large object */
+#define SPAN_HUGE	-3		/* directly mapped object */
+
+/*
+ * Span header.  It is placed at the top of every page run, and
+ * one object of a span always lies in the first page of that run,
+ * so the owner of any pointer can be found by masking its address.
+ */
+struct span {
+	short		class;		/* size class or span type */
+	short		nfree;		/* number of free objects */
+	size_t		npages;		/* number of pages in this run */
+	void		*freelist;	/* free objects in this span */
+	struct span	*next;		/* link in partial/free list */
+	struct span	*prev;
+	char		*chunk;		/* chunk which owns this run */
+	size_t		chunk_pages;	/* size of the chunk in pages */
+};
+
+#define SPAN_HDR	ROUNDUP(sizeof(struct span))
+#define PTR_SPAN(p)	((struct span *)(((u_long)(p) - 1) & ~PAGE_MASK))
+
+/*
+ * Allocation statistics.
+ */
+struct class_stat {
+	u_long		nalloc;		/* number of allocations */
+	u_long		nfree;		/* number of frees */
+	u_long		inuse;		/* objects in use */
+	u_long		nspans;		/* spans of this class */
+};
+
+struct malloc_stat {
+	struct class_stat class[NCLASSES];
+	u_long		nlarge;		/* large allocations */
+	u_long		large_pages;	/* pages used by large objects */
+	u_long		nchunks;	/* chunks mapped from VM */
+	u_long		vm_size;	/* bytes mapped from VM */
+	u_long		nvmalloc;	/* calls to vm_allocate() */
+	u_long		nvmfree;	/* calls to vm_free() */
 };
+
+extern const size_t __malloc_size[NCLASSES];
+extern struct malloc_stat __malloc_stat;
+extern void (*__malloc_tcstat)(void);
+
+int	 __malloc_class(size_t);
+int	 __malloc_getbatch(int, void **, int);
+void	 __malloc_putbatch(void *);
@@ -29,29 +29,215 @@
 
 /*
  * malloc_r() - this is used with multi-threaded native task.
+ *
+ * Each thread gets a private cache of small objects, so that most
+ * requests are served without taking the allocator lock.  A cache
+ * is filled from, and drained to, the shared heap in batches.
+ * The cache slot is bound to the thread ID; a slot of a terminated
+ * thread is taken over by the next thread which gets the same ID.
+ * When all slots are used, the slots whose owner no longer exists
+ * are drained to the shared heap and reused.  If there is still no
+ * free slot, the thread falls back to the shared heap.
  */
 
 #include <sys/prex.h>
 #include <stdlib.h>
+#include <stdio.h>
 #include "malloc.h"
 
+#define NTCACHE		8	/* max number of thread caches */
+#define TCACHE_MAX	32	/* max objects cached per class */
+#define TCACHE_SCAN	16	/* requests between scans for dead slots */
+
+struct tcache {
+	thread_t	owner;		/* owner thread */
+	void		*list[NCLASSES];	/* cached objects */
+	int		count[NCLASSES];	/* number of cached objects */
+	u_long		hit;		/* requests served from cache */
+	u_long		miss;		/* requests going to the heap */
+};
+
 static mutex_t malloc_r_lock = MUTEX_INITIALIZER;
+static struct tcache tcache[NTCACHE];
+static int tcache_scan;
+
+static void
+tcache_stat(void)
+{
+	struct tcache *tc;
+	int i, c, n;
+
+	for (i = 0; i < NTCACHE; i++) {
+		tc = &tcache[i];
+		if (tc->owner == 0)
+			continue;
+		for (n = 0, c = 0; c < NCLASSES; c++)
+			n += tc->count[c];
+		printf("mstat: thread=%x hit=%lu miss=%lu cached=%d\n",
+		       (int)tc->owner, tc->hit, tc->miss, n);
+	}
+}
+
+/*
+ * Give all cached objects of the slot back to the heap.
+ * Must be called with malloc_r_lock held.
+ */
+static void
+tcache_drain(struct tcache *tc)
+{
+	int c;
+
+	for (c = 0; c < NCLASSES; c++) {
+		if (tc->list[c] != NULL)
+			__malloc_putbatch(tc->list[c]);
+		tc->list[c] = NULL;
+		tc->count[c] = 0;
+	}
+	tc->hit = 0;
+	tc->miss = 0;
+}
+
+/*
+ * Find a slot whose owner thread has terminated, and drain it.
+ * The scan costs a system call per slot, so the threads running
+ * without a cache do it only once every TCACHE_SCAN requests.
+ * Must be called with malloc_r_lock held.
+ */
+static struct tcache *
+tcache_reclaim(void)
+{
+	struct tcache *tc;
+	int i, pri;
+
+	if (tcache_scan++ % TCACHE_SCAN != 0)
+		return NULL;
+	for (i = 0; i < NTCACHE; i++) {
+		tc = &tcache[i];
+		if (thread_getpri(tc->owner, &pri) != 0) {
+			tc->owner = 0;
+			tcache_drain(tc);
+			return tc;
+		}
+	}
+	return NULL;
+}
+
+/*
+ * Get the cache of the current thread.
+ */
+static struct tcache *
+tcache_get(void)
+{
+	struct tcache *tc;
+	thread_t self;
+	int i;
+
+	self = thread_self();
+	for (i = 0; i < NTCACHE; i++) {
+		if (tcache[i].owner == self)
+			return &tcache[i];
+	}
+	tc = NULL;
+	mutex_lock(&malloc_r_lock);
+	__malloc_class(0);	/* initialize the heap */
+	for (i = 0; i < NTCACHE; i++) {
+		if (tcache[i].owner == 0) {
+			tc = &tcache[i];
+			break;
+		}
+	}
+	if (tc == NULL)
+		tc = tcache_reclaim();
+	if (tc != NULL) {
+		tc->owner = self;
+		__malloc_tcstat = tcache_stat;
+	}
+	mutex_unlock(&malloc_r_lock);
+	return tc;
+}
+
+/*
+ * Number of objects to keep in the cache for the size class.
+ */
+static int
+tcache_limit(int c)
+{
+	int n;
+
+	n = (int)(PAGE_SIZE / __malloc_size[c]);
+	if (n > TCACHE_MAX)
+		n = TCACHE_MAX;
+	if (n < 2)
+		n = 2;
+	return n;
+}
 
 void *
 malloc_r(size_t size)
 {
+	struct tcache *tc;
 	void *p;
+	int c;
 
-	mutex_lock(&malloc_r_lock);
-	p = malloc(size);
-	mutex_unlock(&malloc_r_lock);
+	if (size == 0)
+		return NULL;
+
+	if ((tc = tcache_get()) == NULL ||
+	    (c = __malloc_class(size)) < 0) {
+		mutex_lock(&malloc_r_lock);
+		p = malloc(size);
+		mutex_unlock(&malloc_r_lock);
+		return p;
+	}
+	if (tc->count[c] == 0) {
+		tc->miss++;
+		mutex_lock(&malloc_r_lock);
+		tc->count[c] = __malloc_getbatch(c, &tc->list[c],
+						 tcache_limit(c) / 2);
+		mutex_unlock(&malloc_r_lock);
+		if (tc->count[c] == 0)
+			return NULL;
+	} else
+		tc->hit++;
+
+	p = tc->list[c];
+	tc->list[c] = *(void **)p;
+	tc->count[c]--;
 	return p;
 }
 
 void
 free_r(void *addr)
 {
+	struct tcache *tc;
+	struct span *s;
+	void *p, *list;
+	int c, i;
+
+	if (addr == NULL)
+		return;
+
+	s = PTR_SPAN(addr);
+	if ((c = s->class) < 0 || (tc = tcache_get()) == NULL) {
+		mutex_lock(&malloc_r_lock);
+		free(addr);
+		mutex_unlock(&malloc_r_lock);
+		return;
+	}
+	*(void **)addr = tc->list[c];
+	tc->list[c] = addr;
+	if (++tc->count[c] <= tcache_limit(c))
+		return;
+
+	/* Give a half of the cache back to the heap */
+	list = tc->list[c];
+	for (p = list, i = 1; i < tcache_limit(c) / 2; i++)
+		p = *(void **)p;
+	tc->list[c] = *(void **)p;
+	*(void **)p = NULL;
+	tc->count[c] -= i;
+
 	mutex_lock(&malloc_r_lock);
-	free(addr);
+	__malloc_putbatch(list);
 	mutex_unlock(&malloc_r_lock);
 }
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2009, Kohsuke Ohtani
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the author nor the names of any co-contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * mstat() - dump the allocation statistics.
+ */
+
+#include <sys/prex.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "malloc.h"
+
+void
+mstat(void)
+{
+	struct malloc_stat *st = &__malloc_stat;
+	struct class_stat *cs;
+	int c;
+
+	printf("mstat: task=%x chunks=%lu vm_size=%lu vm_allocate=%lu "
+	       "vm_free=%lu\n", (int)task_self(), st->nchunks, st->vm_size,
+	       st->nvmalloc, st->nvmfree);
+	printf("mstat: size   nalloc    nfree    inuse   spans\n");
+	for (c = 0; c < NCLASSES; c++) {
+		cs = &st->class[c];
+		if (cs->nalloc == 0)
+			continue;
+		printf("mstat: %4d %8lu %8lu %8lu %7lu\n", (int)__malloc_size[c],
+		       cs->nalloc, cs->nfree, cs->inuse, cs->nspans);
+	}
+	printf("mstat: large=%lu pages=%lu\n", st->nlarge, st->large_pages);
+	if (__malloc_tcstat != NULL)
+		(*__malloc_tcstat)();
+}
@@ -34,18 +34,27 @@
 void *
 realloc(void *addr, size_t size)
 {
-	struct header *p, *old;
+	struct span *s;
 	size_t old_size;
+	void *p;
 
 	if (addr == NULL)
 		return malloc(size);
 
-	old = (struct header *)addr - 1;
+	s = PTR_SPAN(addr);
 #ifdef DEBUG_MALLOC
-	if (old->magic != MALLOC_MAGIC)
-		sys_panic("free: invalid pointer");
+	if (s->class >= NCLASSES || s->class == SPAN_FREE)
+		sys_panic("realloc: invalid pointer");
 #endif
-	old_size = old->size - sizeof(struct header);
+	if (s->class >= 0)
+		old_size = __malloc_size[s->class];
+	else
+		old_size = s->npages * PAGE_SIZE - SPAN_HDR;
+
+	/* Keep the block if the new size still fits well */
+	if (size <= old_size && size > old_size / 2)
+		return addr;
+
 	if ((p = malloc(size)) == NULL)
 		return NULL;
 	if (old_size <= size)
@@ -0,0 +1,118 @@
+/*-
+ * Copyright (c) 2009, Kohsuke Ohtani
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the author nor the names of any co-contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * arena.c - per-request bump allocator.
+ */
+
+#include <sys/prex.h>
+#include <sys/param.h>
+#include <sys/pool.h>
+#include <stddef.h>
+
+#define ARENA_ALIGN	8
+#define ARENA_ROUND(n)	(((n) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1))
+#define ARENA_CHUNK	(PAGE_SIZE * 4)	/* min size of extra chunk */
+
+/*
+ * Header of an extra chunk.
+ */
+struct chunk {
+	struct chunk	*next;		/* next chunk */
+	size_t		size;		/* size of chunk */
+	size_t		used;		/* bytes used in chunk */
+	size_t		pad;
+};
+
+void
+arena_init(struct arena *ar, void *buf, size_t size)
+{
+
+	ar->ar_base = buf;
+	ar->ar_size = size;
+	ar->ar_used = 0;
+	ar->ar_extra = NULL;
+	ar->ar_peak = 0;
+	ar->ar_total = 0;
+}
+
+/*
+ * Allocate memory which is valid until the next arena_reset().
+ */
+void *
+arena_alloc(struct arena *ar, size_t size)
+{
+	struct chunk *ch;
+	void *p;
+	size_t len;
+
+	size = ARENA_ROUND(size);
+
+	if (ar->ar_size - ar->ar_used >= size) {
+		p = ar->ar_base + ar->ar_used;
+		ar->ar_used += size;
+		ar->ar_total += size;
+		return p;
+	}
+	ch = ar->ar_extra;
+	if (ch == NULL || ch->size - ch->used < size) {
+		len = round_page(size + sizeof(struct chunk));
+		if (len < ARENA_CHUNK)
+			len = ARENA_CHUNK;
+		if (vm_allocate(task_self(), (void *)&ch, len, 1) != 0)
+			return NULL;
+		ch->next = ar->ar_extra;
+		ch->size = len;
+		ch->used = sizeof(struct chunk);
+		ar->ar_extra = ch;
+	}
+	p = (char *)ch + ch->used;
+	ch->used += size;
+	ar->ar_total += size;
+	return p;
+}
+
+/*
+ * Release all memory allocated from the arena.
+ */
+void
+arena_reset(struct arena *ar)
+{
+	struct chunk *ch, *next;
+
+	for (ch = ar->ar_extra; ch != NULL; ch = next) {
+		next = ch->next;
+		vm_free(task_self(), ch);
+	}
+	if (ar->ar_total > ar->ar_peak)
+		ar->ar_peak = ar->ar_total;
+	ar->ar_extra = NULL;
+	ar->ar_used = 0;
+	ar->ar_total = 0;
+}
@@ -0,0 +1,118 @@
+/*-
+ * Copyright (c) 2009, Kohsuke Ohtani
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the author nor the names of any co-contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * pool.c - fixed-size object pool.
+ */
+
+#include <sys/prex.h>
+#include <sys/param.h>
+#include <sys/pool.h>
+#include <stddef.h>
+
+#define POOL_ALIGN	8
+#define POOL_ROUND(n)	(((n) + POOL_ALIGN - 1) & ~(POOL_ALIGN - 1))
+
+void
+pool_init(struct pool *pr, size_t size, int flags)
+{
+
+	pr->pr_size = size;
+	pr->pr_flags = flags;
+	pr->pr_lock = MUTEX_INITIALIZER;
+	pr->pr_free = NULL;
+	pr->pr_page = NULL;
+	pr->pr_avail = 0;
+	pr->pr_nget = 0;
+	pr->pr_nput = 0;
+	pr->pr_npages = 0;
+}
+
+/*
+ * Get an object from the pool.
+ * A free object is reused first.  Otherwise, a new object is
+ * carved from the current page, and a new page is mapped when
+ * the current one is used up.
+ */
+void *
+pool_get(struct pool *pr)
+{
+	void *p;
+	size_t size, len;
+
+	if (pr->pr_flags & POOL_LOCKED)
+		mutex_lock(&pr->pr_lock);
+
+	if ((p = pr->pr_free) != NULL)
+		pr->pr_free = *(void **)p;
+	else {
+		size = POOL_ROUND(pr->pr_size);
+		if (size < sizeof(void *))
+			size = sizeof(void *);
+		if (pr->pr_avail < size) {
+			len = round_page(size);
+			if (vm_allocate(task_self(), &p, len, 1) != 0) {
+				p = NULL;
+				goto out;
+			}
+			pr->pr_page = p;
+			pr->pr_avail = len;
+			pr->pr_npages += len / PAGE_SIZE;
+		}
+		p = pr->pr_page;
+		pr->pr_page += size;
+		pr->pr_avail -= size;
+	}
+	pr->pr_nget++;
+ out:
+	if (pr->pr_flags & POOL_LOCKED)
+		mutex_unlock(&pr->pr_lock);
+	return p;
+}
+
+/*
+ * Return an object to the pool.
+ */
+void
+pool_put(struct pool *pr, void *p)
+{
+
+	if (p == NULL)
+		return;
+
+	if (pr->pr_flags & POOL_LOCKED)
+		mutex_lock(&pr->pr_lock);
+
+	*(void **)p = pr->pr_free;
+	pr->pr_free = p;
+	pr->pr_nput++;
+
+	if (pr->pr_flags & POOL_LOCKED)
+		mutex_unlock(&pr->pr_lock);
+}
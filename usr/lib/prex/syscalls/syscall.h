@@ -94,5 +94,14 @@
 #define SYS_sys_info		57
 #define SYS_sys_time		58
 #define SYS_sys_debug		59
+#define SYS_vm_share		60
+#define SYS_object_wait		61
+#define SYS_sys_bootlog		62
+#define SYS_msg_post		63
+#define SYS_msg_wait		64
+#define SYS_msg_sendv		65
+#define SYS_msg_receivev	66
+#define SYS_msg_replyv		67
+#define SYS_sys_trace		68
 
 #endif /* _SYSCALL_H */
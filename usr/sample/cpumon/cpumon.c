@@ -28,21 +28,85 @@
  */
 
 /*
- * cpumon.c - CPU voltage monitoring program
+ * cpumon.c - CPU voltage and usage monitoring program
  */
 
 #include <sys/prex.h>
 #include <sys/ioctl.h>
 #include <stdio.h>
+#include <string.h>
+
+#define NTOP		5	/* number of threads to display */
+
+/*
+ * CPU usage of a thread.
+ */
+struct usage {
+	thread_t	id;		/* thread id */
+	u_long		last;		/* running time at last check, in usec */
+	u_long		delta;		/* usec used in the last period */
+	char		name[MAXTASKNAME]; /* task name */
+};
 
 static struct cpufreqinfo cf_info;
+static struct usage usage[MAXTHREADS];
+static struct threadinfo ti;
+
+/*
+ * Collect the running time of all threads, and display the
+ * threads which used the CPU most in the last period.
+ */
+static void
+show_usage(u_long period)
+{
+	struct usage *u, *top[NTOP];
+	u_long rtime;
+	int i, j, n = 0;
+
+	memset(top, 0, sizeof(top));
+	ti.cookie = 0;
+	while (n < MAXTHREADS && sys_info(INFO_THREAD, &ti) == 0) {
+		rtime = (u_long)ti.rtime.tv_sec * 1000000 +
+			(u_long)ti.rtime.tv_usec;
+		u = &usage[n];
+		if (u->id != ti.id) {
+			/* New thread */
+			u->id = ti.id;
+			u->last = rtime;
+			strlcpy(u->name, ti.taskname, MAXTASKNAME);
+		}
+		u->delta = rtime - u->last;
+		u->last = rtime;
+
+		/*
+		 * Insert into the top list.
+		 */
+		for (i = 0; i < NTOP; i++) {
+			if (top[i] == NULL || u->delta > top[i]->delta) {
+				for (j = NTOP - 1; j > i; j--)
+					top[j] = top[j - 1];
+				top[i] = u;
+				break;
+			}
+		}
+		n++;
+	}
+
+	printf("\n\n\n\nThread   Task         CPU");
+	for (i = 0; i < NTOP; i++) {
+		if ((u = top[i]) == NULL)
+			break;
+		printf("\n%08x %-12s %3lu%%\33[K", (int)u->id, u->name,
+		       u->delta / (period / 100));
+	}
+}
 
 int
 main(int argc, char *argv[])
 {
 	device_t dev;
 	int last_mhz = 0;
-	int i, j;
+	int i, j, count = 0;
 	static char bar[21];
 
 	/* Boost current prioriy */
@@ -95,6 +159,16 @@ main(int argc, char *argv[])
 			printf("\33[u"); /* restore cursor */
 			last_mhz = cf_info.freq;
 		}
+
+		/*
+		 * Display CPU usage of threads every second.
+		 */
+		if (++count >= 100) {
+			printf("\33[s"); /* save cursor */
+			show_usage(1000000);
+			printf("\33[u"); /* restore cursor */
+			count = 0;
+		}
 	}
 	return 0;
 }
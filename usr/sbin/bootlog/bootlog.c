@@ -0,0 +1,75 @@
+/*-
+ * Copyright (c) 2009, Kohsuke Ohtani
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the author nor the names of any co-contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * bootlog.c - dump the boot time log.
+ */
+
+#include <sys/prex.h>
+#include <sys/sysinfo.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+int
+main(int argc, char *argv[])
+{
+	struct timerinfo ti;
+	struct bootlog bl;
+	u_long prev = 0;
+	u_long msec;
+
+	if (argc > 1) {
+		fputs("usage: bootlog\n", stderr);
+		exit(1);
+	}
+
+	sys_info(INFO_TIMER, &ti);
+
+	/*
+	 * The cycle counter is 32-bit wide.  So, the delta
+	 * is valid only for the short interval, and the
+	 * time in msec should be used for the long one.
+	 */
+	printf("STAGE                MSEC     CYCLES      DELTA\n");
+	printf("---------------- -------- ---------- ----------\n");
+
+	bl.cookie = 0;
+	while (sys_info(INFO_BOOTLOG, &bl) == 0) {
+		msec = bl.ticks * 1000 / ti.hz;
+		printf("%-16s %8lu %10lu ", bl.name, msec, bl.cycles);
+		if (prev != 0 && bl.cycles != 0)
+			printf("%10lu\n", bl.cycles - prev);
+		else
+			printf("%10s\n", "-");
+		prev = bl.cycles;
+	}
+	exit(0);
+	/* NOTREACHED */
+}
@@ -0,0 +1,219 @@
+/*-
+ * Copyright (c) 2009, Kohsuke Ohtani
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the author nor the names of any co-contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * evtrace.c - dump the kernel event trace.
+ */
+
+#include <sys/prex.h>
+#include <sys/trace.h>
+
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NREC	32
+
+static const struct {
+	const char	*name;
+	u_long		mask;
+} catnames[] = {
+	{ "sched",	TRC_SCHED },
+	{ "irq",	TRC_IRQ },
+	{ "ipc",	TRC_IPC },
+	{ "timer",	TRC_TIMER },
+	{ "page",	TRC_PAGE },
+	{ "syscall",	TRC_SYSCALL },
+	{ "all",	TRC_ALL },
+	{ "none",	0 },
+	{ NULL,		0 },
+};
+
+static const struct {
+	int		type;
+	const char	*name;
+} evnames[] = {
+	{ TR_SWITCH,	 "switch" },
+	{ TR_IRQ_ENTER,	 "irq_enter" },
+	{ TR_IRQ_EXIT,	 "irq_exit" },
+	{ TR_MSG_SEND,	 "msg_send" },
+	{ TR_MSG_RECV,	 "msg_recv" },
+	{ TR_MSG_REPLY,	 "msg_reply" },
+	{ TR_TIMER,	 "timer" },
+	{ TR_PAGE_ALLOC, "page_alloc" },
+	{ TR_PAGE_FREE,	 "page_free" },
+	{ TR_SYSCALL,	 "syscall" },
+	{ TR_SYSRET,	 "sysret" },
+	{ 0,		 NULL },
+};
+
+static void
+usage(void)
+{
+
+	fputs("usage: evtrace [-c] [-m category[,category...]]\n", stderr);
+	exit(1);
+}
+
+static const char *
+evname(int type)
+{
+	int i;
+
+	for (i = 0; evnames[i].name != NULL; i++) {
+		if (evnames[i].type == type)
+			return evnames[i].name;
+	}
+	return "?";
+}
+
+static u_long
+parse_mask(char *arg)
+{
+	char *name;
+	u_long mask = 0;
+	int i;
+
+	for (name = strtok(arg, ","); name != NULL;
+	     name = strtok(NULL, ",")) {
+		for (i = 0; catnames[i].name != NULL; i++) {
+			if (!strcmp(name, catnames[i].name))
+				break;
+		}
+		if (catnames[i].name == NULL) {
+			fprintf(stderr, "evtrace: unknown category %s\n",
+				name);
+			exit(1);
+		}
+		mask |= catnames[i].mask;
+	}
+	return mask;
+}
+
+static void
+print_mask(void)
+{
+	u_long mask;
+	int i;
+
+	if (sys_trace(TRACE_GETMASK, &mask) != 0) {
+		fputs("evtrace: trace is not available\n", stderr);
+		exit(1);
+	}
+	printf("categories:");
+	for (i = 0; catnames[i].mask != TRC_ALL; i++) {
+		if (mask & catnames[i].mask)
+			printf(" %s", catnames[i].name);
+	}
+	printf("\n");
+}
+
+/*
+ * Drain the trace buffer and print the timeline.
+ */
+static void
+dump(void)
+{
+	struct trace_rec rec[NREC];
+	struct trace_req req;
+	struct trace_rec *tr;
+	u_long prev = 0;
+	u_long lost = 0;
+	int i, first = 1;
+
+	printf("   TICKS     CYCLES      DELTA   THREAD EVENT          "
+	       "ARG0     ARG1\n");
+	printf("-------- ---------- ---------- -------- ---------- "
+	       "-------- --------\n");
+	for (;;) {
+		req.buf = rec;
+		req.count = NREC;
+		if (sys_trace(TRACE_READ, &req) != 0) {
+			fputs("evtrace: trace is not available\n", stderr);
+			exit(1);
+		}
+		lost += req.lost;
+		if (req.count == 0)
+			break;
+		for (i = 0; i < req.count; i++) {
+			tr = &rec[i];
+			printf("%8lu %10lu ", tr->ticks, tr->cycles);
+			if (!first && tr->cycles != 0)
+				printf("%10lu ", tr->cycles - prev);
+			else
+				printf("%10s ", "-");
+			printf("%08x %-10s %08lx %08lx\n", (int)tr->thread,
+			       evname(tr->type), tr->arg[0], tr->arg[1]);
+			prev = tr->cycles;
+			first = 0;
+		}
+	}
+	if (lost != 0)
+		printf("%lu records lost\n", lost);
+}
+
+int
+main(int argc, char *argv[])
+{
+	int ch, cflag = 0;
+	char *mflag = NULL;
+
+	while ((ch = getopt(argc, argv, "cm:")) != -1) {
+		switch (ch) {
+		case 'c':
+			cflag = 1;
+			break;
+		case 'm':
+			mflag = optarg;
+			break;
+		default:
+			usage();
+		}
+	}
+	if (optind < argc)
+		usage();
+
+	if (cflag || mflag != NULL) {
+		if (cflag && sys_trace(TRACE_CLEAR, NULL) != 0) {
+			fputs("evtrace: trace is not available\n", stderr);
+			exit(1);
+		}
+		if (mflag != NULL &&
+		    sys_trace(TRACE_SETMASK, (void *)parse_mask(mflag)) != 0) {
+			fputs("evtrace: trace is not available\n", stderr);
+			exit(1);
+		}
+		print_mask();
+		exit(0);
+	}
+	dump();
+	exit(0);
+	/* NOTREACHED */
+}
@@ -0,0 +1,231 @@
+/*-
+ * Copyright (c) 2009, Kohsuke Ohtani
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the author nor the names of any co-contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * ipcstat.c - show the IPC statistics.
+ */
+
+#include <sys/prex.h>
+#include <sys/sysinfo.h>
+#include <sys/dbgctl.h>
+#include <ipc/ipc.h>
+#include <ipc/proc.h>
+#include <ipc/fs.h>
+#include <ipc/exec.h>
+#include <ipc/pow.h>
+
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define MAXCODES	64	/* max codes to show per object */
+
+#define CODE(x)		{ x, #x }
+
+static const struct {
+	int		code;
+	const char	*name;
+} codenames[] = {
+	CODE(STD_NULL), CODE(STD_VERSION), CODE(STD_DEBUG),
+	CODE(STD_BOOT), CODE(STD_SHUTDOWN),
+	CODE(PS_GETPID), CODE(PS_GETPPID), CODE(PS_GETPGID),
+	CODE(PS_SETPGID), CODE(PS_SETSID), CODE(PS_GETSID),
+	CODE(PS_FORK), CODE(PS_EXIT), CODE(PS_STOP), CODE(PS_WAITPID),
+	CODE(PS_KILL), CODE(PS_EXEC), CODE(PS_PSTAT), CODE(PS_SETINIT),
+	CODE(PS_REGISTER), CODE(PS_TRACE),
+	CODE(FS_MOUNT), CODE(FS_UMOUNT), CODE(FS_SYNC), CODE(FS_OPEN),
+	CODE(FS_CLOSE), CODE(FS_MKNOD), CODE(FS_LSEEK), CODE(FS_READ),
+	CODE(FS_WRITE), CODE(FS_IOCTL), CODE(FS_FSYNC), CODE(FS_FSTAT),
+	CODE(FS_OPENDIR), CODE(FS_CLOSEDIR), CODE(FS_READDIR),
+	CODE(FS_REWINDDIR), CODE(FS_SEEKDIR), CODE(FS_TELLDIR),
+	CODE(FS_MKDIR), CODE(FS_RMDIR), CODE(FS_RENAME), CODE(FS_CHDIR),
+	CODE(FS_LINK), CODE(FS_UNLINK), CODE(FS_STAT), CODE(FS_GETCWD),
+	CODE(FS_DUP), CODE(FS_DUP2), CODE(FS_FCNTL), CODE(FS_ACCESS),
+	CODE(FS_FORK), CODE(FS_EXEC), CODE(FS_EXIT), CODE(FS_REGISTER),
+	CODE(FS_PIPE), CODE(FS_ISATTY), CODE(FS_TRUNCATE),
+	CODE(FS_FTRUNCATE), CODE(FS_FCHDIR), CODE(FS_PIPEMAP),
+	CODE(EXEC_EXECVE), CODE(EXEC_BINDCAP),
+	CODE(POW_SET_POWER), CODE(POW_GET_POLICY), CODE(POW_SET_POLICY),
+	CODE(POW_GET_SUSTMR), CODE(POW_SET_SUSTMR), CODE(POW_GET_DIMTMR),
+	CODE(POW_SET_DIMTMR), CODE(POW_BATTERY_LVL),
+	{ 0, NULL },
+};
+
+static struct ipcinfo		ii;
+static struct msgcodeinfo	codes[MAXCODES];
+static struct taskinfo		ti;
+
+static void
+usage(void)
+{
+
+	fputs("usage: ipcstat [-chr]\n", stderr);
+	exit(1);
+}
+
+static const char *
+code_name(int code)
+{
+	int i;
+
+	if (code == -1)
+		return "(other)";
+	for (i = 0; codenames[i].name != NULL; i++) {
+		if (codenames[i].code == code)
+			return codenames[i].name;
+	}
+	return NULL;
+}
+
+static const char *
+task_name(task_t task)
+{
+
+	ti.cookie = 0;
+	while (sys_info(INFO_TASK, &ti) == 0) {
+		if (ti.id == task)
+			return ti.taskname;
+	}
+	return "?";
+}
+
+/*
+ * Print the non-empty buckets of a round-trip time histogram.
+ */
+static void
+print_hist(struct lathist *hist)
+{
+	u_long lo, hi;
+	int i;
+
+	for (i = 0; i < NLATBUCKET; i++) {
+		if (hist->bucket[i] == 0)
+			continue;
+		lo = (i == 0) ? 0 : 1UL << (i - 1);
+		hi = 1UL << i;
+		if (i == NLATBUCKET - 1)
+			printf("        %6lu -        us %10lu\n", lo,
+			       hist->bucket[i]);
+		else
+			printf("        %6lu - %6lu us %10lu\n", lo, hi,
+			       hist->bucket[i]);
+	}
+}
+
+/*
+ * Show the message codes of an object, the most frequent first.
+ */
+static void
+show_codes(object_t obj, int hflag)
+{
+	struct msgcodeinfo tmp;
+	const char *name;
+	int i, j, n = 0;
+
+	codes[0].cookie = 0;
+	codes[0].object = obj;
+	while (n < MAXCODES && sys_info(INFO_MSGCODE, &codes[n]) == 0) {
+		if (n + 1 < MAXCODES) {
+			codes[n + 1].cookie = codes[n].cookie;
+			codes[n + 1].object = obj;
+		}
+		n++;
+	}
+	for (i = 1; i < n; i++) {
+		tmp = codes[i];
+		for (j = i; j > 0 && codes[j - 1].hist.count < tmp.hist.count;
+		     j--)
+			codes[j] = codes[j - 1];
+		codes[j] = tmp;
+	}
+	for (i = 0; i < n; i++) {
+		if ((name = code_name(codes[i].code)) != NULL)
+			printf("    %-16s", name);
+		else
+			printf("    0x%08x      ", codes[i].code);
+		printf(" %8lu %8lu %8lu\n", codes[i].hist.count,
+		       codes[i].rttavg, codes[i].hist.max);
+		if (hflag)
+			print_hist(&codes[i].hist);
+	}
+}
+
+int
+main(int argc, char *argv[])
+{
+	int ch, cflag = 0, hflag = 0, rflag = 0;
+
+	while ((ch = getopt(argc, argv, "chr")) != -1) {
+		switch (ch) {
+		case 'c':
+			cflag = 1;
+			break;
+		case 'h':
+			cflag = hflag = 1;
+			break;
+		case 'r':
+			rflag = 1;
+			break;
+		default:
+			usage();
+		}
+	}
+	if (optind < argc)
+		usage();
+
+	if (rflag) {
+		if (sys_debug(DBGC_IPCRESET, NULL) != 0) {
+			fputs("ipcstat: cannot reset statistics\n", stderr);
+			exit(1);
+		}
+		exit(0);
+	}
+
+	/*
+	 * Times are in usec.
+	 */
+	printf("  OBJECT TASK         NAME                 SEND     RECV "
+	       "QMAX   RTTAVG   RTTMAX        BUSY\n");
+	ii.cookie = 0;
+	while (sys_info(INFO_IPC, &ii) == 0) {
+		if (ii.nsend == 0)
+			continue;
+		printf("%08x %-12s %-16s %8lu %8lu %4d %8lu %8lu "
+		       "%4ld.%06ld\n", (int)ii.id, task_name(ii.owner),
+		       ii.name[0] != '\0' ? ii.name : "-",
+		       ii.nsend, ii.nrecv, ii.qmax, ii.rttavg, ii.rttmax,
+		       ii.busy.tv_sec, ii.busy.tv_usec);
+		if (cflag) {
+			printf("    CODE                COUNT   RTTAVG   "
+			       "RTTMAX\n");
+			show_codes(ii.id, hflag);
+		}
+	}
+	exit(0);
+}
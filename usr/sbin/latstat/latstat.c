@@ -0,0 +1,139 @@
+/*-
+ * Copyright (c) 2009, Kohsuke Ohtani
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the author nor the names of any co-contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * latstat.c - show the latency histograms.
+ */
+
+#include <sys/prex.h>
+#include <sys/sysinfo.h>
+#include <sys/dbgctl.h>
+
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static void
+usage(void)
+{
+
+	fputs("usage: latstat [-r]\n", stderr);
+	exit(1);
+}
+
+/*
+ * Print the non-empty buckets of a histogram.
+ */
+static void
+print_hist(struct lathist *hist)
+{
+	u_long lo, hi;
+	int i;
+
+	for (i = 0; i < NLATBUCKET; i++) {
+		if (hist->bucket[i] == 0)
+			continue;
+		lo = (i == 0) ? 0 : 1UL << (i - 1);
+		hi = 1UL << i;
+		if (i == NLATBUCKET - 1)
+			printf("    %6lu -        us %10lu\n", lo,
+			       hist->bucket[i]);
+		else
+			printf("    %6lu - %6lu us %10lu\n", lo, hi,
+			       hist->bucket[i]);
+	}
+}
+
+/*
+ * Wakeup to dispatch latency for each priority band.
+ */
+static void
+show_sched(void)
+{
+	static struct latinfo li;
+
+	printf("Wakeup to dispatch latency:\n");
+	li.cookie = 0;
+	while (sys_info(INFO_LATENCY, &li) == 0) {
+		if (li.lat.count == 0)
+			continue;
+		printf("  priority %3d-%3d: count %lu max %lu us\n",
+		       li.pri, li.pri + LATBANDPRI - 1,
+		       li.lat.count, li.lat.max);
+		print_hist(&li.lat);
+	}
+}
+
+/*
+ * ISR to IST latency for each irq.
+ */
+static void
+show_irq(void)
+{
+	static struct irqinfo ii;
+
+	printf("ISR to IST latency:\n");
+	ii.cookie = 0;
+	while (sys_info(INFO_IRQ, &ii) == 0) {
+		if (ii.istlat.count == 0)
+			continue;
+		printf("  irq %2d: count %lu max %lu us\n",
+		       ii.vector, ii.istlat.count, ii.istlat.max);
+		print_hist(&ii.istlat);
+	}
+}
+
+int
+main(int argc, char *argv[])
+{
+	int ch, rflag = 0;
+
+	while ((ch = getopt(argc, argv, "r")) != -1) {
+		switch (ch) {
+		case 'r':
+			rflag = 1;
+			break;
+		default:
+			usage();
+		}
+	}
+	if (optind < argc)
+		usage();
+
+	if (rflag) {
+		if (sys_debug(DBGC_LATRESET, NULL) != 0) {
+			fputs("latstat: cannot reset histograms\n", stderr);
+			exit(1);
+		}
+		exit(0);
+	}
+	show_sched();
+	show_irq();
+	exit(0);
+}
@@ -0,0 +1,176 @@
+/*-
+ * Copyright (c) 2009, Kohsuke Ohtani
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the author nor the names of any co-contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * lockstat.c - show the lock contention statistics.
+ */
+
+#include <sys/prex.h>
+#include <sys/dbgctl.h>
+#include <sys/lockstat.h>
+
+#include <unistd.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAXENT		256	/* max entries to show */
+
+static struct lockstat	ent[MAXENT];
+static struct taskinfo	ti;
+
+static void
+usage(void)
+{
+
+	fputs("usage: lockstat [-r]\n", stderr);
+	exit(1);
+}
+
+/*
+ * Sort by the contended count, then by the acquisitions.
+ */
+static int
+entcmp(const void *a, const void *b)
+{
+	const struct lockstat *l1 = a, *l2 = b;
+
+	if (l1->cnt.contended != l2->cnt.contended)
+		return (l1->cnt.contended < l2->cnt.contended) ? 1 : -1;
+	if (l1->cnt.count != l2->cnt.count)
+		return (l1->cnt.count < l2->cnt.count) ? 1 : -1;
+	return 0;
+}
+
+/*
+ * Read all entries of the specified lock type.
+ */
+static int
+read_stat(int type)
+{
+	int n = 0;
+
+	ent[0].type = type;
+	ent[0].cookie = 0;
+	while (n < MAXENT) {
+		if (sys_debug(DBGC_LOCKSTAT, &ent[n]) != 0)
+			break;
+		if (n + 1 < MAXENT) {
+			ent[n + 1].type = type;
+			ent[n + 1].cookie = ent[n].cookie;
+		}
+		if (ent[n].cnt.count != 0)
+			n++;
+	}
+	qsort(ent, (size_t)n, sizeof(struct lockstat), entcmp);
+	return n;
+}
+
+static const char *
+task_name(task_t task)
+{
+
+	ti.cookie = 0;
+	while (sys_info(INFO_TASK, &ti) == 0) {
+		if (ti.id == task)
+			return ti.taskname;
+	}
+	return "?";
+}
+
+static void
+print_cnt(struct lockcnt *cnt)
+{
+
+	printf(" %8lu %8lu %8lu %8lu %8lu %8lu\n", cnt->count,
+	       cnt->contended, cnt->waittime,
+	       cnt->contended ? cnt->waittime / cnt->contended : 0,
+	       cnt->waitmax, cnt->holdmax);
+}
+
+int
+main(int argc, char *argv[])
+{
+	int ch, i, n, rc, rflag = 0;
+
+	while ((ch = getopt(argc, argv, "r")) != -1) {
+		switch (ch) {
+		case 'r':
+			rflag = 1;
+			break;
+		default:
+			usage();
+		}
+	}
+	if (optind < argc)
+		usage();
+
+	if (rflag) {
+		if (sys_debug(DBGC_LOCKRESET, NULL) != 0) {
+			fputs("lockstat: cannot reset statistics\n", stderr);
+			exit(1);
+		}
+		exit(0);
+	}
+
+	ent[0].type = LS_SCHED;
+	ent[0].cookie = 0;
+	rc = sys_debug(DBGC_LOCKSTAT, &ent[0]);
+	if (rc != 0 && rc != ESRCH) {
+		fputs("lockstat: lock statistics are not available\n",
+		      stderr);
+		exit(1);
+	}
+
+	/*
+	 * Times are in usec.
+	 */
+	n = read_stat(LS_SCHED);
+	printf("sched_lock call sites:\n");
+	printf("    SITE                 COUNT  CONTEND     WAIT  "
+	       "WAITAVG  WAITMAX  HOLDMAX\n");
+	for (i = 0; i < n; i++) {
+		if (ent[i].id == 0)
+			printf("   other             ");
+		else
+			printf("%08lx             ", ent[i].id);
+		print_cnt(&ent[i].cnt);
+	}
+
+	n = read_stat(LS_MUTEX);
+	printf("\nmutexes:\n");
+	printf("   MUTEX TASK            COUNT  CONTEND     WAIT  "
+	       "WAITAVG  WAITMAX  HOLDMAX\n");
+	for (i = 0; i < n; i++) {
+		printf("%08lx %-12s", ent[i].id, task_name(ent[i].task));
+		print_cnt(&ent[i].cnt);
+	}
+	exit(0);
+}
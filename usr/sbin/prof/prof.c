@@ -0,0 +1,154 @@
+/*-
+ * Copyright (c) 2009, Kohsuke Ohtani
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the author nor the names of any co-contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * prof.c - sampling profiler.
+ *
+ * The samples are written in the text format below, and they
+ * are resolved to the symbols by the host tool (tools/profsym).
+ *
+ *	prex-profile 1
+ *	hz <ticks per second>
+ *	<pc> <task> <thread>
+ *	...
+ *	drvtext <text address of driver>
+ *	task <task> <name>
+ *	...
+ */
+
+#include <sys/prex.h>
+#include <sys/sysinfo.h>
+#include <sys/prof.h>
+
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define NSAMPLE		64	/* samples read at once */
+#define INTERVAL	100	/* msec to drain the samples */
+
+static struct prof_sample samples[NSAMPLE];
+
+static void
+usage(void)
+{
+
+	fputs("usage: prof [-t seconds] [-o file]\n", stderr);
+	exit(1);
+}
+
+/*
+ * Drain the samples in the kernel buffer.
+ */
+static u_long
+drain(FILE *fp, vaddr_t *drvtext, u_long *lost)
+{
+	struct prof_req req;
+	u_long total = 0;
+	int i;
+
+	do {
+		req.buf = samples;
+		req.count = NSAMPLE;
+		if (sys_debug(DBGC_PROFREAD, &req) != 0) {
+			fputs("prof: profiler is not available\n", stderr);
+			exit(1);
+		}
+		for (i = 0; i < req.count; i++) {
+			fprintf(fp, "%08lx %08x %08x\n",
+				(u_long)samples[i].pc, (int)samples[i].task,
+				(int)samples[i].thread);
+		}
+		*drvtext = req.drvtext;
+		*lost += req.lost;
+		total += (u_long)req.count;
+	} while (req.count == NSAMPLE);
+	return total;
+}
+
+int
+main(int argc, char *argv[])
+{
+	struct timerinfo ti;
+	struct taskinfo tk;
+	FILE *fp = stdout;
+	vaddr_t drvtext = 0;
+	u_long start, now, nsamples = 0, lost = 0;
+	int ch, sec = 10;
+
+	while ((ch = getopt(argc, argv, "t:o:")) != -1) {
+		switch (ch) {
+		case 't':
+			sec = atoi(optarg);
+			break;
+		case 'o':
+			if ((fp = fopen(optarg, "w")) == NULL) {
+				perror(optarg);
+				exit(1);
+			}
+			break;
+		default:
+			usage();
+		}
+	}
+	if (optind < argc || sec <= 0)
+		usage();
+
+	sys_info(INFO_TIMER, &ti);
+	fprintf(fp, "prex-profile 1\n");
+	fprintf(fp, "hz %d\n", ti.hz);
+
+	if (sys_debug(DBGC_PROFSTART, NULL) != 0) {
+		fputs("prof: profiler is not available\n", stderr);
+		exit(1);
+	}
+	sys_time(&start);
+	do {
+		timer_sleep(INTERVAL, NULL);
+		nsamples += drain(fp, &drvtext, &lost);
+		sys_time(&now);
+	} while (now - start < (u_long)sec * ti.hz);
+	sys_debug(DBGC_PROFSTOP, NULL);
+	nsamples += drain(fp, &drvtext, &lost);
+
+	fprintf(fp, "drvtext %08lx\n", (u_long)drvtext);
+
+	/*
+	 * Dump the task names to find the image of each task.
+	 */
+	tk.cookie = 0;
+	while (sys_info(INFO_TASK, &tk) == 0)
+		fprintf(fp, "task %08x %s\n", (int)tk.id, tk.taskname);
+
+	if (fp != stdout)
+		fclose(fp);
+	fprintf(stderr, "prof: %lu samples, %lu lost\n", nsamples, lost);
+	exit(0);
+	/* NOTREACHED */
+}
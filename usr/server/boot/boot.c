@@ -68,6 +68,12 @@ static const char *initenvs[] = { "TERM=vt100", "USER=root", NULL };
 
 static char iobuf[BUFSIZ];
 
+static object_t	bootobj;	/* server booted by the helper thread */
+static const char *bootname;	/* its name for the boot log */
+static sem_t	bootsem;	/* signaled when the helper finished */
+static thread_t	bootthread;	/* helper thread */
+static void	*bootstack;	/* its stack, or NULL if not started */
+
 /*
  * Base directories at root.
  */
@@ -85,29 +91,17 @@ static char *base_dir[] = {
 static void
 wait_server(const char *name, object_t *pobj)
 {
-	int i, error = 0;
-
-	/* Give chance to run other servers. */
-	thread_yield();
 
 	/*
-	 * Wait for server loading. timeout is 1 sec.
+	 * Sleep until the server creates its object.
+	 * timeout is 1 sec.
 	 */
-	for (i = 0; i < 100; i++) {
-		error = object_lookup((char *)name, pobj);
-		if (error == 0)
-			break;
-
-		/* Wait 10msec */
-		timer_sleep(10, 0);
-		thread_yield();
-	}
-	if (error)
+	if (object_wait(name, pobj, 1000) != 0)
 		sys_panic("boot: server not found");
 }
 
 static void
-send_bootmsg(object_t obj)
+send_bootmsg(object_t obj, const char *name)
 {
 	struct msg m;
 	int error;
@@ -116,6 +110,77 @@ send_bootmsg(object_t obj)
 	error = msg_send(obj, &m, sizeof(m));
 	if (error)
 		sys_panic("boot: server error");
+
+	/* Record the end of the handshake. */
+	sys_bootlog(name);
+}
+
+/*
+ * Helper thread to send a boot message in parallel
+ * with the main thread. It does not terminate itself,
+ * because the main thread frees its stack.
+ */
+static void
+boot_thread(void)
+{
+
+	send_bootmsg(bootobj, bootname);
+	sem_post(&bootsem);
+	for (;;)
+		thread_suspend(thread_self());
+}
+
+static void
+send_bootmsg_async(object_t obj, const char *name)
+{
+	task_t self;
+	thread_t t;
+	void *stack, *sp;
+
+	bootobj = obj;
+	bootname = name;
+	self = task_self();
+	if (sem_init(&bootsem, 0) != 0)
+		goto sync;
+	if (thread_create(self, &t) != 0)
+		goto err1;
+	if (vm_allocate(self, &stack, DFLSTKSZ, 1) != 0)
+		goto err2;
+
+	sp = (void *)((u_long)stack + DFLSTKSZ - sizeof(u_long) * 3);
+	if (thread_load(t, boot_thread, sp) != 0 ||
+	    thread_resume(t) != 0)
+		goto err3;
+	bootthread = t;
+	bootstack = stack;
+	return;
+ err3:
+	vm_free(self, stack);
+ err2:
+	thread_terminate(t);
+ err1:
+	sem_destroy(&bootsem);
+ sync:
+	/* Fall back to the synchronous request. */
+	send_bootmsg(obj, name);
+}
+
+/*
+ * Wait for the helper thread to finish the boot message,
+ * and release the thread and its stack.
+ */
+static void
+wait_bootmsg(void)
+{
+
+	if (bootstack == NULL)
+		return;
+	while (sem_wait(&bootsem, 0) == EINTR)
+		;
+	thread_terminate(bootthread);
+	vm_free(task_self(), bootstack);
+	sem_destroy(&bootsem);
+	bootstack = NULL;
 }
 
 static void
@@ -270,6 +335,7 @@ main(int argc, char *argv[])
 	struct msg m;
 
 	sys_log("Starting bootstrap server\n");
+	sys_bootlog("boot");
 
 	thread_setpri(thread_self(), PRI_DEFAULT);
 
@@ -280,15 +346,22 @@ main(int argc, char *argv[])
 	wait_server("!proc", &procobj);
 	wait_server("!fs", &fsobj);
 	wait_server("!exec", &execobj);
+	sys_bootlog("servers");
 
 	/*
 	 * Send boot message to all servers.
 	 * This is required to synchronize the server
 	 * initialization without deadlock.
+	 *
+	 * The exec server must be booted first because it
+	 * registers itself to the proc and fs servers.  After
+	 * that, proc and fs depend only on exec, so their
+	 * boot messages are processed in parallel.
 	 */
-	send_bootmsg(execobj);
-	send_bootmsg(procobj);
-	send_bootmsg(fsobj);
+	send_bootmsg(execobj, "exec");
+	send_bootmsg_async(fsobj, "fs");
+	send_bootmsg(procobj, "proc");
+	wait_bootmsg();
 
 	/*
 	 * Request to bind a new capabilities for us.
@@ -313,6 +386,7 @@ main(int argc, char *argv[])
 	 * Mount file systems.
 	 */
 	mount_fs();
+	sys_bootlog("mount");
 
 	/*
 	 * Copy some files.
@@ -321,6 +395,7 @@ main(int argc, char *argv[])
 	 */
 	copy_file("/boot/rc", "/etc/rc");
 	copy_file("/boot/fstab", "/etc/fstab");
+	sys_bootlog("init");
 
 	/*
 	 * Exec first application.
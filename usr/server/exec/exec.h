@@ -35,6 +35,7 @@
 #include <sys/elf.h>
 #include <sys/param.h>
 #include <sys/stat.h>
+#include <sys/pool.h>
 #include <ipc/exec.h>
 
 #include <unistd.h>
@@ -96,6 +97,7 @@ struct cap_map {
 extern struct exec_loader loader_table[];
 extern const struct cap_map cap_table[];
 extern const int nloader;
+extern struct arena exec_arena;
 
 __BEGIN_DECLS
 void	 bind_cap(char *, task_t);
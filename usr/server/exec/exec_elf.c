@@ -204,7 +204,7 @@ load_reloc(Elf32_Ehdr *ehdr, task_t task, int fd, vaddr_t *entry)
 
 	/* Read section header */
 	shdr_size = ehdr->e_shentsize * ehdr->e_shnum;
-	if ((buf = malloc(shdr_size)) == NULL) {
+	if ((buf = arena_alloc(&exec_arena, shdr_size)) == NULL) {
 		error = ENOMEM;
 		goto out0;
 	}
@@ -274,7 +274,8 @@ load_reloc(Elf32_Ehdr *ehdr, task_t task, int fd, vaddr_t *entry)
 			   shdr->sh_type == SHT_REL)
 		{
 
-			if ((addr = malloc(shdr->sh_size)) == NULL) {
+			addr = arena_alloc(&exec_arena, shdr->sh_size);
+			if (addr == NULL) {
 				error = ENOMEM;
 				goto out2;
 			}
@@ -306,19 +307,9 @@ load_reloc(Elf32_Ehdr *ehdr, task_t task, int fd, vaddr_t *entry)
 	*entry = (vaddr_t)((u_long)mapped + ehdr->e_entry);
 	DPRINTF(("exec: entry=%x\n", *entry));
  out2:
-	/* Release symbol table */
-	shdr = (Elf32_Shdr *)buf;
-	for (i = 0; i < ehdr->e_shnum; i++, shdr++) {
-		if (shdr->sh_type == SHT_SYMTAB ||
-		    shdr->sh_type == SHT_RELA ||
-		    shdr->sh_type == SHT_REL) {
-			if (sect_addr[i])
-				free(sect_addr[i]);
-		}
-	}
 	vm_free(task_self(), mapped);
  out1:
-	free(buf);
+	/* The section buffers are released with the arena. */
  out0:
 	DPRINTF(("exec: load_reloc ret=%d\n", error));
 	return error;
@@ -66,6 +66,16 @@ struct msg_map {
 
 #define MSGMAP(code, fn) {code, (int (*)(struct msg *))fn}
 
+/*
+ * Scratch memory for the request being handled.
+ * It is released after the reply.  The arena hands out
+ * 8-byte aligned blocks, so the buffer must be aligned as well.
+ */
+#define ARENA_SIZE	4096
+
+static double arena_buf[ARENA_SIZE / sizeof(double)] __aligned(8);
+struct arena exec_arena = ARENA_INITIALIZER(arena_buf);
+
 static const struct msg_map execmsg_map[] = {
 	MSGMAP(EXEC_EXECVE,	exec_execve),
 	MSGMAP(EXEC_BINDCAP,	exec_bindcap),
@@ -231,5 +241,6 @@ main(int argc, char *argv[])
 		 */
 		msg->hdr.status = error;
 		error = msg_reply(obj, msg, MAX_EXECMSG);
+		arena_reset(&exec_arena);
 	}
 }
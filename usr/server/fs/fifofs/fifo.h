@@ -45,6 +45,27 @@
 #define ASSERT(e)
 #endif
 
+/*
+ * Pipe buffer size.
+ * The capacity of each FIFO can be changed by F_SETPIPE_SZ
+ * within FIFO_MINBUF and FIFO_MAXBUF. A writer blocked on the
+ * full buffer is not woken until the data drops to the low
+ * water mark.
+ */
+#define FIFO_MINBUF	PIPE_BUF		/* min buffer size */
+#define FIFO_MAXBUF	(64 * 1024)		/* max buffer size */
+#define FIFO_DEFBUF	(4 * PIPE_BUF)		/* default buffer size */
+#define FIFO_LOWAT(sz)	((sz) / 4)		/* low water mark */
+
+/*
+ * Shared pipe ring.
+ * The server polls the ring semaphores, which the clients can
+ * hold, every FIFO_POLLTMO msec.
+ */
+#define FIFO_POLLTMO	100		/* msec to poll ring state */
+#define FIFO_RETRY	10		/* retries to destroy semaphore */
+#define FIFO_MAXWAIT	64		/* max waiters woken at once */
+
 #if CONFIG_FS_THREADS > 1
 #define malloc(s)		malloc_r(s)
 #define free(p)			free_r(p)
@@ -39,6 +39,10 @@
 #include <sys/syslog.h>
 #include <sys/dirent.h>
 #include <sys/list.h>
+#include <sys/pool.h>
+#include <sys/ioctl.h>
+#include <sys/posix.h>
+#include <ipc/fs.h>
 
 #include <ctype.h>
 #include <unistd.h>
@@ -46,6 +50,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <limits.h>
+#include <stddef.h>
 #include <fcntl.h>
 
 #include "fifo.h"
@@ -60,9 +65,18 @@ struct fifo_node {
 	mutex_t	fn_wmtx;	/* mutex for write */
 	int	fn_readers;	/* reader count */
 	int	fn_writers;	/* writer count */
-	int	fn_start;	/* start offset of buffer data */
-	int	fn_size;	/* size of buffer data */
+	size_t	fn_start;	/* start offset of buffer data */
+	size_t	fn_size;	/* size of buffer data */
+	size_t	fn_bufsz;	/* size of buffer */
+	size_t	fn_lowat;	/* low water mark to wake writers */
 	char	*fn_buf;	/* pointer to buffer */
+	struct pipe_ring *fn_ring; /* shared ring for pipe */
+	size_t	fn_ringsz;	/* size of data area in ring */
+	sem_t	fn_plock;	/* lock for ring */
+	sem_t	fn_prsem;	/* readers wait for data */
+	sem_t	fn_pwsem;	/* writers wait for space */
+	int	fn_busy;	/* server threads using ring */
+	int	fn_dead;	/* true if ring is being destroyed */
 };
 
 #define fifo_mount	((vfsop_mount_t)vfs_nullop)
@@ -91,6 +105,16 @@ static int fifo_remove	(vnode_t, vnode_t, char *);
 #define fifo_truncate	((vnop_truncate_t)vop_nullop)
 
 static void cleanup_fifo(vnode_t);
+static int create_ring(struct fifo_node *);
+static void destroy_ring(struct fifo_node *);
+static int release_sem(sem_t *);
+static int read_ring(vnode_t, char *, size_t, size_t *);
+static int write_ring(vnode_t, const char *, size_t, size_t *);
+static void update_ring(struct fifo_node *);
+static void recover_ring(struct fifo_node *);
+static int resize_fifo(struct fifo_node *, size_t);
+static void copyout_fifo(struct fifo_node *, char *, size_t);
+static void copyin_fifo(struct fifo_node *, const char *, size_t);
 static void wait_reader(vnode_t);
 static void wakeup_reader(vnode_t);
 static void wait_writer(vnode_t);
@@ -98,10 +122,20 @@ static void wakeup_writer(vnode_t);
 
 #if CONFIG_FS_THREADS > 1
 static mutex_t fifo_lock = MUTEX_INITIALIZER;
+#define FIFO_POOL	POOL_LOCKED
+#else
+#define FIFO_POOL	0
 #endif
 
 static struct list fifo_head;
 
+/*
+ * Pools for FIFO nodes and buffers of the default size.
+ */
+static struct pool node_pool =
+	POOL_INITIALIZER(sizeof(struct fifo_node), FIFO_POOL);
+static struct pool buf_pool = POOL_INITIALIZER(FIFO_DEFBUF, FIFO_POOL);
+
 /*
  * vnode operations
  */
@@ -161,6 +195,8 @@ fifo_open(vnode_t vp, int flags)
 			wakeup_reader(vp);
 		np->fn_writers++;
 	}
+	if (np->fn_ring != NULL)
+		update_ring(np);
 
 	/*
 	 * If no-one opens FIFO at the other side, wait for open().
@@ -204,6 +240,9 @@ fifo_close(vnode_t vp, file_t fp)
 		if (np->fn_writers == 0)
 			wakeup_reader(vp);
 	}
+	if (np->fn_ring != NULL)
+		update_ring(np);
+
 	if (vp->v_refcnt > 1)
 		return 0;
 
@@ -219,15 +258,16 @@ static int
 fifo_read(vnode_t vp, file_t fp, void *buf, size_t size, size_t *result)
 {
 	struct fifo_node *np = vp->v_data;
-	char *p = buf;
-	u_int pos, nbytes;
+	size_t nbytes;
 
 	DPRINTF(("fifo_read\n"));
 
 	/*
 	 * If nothing in the pipe, wait.
+	 * The pipe may be switched to the shared ring while
+	 * we are waiting.
 	 */
-	while (np->fn_size == 0) {
+	while (np->fn_ring == NULL && np->fn_size == 0) {
 		/*
 		 * No data and no writer, then EOF
 		 */
@@ -240,23 +280,22 @@ fifo_read(vnode_t vp, file_t fp, void *buf, size_t size, size_t *result)
 		 */
 		wait_writer(vp);
 	}
+	if (np->fn_ring != NULL)
+		return read_ring(vp, buf, size, result);
+
 	/*
 	 * Read
 	 */
 	nbytes = (np->fn_size < size) ? np->fn_size : size;
-	np->fn_size -= nbytes;
+	copyout_fifo(np, buf, nbytes);
 	*result = nbytes;
 
-	pos = np->fn_start;
-	while (nbytes > 0) {
-		*p++ = np->fn_buf[pos];
-		if (++pos > PIPE_BUF)
-			pos = 0;
-		nbytes--;
-	}
-	np->fn_start = pos;
-
-	wakeup_writer(vp);
+	/*
+	 * Wake writers only when the buffer drains to the
+	 * low water mark, so that they can refill it in bulk.
+	 */
+	if (np->fn_size <= np->fn_lowat)
+		wakeup_writer(vp);
 	return 0;
 }
 
@@ -265,7 +304,8 @@ fifo_write(vnode_t vp, file_t fp, void *buf, size_t size, size_t *result)
 {
 	struct fifo_node *np = vp->v_data;
 	char *p = buf;
-	u_int pos, nfree, nbytes, count = 0;
+	size_t nfree, nbytes, count = 0;
+	int error;
 
 	DPRINTF(("fifo_write\n"));
 
@@ -275,27 +315,26 @@ fifo_write(vnode_t vp, file_t fp, void *buf, size_t size, size_t *result)
 	 * wait for reads to deplete
 	 * and truncate it.
 	 */
-	while (np->fn_size >= PIPE_BUF)
+	while (np->fn_ring == NULL && np->fn_size >= np->fn_bufsz)
 		wait_reader(vp);
 
+	if (np->fn_ring != NULL) {
+		error = write_ring(vp, p, size, &nbytes);
+		if (count > 0)
+			error = 0;
+		*result = count + nbytes;
+		return error;
+	}
+
 	/*
 	 * Write
 	 */
-	nfree = PIPE_BUF - np->fn_size;
+	nfree = np->fn_bufsz - np->fn_size;
 	nbytes = (nfree < size) ? nfree : size;
-
-	pos = np->fn_start + np->fn_size;
-	if (pos >= PIPE_BUF)
-		pos -= PIPE_BUF;
-	np->fn_size += nbytes;
+	copyin_fifo(np, p, nbytes);
+	p += nbytes;
 	size -= nbytes;
-	while (nbytes > 0) {
-		np->fn_buf[pos] = *p++;
-		if (++pos > PIPE_BUF)
-			pos = 0;
-		nbytes--;
-		count++;
-	}
+	count += nbytes;
 
 	wakeup_reader(vp);
 
@@ -309,8 +348,54 @@ fifo_write(vnode_t vp, file_t fp, void *buf, size_t size, size_t *result)
 static int
 fifo_ioctl(vnode_t vp, file_t fp, u_long cmd, void *arg)
 {
+	struct fifo_node *np = vp->v_data;
+	int size;
+
 	DPRINTF(("fifo_ioctl\n"));
-	return EINVAL;
+
+	if (np == NULL)
+		return EINVAL;
+
+	switch (cmd) {
+	case FIFOIOC_GET_SIZE:
+		if (np->fn_ring != NULL)
+			*(int *)arg = (int)np->fn_ringsz;
+		else
+			*(int *)arg = (int)np->fn_bufsz;
+		break;
+	case FIFOIOC_SET_SIZE:
+		size = *(int *)arg;
+		if (size <= 0 || size > FIFO_MAXBUF)
+			return EINVAL;
+		/* The shared ring is already mapped by the clients. */
+		if (np->fn_ring != NULL)
+			return EBUSY;
+		return resize_fifo(np, (size_t)size);
+	case FIFOIOC_GET_RING:
+		/*
+		 * The ring is created at the first request, so
+		 * that the size of the pipe can be changed until
+		 * a client starts to use it.
+		 */
+		if (np->fn_ring == NULL) {
+			if (strncmp(np->fn_name, "pipe", 4))
+				return EINVAL;
+			if (create_ring(np) != 0)
+				return ENOMEM;
+			wakeup_reader(vp);
+			wakeup_writer(vp);
+		}
+		*(struct pipe_ring **)arg = np->fn_ring;
+		break;
+	case FIFOIOC_RECOVER:
+		if (np->fn_ring == NULL)
+			return EINVAL;
+		recover_ring(np);
+		break;
+	default:
+		return EINVAL;
+	}
+	return 0;
 }
 
 static int
@@ -361,18 +446,22 @@ fifo_create(vnode_t dvp, char *name, mode_t mode)
 		return EINVAL;
 #endif
 
-	if ((np = malloc(sizeof(struct fifo_node))) == NULL)
+	if ((np = pool_get(&node_pool)) == NULL)
 		return ENOMEM;
 
-	if ((np->fn_buf = malloc(PIPE_BUF)) == NULL) {
-		free(np);
+	/*
+	 * A pipe moves its data to the ring shared with the
+	 * clients when the ring is requested.
+	 */
+	if ((np->fn_buf = pool_get(&buf_pool)) == NULL) {
+		pool_put(&node_pool, np);
 		return ENOMEM;
 	}
 	len = strlen(name) + 1;
 	np->fn_name = malloc(len);
 	if (np->fn_name == NULL) {
-		free(np->fn_buf);
-		free(np);
+		pool_put(&buf_pool, np->fn_buf);
+		pool_put(&node_pool, np);
 		return ENOMEM;
 	}
 
@@ -385,6 +474,12 @@ fifo_create(vnode_t dvp, char *name, mode_t mode)
 	np->fn_writers = 0;
 	np->fn_start = 0;
 	np->fn_size = 0;
+	np->fn_bufsz = FIFO_DEFBUF;
+	np->fn_lowat = FIFO_LOWAT(FIFO_DEFBUF);
+	np->fn_ring = NULL;
+	np->fn_ringsz = 0;
+	np->fn_busy = 0;
+	np->fn_dead = 0;
 
 	mutex_lock(&fifo_lock);
 	list_insert(&fifo_head, &np->fn_link);
@@ -392,6 +487,16 @@ fifo_create(vnode_t dvp, char *name, mode_t mode)
 	return 0;
 }
 
+static void
+free_buf(char *buf, size_t size)
+{
+
+	if (size == FIFO_DEFBUF)
+		pool_put(&buf_pool, buf);
+	else
+		free(buf);
+}
+
 static void
 cleanup_fifo(vnode_t vp)
 {
@@ -402,12 +507,449 @@ cleanup_fifo(vnode_t vp)
 	mutex_unlock(&fifo_lock);
 
 	free(np->fn_name);
-	free(np->fn_buf);
-	free(np);
+	if (np->fn_ring != NULL)
+		destroy_ring(np);
+	else
+		free_buf(np->fn_buf, np->fn_bufsz);
+	pool_put(&node_pool, np);
 
 	vp->v_data = NULL;
 }
 
+/*
+ * Allocate the shared ring for a pipe, and move the buffered
+ * data into it. The ring is page aligned so that it can be
+ * shared with the client tasks by vm_share().
+ *
+ * The clients can write to any field of the ring. So, the
+ * server keeps its own copy of the size and the semaphores,
+ * and it never trusts the indices found in the ring.
+ */
+static int
+create_ring(struct fifo_node *np)
+{
+	struct pipe_ring *pr = NULL;
+	size_t size;
+
+	size = round_page(offsetof(struct pipe_ring, pr_buf) + np->fn_bufsz);
+	if (size < PIPE_RINGSZ)
+		size = PIPE_RINGSZ;
+	if (vm_allocate(task_self(), (void **)&pr, size, 1) != 0)
+		return ENOMEM;
+
+	np->fn_plock = SEM_NULL;
+	np->fn_prsem = SEM_NULL;
+	np->fn_pwsem = SEM_NULL;
+	if (sem_init(&np->fn_plock, 1) != 0)
+		goto err1;
+	if (sem_init(&np->fn_prsem, 0) != 0)
+		goto err2;
+	if (sem_init(&np->fn_pwsem, 0) != 0)
+		goto err3;
+
+	pr->pr_lock = np->fn_plock;
+	pr->pr_owner = 0;
+	pr->pr_rsem = np->fn_prsem;
+	pr->pr_wsem = np->fn_pwsem;
+	pr->pr_readers = np->fn_readers;
+	pr->pr_writers = np->fn_writers;
+	pr->pr_size = size - offsetof(struct pipe_ring, pr_buf);
+	pr->pr_lowat = FIFO_LOWAT(pr->pr_size);
+	pr->pr_start = 0;
+	pr->pr_count = np->fn_size;
+	copyout_fifo(np, pr->pr_buf, np->fn_size);
+	free_buf(np->fn_buf, np->fn_bufsz);
+
+	np->fn_buf = NULL;
+	np->fn_ring = pr;
+	np->fn_ringsz = pr->pr_size;
+	np->fn_lowat = pr->pr_lowat;
+	return 0;
+
+ err3:
+	release_sem(&np->fn_prsem);
+ err2:
+	release_sem(&np->fn_plock);
+ err1:
+	vm_free(task_self(), pr);
+	return ENOMEM;
+}
+
+/*
+ * Release the shared ring.
+ * The server threads sleeping on the ring are woken, and
+ * the ring is unmapped after all of them have left. The pages
+ * are freed by the kernel when the last client unmaps them.
+ */
+static void
+destroy_ring(struct fifo_node *np)
+{
+	struct pipe_ring *pr = np->fn_ring;
+	int busy, error;
+
+	np->fn_dead = 1;
+	for (;;) {
+		mutex_lock(&fifo_lock);
+		busy = np->fn_busy;
+		mutex_unlock(&fifo_lock);
+		if (busy == 0)
+			break;
+		sem_post(&np->fn_prsem);
+		sem_post(&np->fn_pwsem);
+		timer_sleep(FIFO_POLLTMO, 0);
+	}
+
+	error = release_sem(&np->fn_prsem);
+	error |= release_sem(&np->fn_pwsem);
+	error |= release_sem(&np->fn_plock);
+
+	/*
+	 * If some client still sleeps on the ring, we leave
+	 * the ring mapped rather than pulling it from under
+	 * the semaphores.
+	 */
+	if (error == 0)
+		vm_free(task_self(), pr);
+	np->fn_ring = NULL;
+}
+
+/*
+ * Destroy the semaphore of the ring.
+ * sem_destroy() fails while a client thread is waiting for
+ * the semaphore, so such threads are woken up first.
+ */
+static int
+release_sem(sem_t *sp)
+{
+	int i;
+
+	for (i = 0; i < FIFO_RETRY; i++) {
+		if (sem_init(sp, 1) == 0 && sem_destroy(sp) == 0)
+			return 0;
+		sem_post(sp);
+		timer_sleep(FIFO_POLLTMO, 0);
+	}
+	return EBUSY;
+}
+
+/*
+ * Lock the ring, or wait on the semaphore of the ring.
+ * The clients share these semaphores, so we never sleep on
+ * them for long without checking if the ring is going away.
+ */
+static int
+wait_ring(struct fifo_node *np, sem_t *sp)
+{
+	int error;
+
+	for (;;) {
+		if (np->fn_dead)
+			return EBADF;
+		error = sem_wait(sp, FIFO_POLLTMO);
+		if (error != ETIMEDOUT)
+			return error;
+		if (sp == &np->fn_plock)
+			recover_ring(np);
+	}
+}
+
+/*
+ * Release the ring lock held by a dead client thread.
+ * The clients record the holder of the lock in the ring.
+ * If that thread no longer exists, it will never post the
+ * lock, so we post it on its behalf. A live holder, or a
+ * lock held by our own thread, is left alone.
+ */
+static void
+recover_ring(struct fifo_node *np)
+{
+	struct pipe_ring *pr = np->fn_ring;
+	thread_t owner;
+	int pri;
+
+	mutex_lock(&fifo_lock);
+	owner = pr->pr_owner;
+	if (owner != 0 && thread_getpri(owner, &pri) == ESRCH) {
+		DPRINTF(("fifo: recover ring lock from thread %x\n", owner));
+		pr->pr_owner = 0;
+		sem_post(&np->fn_plock);
+	}
+	mutex_unlock(&fifo_lock);
+}
+
+static void
+wakeup_ring(sem_t *sp, int *nwait)
+{
+	int n;
+
+	/* The count is written by the clients. */
+	n = *nwait;
+	*nwait = 0;
+	if (n > FIFO_MAXWAIT)
+		n = FIFO_MAXWAIT;
+	while (n-- > 0) {
+		if (sem_post(sp) != 0)
+			break;
+	}
+}
+
+static void
+enter_ring(vnode_t vp, struct fifo_node *np)
+{
+
+	mutex_lock(&fifo_lock);
+	np->fn_busy++;
+	mutex_unlock(&fifo_lock);
+	vn_unlock(vp);
+}
+
+static void
+leave_ring(vnode_t vp, struct fifo_node *np)
+{
+
+	mutex_lock(&fifo_lock);
+	np->fn_busy--;
+	mutex_unlock(&fifo_lock);
+	vn_lock(vp);
+}
+
+/*
+ * Read data from the shared ring for the client which does not
+ * map the ring. The vnode is unlocked while we wait for data.
+ * Every index is taken from the ring modulo our own size, so
+ * a broken client can not make us copy outside of the ring.
+ */
+static int
+read_ring(vnode_t vp, char *buf, size_t size, size_t *result)
+{
+	struct fifo_node *np = vp->v_data;
+	struct pipe_ring *pr = np->fn_ring;
+	size_t ringsz = np->fn_ringsz;
+	size_t start, count, len, n;
+	int error;
+
+	*result = 0;
+	enter_ring(vp, np);
+	if ((error = wait_ring(np, &np->fn_plock)) != 0)
+		goto out;
+
+	for (;;) {
+		count = MIN(pr->pr_count, ringsz);
+		if (count > 0)
+			break;
+		if (np->fn_writers == 0) {
+			/* EOF */
+			sem_post(&np->fn_plock);
+			goto out;
+		}
+		pr->pr_rwait++;
+		sem_post(&np->fn_plock);
+		if ((error = wait_ring(np, &np->fn_prsem)) != 0)
+			goto out;
+		if ((error = wait_ring(np, &np->fn_plock)) != 0)
+			goto out;
+	}
+
+	start = pr->pr_start % ringsz;
+	len = MIN(size, count);
+	n = MIN(len, ringsz - start);
+	memcpy(buf, &pr->pr_buf[start], n);
+	if (len > n)
+		memcpy(buf + n, pr->pr_buf, len - n);
+
+	start += len;
+	if (start >= ringsz)
+		start -= ringsz;
+	pr->pr_start = start;
+	pr->pr_count = count - len;
+
+	/*
+	 * Wake writers only when the ring drains to the low
+	 * water mark, so that they can refill it in bulk.
+	 */
+	if (count - len <= np->fn_lowat)
+		wakeup_ring(&np->fn_pwsem, &pr->pr_wwait);
+	sem_post(&np->fn_plock);
+	*result = len;
+ out:
+	leave_ring(vp, np);
+	return error;
+}
+
+/*
+ * Write data to the shared ring.
+ * A write of PIPE_BUF bytes or less is not interleaved with
+ * the data from other writers.
+ */
+static int
+write_ring(vnode_t vp, const char *buf, size_t size, size_t *result)
+{
+	struct fifo_node *np = vp->v_data;
+	struct pipe_ring *pr = np->fn_ring;
+	size_t ringsz = np->fn_ringsz;
+	size_t pos, count, nfree, len, n, total = 0;
+	int error;
+
+	enter_ring(vp, np);
+	if ((error = wait_ring(np, &np->fn_plock)) != 0)
+		goto out;
+
+	while (size > 0) {
+		if (np->fn_readers == 0) {
+			error = EPIPE;
+			break;
+		}
+		count = MIN(pr->pr_count, ringsz);
+		nfree = ringsz - count;
+		if (nfree == 0 || (size <= PIPE_BUF && nfree < size)) {
+			pr->pr_wwait++;
+			sem_post(&np->fn_plock);
+			if ((error = wait_ring(np, &np->fn_pwsem)) != 0)
+				goto out;
+			if ((error = wait_ring(np, &np->fn_plock)) != 0)
+				goto out;
+			continue;
+		}
+		len = MIN(size, nfree);
+		pos = (pr->pr_start % ringsz) + count;
+		if (pos >= ringsz)
+			pos -= ringsz;
+		n = MIN(len, ringsz - pos);
+		memcpy(&pr->pr_buf[pos], buf, n);
+		if (len > n)
+			memcpy(pr->pr_buf, buf + n, len - n);
+		pr->pr_count = count + len;
+
+		buf += len;
+		size -= len;
+		total += len;
+
+		wakeup_ring(&np->fn_prsem, &pr->pr_rwait);
+	}
+	sem_post(&np->fn_plock);
+ out:
+	leave_ring(vp, np);
+	if (total > 0)
+		error = 0;
+	*result = total;
+	return error;
+}
+
+/*
+ * Publish the number of read/write ends to the clients, and
+ * wake all waiting threads to check the new state.
+ * This is called with the vnode locked, so we do not wait
+ * long for a client holding the ring lock. If the lock can
+ * not be taken, each side is kicked once and the woken
+ * thread rechecks the state.
+ */
+static void
+update_ring(struct fifo_node *np)
+{
+	struct pipe_ring *pr = np->fn_ring;
+
+	if (sem_wait(&np->fn_plock, FIFO_POLLTMO) != 0) {
+		recover_ring(np);
+		pr->pr_readers = np->fn_readers;
+		pr->pr_writers = np->fn_writers;
+		sem_post(&np->fn_prsem);
+		sem_post(&np->fn_pwsem);
+		return;
+	}
+	pr->pr_readers = np->fn_readers;
+	pr->pr_writers = np->fn_writers;
+	wakeup_ring(&np->fn_prsem, &pr->pr_rwait);
+	wakeup_ring(&np->fn_pwsem, &pr->pr_wwait);
+	sem_post(&np->fn_plock);
+}
+
+/*
+ * Change the buffer size of the FIFO.
+ * The size is rounded up to a multiple of PIPE_BUF.
+ * The buffered data is kept, so the new size must be large
+ * enough to hold it.
+ */
+static int
+resize_fifo(struct fifo_node *np, size_t size)
+{
+	char *buf;
+	size_t len;
+
+	if (size < FIFO_MINBUF)
+		size = FIFO_MINBUF;
+	size = (size + PIPE_BUF - 1) & ~(PIPE_BUF - 1);
+	if (size == np->fn_bufsz)
+		return 0;
+	if (size < np->fn_size)
+		return EBUSY;
+
+	if (size == FIFO_DEFBUF)
+		buf = pool_get(&buf_pool);
+	else
+		buf = malloc(size);
+	if (buf == NULL)
+		return ENOMEM;
+
+	len = np->fn_size;
+	copyout_fifo(np, buf, len);
+	free_buf(np->fn_buf, np->fn_bufsz);
+
+	np->fn_buf = buf;
+	np->fn_bufsz = size;
+	np->fn_lowat = FIFO_LOWAT(size);
+	np->fn_start = 0;
+	np->fn_size = len;
+	return 0;
+}
+
+/*
+ * Remove data from the ring buffer.
+ * The data may wrap around the end of the buffer, so it is
+ * copied in two segments at most.
+ */
+static void
+copyout_fifo(struct fifo_node *np, char *dst, size_t len)
+{
+	size_t n;
+
+	ASSERT(len <= np->fn_size);
+
+	n = np->fn_bufsz - np->fn_start;
+	if (n > len)
+		n = len;
+	memcpy(dst, np->fn_buf + np->fn_start, n);
+	if (len > n)
+		memcpy(dst + n, np->fn_buf, len - n);
+
+	np->fn_start += len;
+	if (np->fn_start >= np->fn_bufsz)
+		np->fn_start -= np->fn_bufsz;
+	np->fn_size -= len;
+}
+
+/*
+ * Append data to the ring buffer.
+ */
+static void
+copyin_fifo(struct fifo_node *np, const char *src, size_t len)
+{
+	size_t pos, n;
+
+	ASSERT(len <= np->fn_bufsz - np->fn_size);
+
+	pos = np->fn_start + np->fn_size;
+	if (pos >= np->fn_bufsz)
+		pos -= np->fn_bufsz;
+	n = np->fn_bufsz - pos;
+	if (n > len)
+		n = len;
+	memcpy(np->fn_buf + pos, src, n);
+	if (len > n)
+		memcpy(np->fn_buf, src + n, len - n);
+
+	np->fn_size += len;
+}
+
 static int
 fifo_remove(vnode_t dvp, vnode_t vp, char *name)
 {
@@ -470,14 +1012,21 @@ fifofs_init(void)
 }
 
 
+/*
+ * The state of the FIFO is checked with the vnode locked.
+ * The waiter takes the mutex of the condition variable before
+ * it unlocks the vnode, and the waker, which holds the vnode
+ * lock, takes the same mutex to broadcast. So, a wakeup between
+ * the check and the sleep is never lost.
+ */
 static void
 wait_reader(vnode_t vp)
 {
 	struct fifo_node *np = vp->v_data;
 
 	DPRINTF(("wait_reader: %x\n", np));
-	vn_unlock(vp);
 	mutex_lock(&np->fn_rmtx);
+	vn_unlock(vp);
 	cond_wait(&np->fn_rcond, &np->fn_rmtx);
 	mutex_unlock(&np->fn_rmtx);
 	vn_lock(vp);
@@ -489,7 +1038,9 @@ wakeup_writer(vnode_t vp)
 	struct fifo_node *np = vp->v_data;
 
 	DPRINTF(("wakeup_writer: %x\n", np));
+	mutex_lock(&np->fn_rmtx);
 	cond_broadcast(&np->fn_rcond);
+	mutex_unlock(&np->fn_rmtx);
 }
 
 static void
@@ -498,8 +1049,8 @@ wait_writer(vnode_t vp)
 	struct fifo_node *np = vp->v_data;
 
 	DPRINTF(("wait_writer: %x\n", np));
-	vn_unlock(vp);
 	mutex_lock(&np->fn_wmtx);
+	vn_unlock(vp);
 	cond_wait(&np->fn_wcond, &np->fn_wmtx);
 	mutex_unlock(&np->fn_wmtx);
 	vn_lock(vp);
@@ -511,5 +1062,7 @@ wakeup_reader(vnode_t vp)
 	struct fifo_node *np = vp->v_data;
 
 	DPRINTF(("wakeup_reader: %x\n", np));
+	mutex_lock(&np->fn_wmtx);
 	cond_broadcast(&np->fn_wcond);
+	mutex_unlock(&np->fn_wmtx);
 }
@@ -221,6 +221,17 @@ fs_read(struct task *t, struct io_msg *msg)
 	if ((fp = task_getfp(t, msg->fd)) == NULL)
 		return EBADF;
 	size = msg->size;
+	if (msg->buf == NULL) {
+		/*
+		 * The data is returned with the reply.
+		 * See fs_thread().
+		 */
+		if (size > MAX_FSDATA)
+			return EINVAL;
+		error = sys_read(fp, FS_DATABUF(msg), size, &bytes);
+		msg->size = bytes;
+		return error;
+	}
 	if ((error = vm_map(msg->hdr.task, msg->buf, size, &buf)) != 0)
 		return EFAULT;
 
@@ -241,6 +252,14 @@ fs_write(struct task *t, struct io_msg *msg)
 	if ((fp = task_getfp(t, msg->fd)) == NULL)
 		return EBADF;
 	size = msg->size;
+	if (msg->buf == NULL) {
+		/* The data came with the message. */
+		if (size > MAX_FSDATA)
+			return EINVAL;
+		error = sys_write(fp, FS_DATABUF(msg), size, &bytes);
+		msg->size = bytes;
+		return error;
+	}
 	if ((error = vm_map(msg->hdr.task, msg->buf, size, &buf)) != 0)
 		return EFAULT;
 
@@ -573,7 +592,7 @@ static int
 fs_fcntl(struct task *t, struct fcntl_msg *msg)
 {
 	file_t fp;
-	int arg, new_fd;
+	int arg, new_fd, error;
 
 	if ((fp = task_getfp(t, msg->fd)) == NULL)
 		return EBADF;
@@ -605,6 +624,20 @@ fs_fcntl(struct task *t, struct fcntl_msg *msg)
 	case F_SETFL:
 		msg->arg = -1;
 		break;
+	case F_GETPIPE_SZ:
+		if (fp->f_vnode->v_type != VFIFO)
+			return EINVAL;
+		if ((error = sys_ioctl(fp, FIFOIOC_GET_SIZE, &arg)) != 0)
+			return error;
+		msg->arg = arg;
+		break;
+	case F_SETPIPE_SZ:
+		if (fp->f_vnode->v_type != VFIFO)
+			return EINVAL;
+		if ((error = sys_ioctl(fp, FIFOIOC_SET_SIZE, &arg)) != 0)
+			return error;
+		msg->arg = 0;
+		break;
 	default:
 		msg->arg = -1;
 		break;
@@ -755,6 +788,30 @@ fs_register(struct task *t, struct msg *msg)
 	return error;
 }
 
+/*
+ * Map the shared ring of the pipe to the task.
+ */
+static int
+map_pipe(struct task *t, file_t fp, void **ring)
+{
+#ifdef CONFIG_MMU
+	void *pr;
+	int error;
+
+	if (fp->f_vnode->v_type != VFIFO)
+		return EINVAL;
+	if ((error = sys_ioctl(fp, FIFOIOC_GET_RING, &pr)) != 0)
+		return error;
+	return vm_share(t->t_taskid, pr, ring);
+#else
+	/*
+	 * The ring can not be shared safely because the
+	 * vfork'ed child runs in the parent's memory.
+	 */
+	return ENOSYS;
+#endif
+}
+
 static int
 fs_pipe(struct task *t, struct msg *msg)
 {
@@ -798,6 +855,27 @@ fs_pipe(struct task *t, struct msg *msg)
 #endif
 }
 
+/*
+ * Return the shared ring for the pipe descriptor.
+ * This is called at the first read/write on the pipe descriptor.
+ */
+static int
+fs_pipemap(struct task *t, struct msg *msg)
+{
+	file_t fp;
+	void *ring;
+	int error;
+
+	if ((fp = task_getfp(t, msg->data[0])) == NULL)
+		return EBADF;
+
+	if ((error = map_pipe(t, fp, &ring)) != 0)
+		return error;
+	msg->data[0] = (int)ring;
+	msg->data[1] = fp->f_flags & (FREAD | FWRITE);
+	return 0;
+}
+
 /*
  * Return if specified file is a tty
  */
@@ -1012,6 +1090,7 @@ static const struct msg_map fsmsg_map[] = {
 	MSGMAP( FS_TRUNCATE,	fs_truncate ),
 	MSGMAP( FS_FTRUNCATE,	fs_ftruncate ),
 	MSGMAP( FS_FCHDIR,	fs_fchdir ),
+	MSGMAP( FS_PIPEMAP,	fs_pipemap ),
 	MSGMAP( STD_BOOT,	fs_boot ),
 	MSGMAP( STD_SHUTDOWN,	fs_shutdown ),
 #ifdef DEBUG_VFS
@@ -1027,11 +1106,17 @@ static void
 fs_thread(void)
 {
 	struct msg *msg;
+	struct io_msg *io;
 	const struct msg_map *map;
 	struct task *t;
+	struct iovec iov[2];
 	int error;
 
-	msg = malloc(MAX_FSMSG);
+	/*
+	 * The data buffer for read/write follows the message.
+	 */
+	msg = malloc(MAX_FSMSG + MAX_FSDATA);
+	io = (struct io_msg *)msg;
 
 	/*
 	 * Message loop
@@ -1040,10 +1125,23 @@ fs_thread(void)
 		/*
 		 * Wait for an incoming request.
 		 */
-		if ((error = msg_receive(fsobj, msg, MAX_FSMSG)) != 0)
+		iov[0].iov_base = msg;
+		iov[0].iov_len = MAX_FSMSG;
+		iov[1].iov_base = FS_DATABUF(msg);
+		iov[1].iov_len = MAX_FSDATA;
+		if ((error = msg_receivev(fsobj, iov, 2)) != 0)
 			continue;
 
+		/*
+		 * The data of the write must come with this message.
+		 * Otherwise, the buffer still has the data which was
+		 * sent by the previous client.
+		 */
 		error = EINVAL;
+		if (msg->hdr.code == FS_WRITE && io->buf == NULL &&
+		    io->size > iov[1].iov_len)
+			goto reply;
+
 		map = &fsmsg_map[0];
 		while (map->code != 0) {
 			if (map->code == msg->hdr.code) {
@@ -1080,8 +1178,19 @@ fs_thread(void)
 		/*
 		 * Reply to the client.
 		 */
+ reply:
 		msg->hdr.status = error;
-		msg_reply(fsobj, msg, MAX_FSMSG);
+		iov[1].iov_len = 0;
+		if (msg->hdr.code == FS_READ && io->buf == NULL && !error)
+			iov[1].iov_len = io->size;
+		if (msg_replyv(fsobj, iov, 2) == EFAULT) {
+			/*
+			 * The read buffer is not writable.  The client
+			 * is still waiting, so reply the error alone.
+			 */
+			msg->hdr.status = EFAULT;
+			msg_replyv(fsobj, iov, 1);
+		}
 	}
 }
 
@@ -46,6 +46,9 @@
  */
 #define FSMAXNAMES	16		/* max length of 'file system' name */
 
+/* Inline read/write data placed after the message buffer */
+#define FS_DATABUF(msg)	((char *)(msg) + MAX_FSMSG)
+
 #ifdef DEBUG_VFS
 extern int vfs_debug;
 
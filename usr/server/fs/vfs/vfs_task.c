@@ -32,6 +32,7 @@
 
 #include <sys/prex.h>
 #include <sys/list.h>
+#include <sys/pool.h>
 
 #include <limits.h>
 #include <stdlib.h>
@@ -50,6 +51,11 @@
  */
 static struct list task_table[TASK_MAXBUCKETS];
 
+/*
+ * Pool for task structures.  It is protected by task_lock.
+ */
+static struct pool task_pool = POOL_INITIALIZER(sizeof(struct task), 0);
+
 /*
  * Global lock for task access.
  */
@@ -104,14 +110,15 @@ task_alloc(task_t task, struct task **pt)
 	if (task_lookup(task) != NULL)
 		return EINVAL;
 
-	if (!(t = malloc(sizeof(struct task))))
+	TASK_LOCK();
+	if (!(t = pool_get(&task_pool))) {
+		TASK_UNLOCK();
 		return ENOMEM;
+	}
 	memset(t, 0, sizeof(struct task));
 	t->t_taskid = task;
 	strlcpy(t->t_cwd, "/", sizeof(t->t_cwd));
 	mutex_init(&t->t_lock);
-
-	TASK_LOCK();
 	list_insert(&task_table[TASKHASH(task)], &t->t_link);
 	TASK_UNLOCK();
 	*pt = t;
@@ -129,7 +136,7 @@ task_free(struct task *t)
 	list_remove(&t->t_link);
 	mutex_unlock(&t->t_lock);
 	mutex_destroy(&t->t_lock);
-	free(t);
+	pool_put(&task_pool, t);
 	TASK_UNLOCK();
 }
 
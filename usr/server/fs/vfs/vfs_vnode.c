@@ -35,6 +35,7 @@
 #include <sys/list.h>
 #include <sys/vnode.h>
 #include <sys/mount.h>
+#include <sys/pool.h>
 
 #include <limits.h>
 #include <unistd.h>
@@ -76,11 +77,19 @@ static struct list vnode_table[VNODE_BUCKETS];
 static mutex_t vnode_lock = MUTEX_INITIALIZER;
 #define VNODE_LOCK()	mutex_lock(&vnode_lock)
 #define VNODE_UNLOCK()	mutex_unlock(&vnode_lock)
+#define VNODE_POOL	POOL_LOCKED
 #else
 #define VNODE_LOCK()
 #define VNODE_UNLOCK()
+#define VNODE_POOL	0
 #endif
 
+/*
+ * Pool for vnode structures.
+ */
+static struct pool vnode_pool =
+	POOL_INITIALIZER(sizeof(struct vnode), VNODE_POOL);
+
 
 /*
  * Get the hash value from the mount point and path name.
@@ -166,13 +175,13 @@ vget(mount_t mp, char *path)
 
 	DPRINTF(VFSDB_VNODE, ("vget: %s\n", path));
 
-	if (!(vp = malloc(sizeof(struct vnode))))
+	if (!(vp = pool_get(&vnode_pool)))
 		return NULL;
 	memset(vp, 0, sizeof(struct vnode));
 
 	len = strlen(path) + 1;
 	if (!(vp->v_path = malloc(len))) {
-		free(vp);
+		pool_put(&vnode_pool, vp);
 		return NULL;
 	}
 	vp->v_mount = mp;
@@ -188,7 +197,7 @@ vget(mount_t mp, char *path)
 	if ((error = VFS_VGET(mp, vp)) != 0) {
 		mutex_destroy(&vp->v_lock);
 		free(vp->v_path);
-		free(vp);
+		pool_put(&vnode_pool, vp);
 		return NULL;
 	}
 	vfs_busy(vp->v_mount);
@@ -232,7 +241,7 @@ vput(vnode_t vp)
 	mutex_unlock(&vp->v_lock);
 	mutex_destroy(&vp->v_lock);
 	free(vp->v_path);
-	free(vp);
+	pool_put(&vnode_pool, vp);
 }
 
 /*
@@ -281,7 +290,7 @@ vrele(vnode_t vp)
 	vfs_unbusy(vp->v_mount);
 	mutex_destroy(&vp->v_lock);
 	free(vp->v_path);
-	free(vp);
+	pool_put(&vnode_pool, vp);
 }
 
 /*
@@ -298,7 +307,7 @@ vgone(vnode_t vp)
 	vfs_unbusy(vp->v_mount);
 	mutex_destroy(&vp->v_lock);
 	free(vp->v_path);
-	free(vp);
+	pool_put(&vnode_pool, vp);
 	VNODE_UNLOCK();
 }
 
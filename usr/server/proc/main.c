@@ -123,6 +123,10 @@ struct proc initproc;		/* process slot for init process (pid=1) */
 struct proc *curproc;		/* current (caller) process */
 struct list allproc;		/* list of all processes */
 
+struct pool proc_pool = POOL_INITIALIZER(sizeof(struct proc), 0);
+struct pool pgrp_pool = POOL_INITIALIZER(sizeof(struct pgrp), 0);
+struct pool session_pool = POOL_INITIALIZER(sizeof(struct session), 0);
+
 static int
 proc_getpid(struct msg *msg)
 {
@@ -387,7 +391,7 @@ proc_register(struct msg *msg)
 	if (task_chkcap(msg->hdr.task, CAP_PROTSERV) != 0)
 		return EPERM;
 
-	if ((p = malloc(sizeof(struct proc))) == NULL)
+	if ((p = pool_get(&proc_pool)) == NULL)
 		return ENOMEM;
 	memset(p, 0, sizeof(struct proc));
 
@@ -34,6 +34,7 @@
 #include <sys/param.h>
 #include <sys/types.h>
 #include <sys/list.h>
+#include <sys/pool.h>
 #include <ipc/proc.h>
 #include <ipc/ipc.h>
 #include <sys/capability.h>
@@ -117,6 +118,9 @@ extern struct proc initproc;		/* process slot for init */
 extern struct list allproc;		/* list of all processes */
 extern struct proc *curproc;		/* current (caller) process */
 extern int perrno;			/* errno */
+extern struct pool proc_pool;		/* pool for proc */
+extern struct pool pgrp_pool;		/* pool for pgrp */
+extern struct pool session_pool;	/* pool for session */
 
 __BEGIN_DECLS
 
@@ -140,13 +140,15 @@ sys_fork(task_t child, int vfork, pid_t *retval)
 		return EINVAL;
 	}
 
-	if ((p = malloc(sizeof(struct proc))) == NULL)
+	if ((p = pool_get(&proc_pool)) == NULL)
 		return ENOMEM;
 	memset(p, 0, sizeof(*p));
 
 	error = newproc(p, 0, child);
-	if (error)
+	if (error) {
+		pool_put(&proc_pool, p);
 		return error;
+	}
 
 	if (vfork) {
 		vfork_start(curproc);
@@ -171,7 +173,7 @@ cleanup(struct proc *p)
 	list_remove(&p->p_sibling);
 	list_remove(&p->p_pgrp_link);
 	list_remove(&p->p_link);
-	free(p);
+	pool_put(&proc_pool, p);
 }
 
 static int
@@ -127,7 +127,7 @@ enterpgrp(struct proc *p, pid_t pgid)
 		 * Create a new process group.
 		 */
 		DPRINTF(("proc: create new pgrp\n"));
-		if ((pgrp = malloc(sizeof(struct pgrp))) == NULL)
+		if ((pgrp = pool_get(&pgrp_pool)) == NULL)
 			return ENOMEM;
 		memset(pgrp, 0, sizeof(*pgrp));
 		list_init(&pgrp->pg_members);
@@ -159,7 +159,7 @@ leavepgrp(struct proc *p)
 		/* XXX: do some work for session */
 
 		pg_remove(pgrp);
-		free(pgrp);
+		pool_put(&pgrp_pool, pgrp);
 	}
 	p->p_pgrp = 0;
 	return (0);
@@ -212,7 +212,7 @@ sys_setsid(pid_t *retval)
 	if (p->p_pid == p->p_pgrp->pg_pgid)	/* already leader */
 		return EPERM;
 
-	if ((sess = malloc(sizeof(struct session))) == NULL)
+	if ((sess = pool_get(&session_pool)) == NULL)
 		return ENOMEM;
 	memset(sess, 0, sizeof(*sess));
 
@@ -220,7 +220,7 @@ sys_setsid(pid_t *retval)
 	 * Create a new process group.
 	 */
 	if ((error = enterpgrp(p, p->p_pid)) != 0) {
-		free(sess);
+		pool_put(&session_pool, sess);
 		return error;
 	}
 	pgrp = p->p_pgrp;
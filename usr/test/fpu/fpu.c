@@ -0,0 +1,123 @@
+/*-
+ * Copyright (c) 2009, Kohsuke Ohtani
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the author nor the names of any co-contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+/*
+ * fpu.c - benchmark of context switch with FPU users
+ */
+
+/*
+ * Two threads switch to each other by thread_yield(), and the
+ * cost of one switch is measured in three cases:
+ *
+ *  - no thread uses FPU
+ *  - one thread uses FPU
+ *  - both threads use FPU
+ *
+ * With the lazy FPU switching, the first two cases should cost
+ * the same. The third case adds one save/restore per switch.
+ */
+
+#include <sys/prex.h>
+#include <stdio.h>
+
+#define NR_SWITCH	100000
+
+static char stack[1024];
+static volatile int use_fpu;
+static volatile double fval;
+static u_long hz;		/* clock ticks per second */
+
+static void
+fpu_work(void)
+{
+
+	fval = fval * 0.5 + 1.0;
+}
+
+static void
+yield_thread(void)
+{
+
+	for (;;) {
+		if (use_fpu & 2)
+			fpu_work();
+		thread_yield();
+	}
+}
+
+static void
+measure(const char *name, int mode)
+{
+	u_long start, end, usec;
+	int i;
+
+	use_fpu = mode;
+	thread_yield();
+
+	sys_time(&start);
+	for (i = 0; i < NR_SWITCH; i++) {
+		if (mode & 1)
+			fpu_work();
+		thread_yield();
+	}
+	sys_time(&end);
+	usec = (end - start) * (1000000 / hz);
+
+	/* Two switches per loop */
+	printf("%-16s %6lu msec  %5lu nsec/switch\n", name, usec / 1000,
+	       usec / (NR_SWITCH * 2 / 1000));
+}
+
+int
+main(int argc, char *argv[])
+{
+	struct timerinfo info;
+	thread_t t;
+
+	printf("FPU context switch benchmark\n");
+
+	sys_info(INFO_TIMER, &info);
+	if ((hz = info.hz) == 0)
+		panic("sys_info() is failed");
+
+	if (thread_create(task_self(), &t) != 0)
+		panic("thread_create() is failed");
+	if (thread_load(t, yield_thread, stack + sizeof(stack)) != 0)
+		panic("thread_load() is failed");
+	if (thread_resume(t) != 0)
+		panic("thread_resume() is failed");
+
+	measure("no FPU user", 0);
+	measure("one FPU user", 1);
+	measure("two FPU users", 3);
+
+	thread_terminate(t);
+	return 0;
+}
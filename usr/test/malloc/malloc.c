@@ -141,6 +141,7 @@ main(int argc, char *argv[])
 
 	test_1();
 	test_2();
+	mstat();
 	test_3();
 
 	return 0;
@@ -0,0 +1,114 @@
+/*-
+ * Copyright (c) 2009, Kohsuke Ohtani
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the author nor the names of any co-contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+
+/*
+ * memcpy.c - benchmark of memory functions
+ */
+
+/*
+ * The throughput of memcpy(), memset() and memcmp() is measured
+ * for several block sizes with aligned and unaligned buffers.
+ */
+
+#include <sys/prex.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#define BUFSZ		(64 * 1024)
+#define TOTAL		(16 * 1024 * 1024)	/* bytes per test */
+
+static const size_t sizes[] = { 16, 64, 256, 1024, 4096, BUFSZ };
+
+#define NR_SIZES	(int)(sizeof(sizes) / sizeof(sizes[0]))
+
+enum { T_MEMCPY, T_MEMSET, T_MEMCMP };
+
+static const char *const names[] = { "memcpy", "memset", "memcmp" };
+
+static char *src, *dst;
+
+/*
+ * Returns the throughput in KB/sec.
+ */
+static u_long
+measure(int type, size_t size, int offset)
+{
+	u_long start, end, i, count;
+
+	count = TOTAL / size;
+	sys_time(&start);
+	for (i = 0; i < count; i++) {
+		switch (type) {
+		case T_MEMCPY:
+			memcpy(dst + offset, src, size);
+			break;
+		case T_MEMSET:
+			memset(dst + offset, (int)i, size);
+			break;
+		case T_MEMCMP:
+			if (memcmp(dst + offset, src + offset, size) != 0)
+				panic("memcmp() is failed");
+			break;
+		}
+	}
+	sys_time(&end);
+	if (end == start)
+		end++;
+	return (TOTAL / 1024) * 1000 / (end - start);
+}
+
+int
+main(int argc, char *argv[])
+{
+	int type, i;
+
+	printf("Memory function benchmark (KB/sec)\n");
+
+	src = malloc(BUFSZ + 16);
+	dst = malloc(BUFSZ + 16);
+	if (src == NULL || dst == NULL)
+		panic("malloc() is failed");
+	memset(src, 0x55, BUFSZ + 16);
+
+	printf("%-8s %6s %10s %10s\n", "", "size", "aligned", "unaligned");
+	for (type = T_MEMCPY; type <= T_MEMCMP; type++) {
+		if (type == T_MEMCMP)
+			memcpy(dst, src, BUFSZ + 16);
+		for (i = 0; i < NR_SIZES; i++) {
+			printf("%-8s %6u %10lu %10lu\n", names[type],
+			       (u_int)sizes[i], measure(type, sizes[i], 0),
+			       measure(type, sizes[i], 1));
+		}
+	}
+	free(src);
+	free(dst);
+	return 0;
+}
@@ -0,0 +1,783 @@
+/*-
+ * Copyright (c) 2009, Kohsuke Ohtani
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the author nor the names of any co-contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * microbench.c - micro benchmarks for the Prex primitives.
+ */
+
+/*
+ * Each benchmark is run with an increasing number of iterations
+ * until it takes at least the minimum time (-t msec), so that
+ * the tick based clock gives a stable result. The results are
+ * printed one per line as
+ *
+ *	<benchmark> <size> <value> <unit>
+ *
+ * and all other lines start with '#'. The benchmarks to run can
+ * be given as arguments; all are run by default. This allows to
+ * run the program from /etc/rc and collect the console output.
+ *
+ * The -x, -E and -R options are used internally for the child
+ * processes of the fork, exec and pipe benchmarks.
+ */
+
+#include <sys/prex.h>
+#include <sys/fcntl.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/utsname.h>
+#include <ipc/ipc.h>
+
+#include <unistd.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+
+#define EXECPATH	"/boot/microbench"
+#define MAXITER		(1UL << 21)	/* max iterations of one run */
+#define MAXDIRS		4		/* max directories for fs tests */
+#define BUFSZ		(64 * 1024)	/* I/O buffer size */
+#define FILESZ		(256 * 1024)	/* file size for file I/O */
+#define BLKSZ		4096		/* block size for file I/O */
+
+struct bench {
+	const char	*name;
+	void		(*func)(void);
+};
+
+static u_long	hz;		/* clock ticks per second */
+static u_long	mintime;	/* min time of one run in usec */
+static u_long	tick0;		/* start tick of the current run */
+static char	*execpath = EXECPATH;
+static char	*dirs[MAXDIRS];
+static int	ndirs;
+static char	iobuf[BUFSZ];
+static char	path[64];
+
+/*
+ * Resources shared with the helper thread.
+ */
+static char	stack[1024];
+static thread_t	helper;
+static object_t	ipcobj;
+static size_t	ipcsize;
+static char	sendbuf[4096];
+static char	recvbuf[4096];
+static mutex_t	mtx;
+static cond_t	cnd;
+static sem_t	sem[2];
+static volatile int turn;
+
+static void
+fail(const char *msg)
+{
+
+	fprintf(stderr, "microbench: %s failed\n", msg);
+	exit(1);
+}
+
+/*
+ * Start a run at the beginning of a clock tick.
+ */
+static void
+bench_start(void)
+{
+	u_long t;
+
+	sys_time(&t);
+	do {
+		sys_time(&tick0);
+	} while (tick0 == t);
+}
+
+/*
+ * Return the time of the current run in usec.
+ */
+static u_long
+bench_stop(void)
+{
+	u_long t;
+
+	sys_time(&t);
+	return (t - tick0) * (1000000 / hz);
+}
+
+/*
+ * Run a benchmark with the doubling number of iterations until
+ * it takes the minimum time. Returns the time in usec.
+ */
+static u_long
+measure(void (*func)(u_long, int), int arg, u_long maxiter, u_long *np)
+{
+	u_long n, usec;
+
+	for (n = 1; ; n *= 2) {
+		bench_start();
+		func(n, arg);
+		usec = bench_stop();
+		if (usec >= mintime || n >= maxiter)
+			break;
+	}
+	*np = n;
+	return usec;
+}
+
+static void
+report_time(const char *name, int size, u_long usec, u_long n)
+{
+
+	printf("%s %d %lu.%03lu usec\n", name, size, usec / n,
+	       (usec % n) * 1000 / n);
+}
+
+static void
+report_bw(const char *name, int size, u_long bytes, u_long usec)
+{
+	u_long msec;
+
+	if ((msec = usec / 1000) == 0)
+		msec = 1;
+	printf("%s %d %lu KB/s\n", name, size, (bytes / 1024) * 1000 / msec);
+}
+
+static void
+run_time(const char *name, int size, void (*func)(u_long, int), int arg,
+	 u_long maxiter)
+{
+	u_long n, usec;
+
+	usec = measure(func, arg, maxiter, &n);
+	report_time(name, size, usec, n);
+}
+
+/*
+ * Run a helper thread in this task.
+ */
+static void
+thread_run(void (*func)(void))
+{
+
+	if (thread_create(task_self(), &helper) != 0 ||
+	    thread_load(helper, func, stack + sizeof(stack)) != 0 ||
+	    thread_resume(helper) != 0)
+		fail("thread_create");
+}
+
+/*
+ * Null system call
+ */
+static void
+do_syscall(u_long n, int arg)
+{
+
+	while (n-- > 0)
+		thread_self();
+}
+
+static void
+do_getpid(u_long n, int arg)
+{
+
+	while (n-- > 0)
+		getpid();
+}
+
+static void
+bench_syscall(void)
+{
+
+	run_time("syscall", 0, do_syscall, 0, MAXITER);
+	run_time("getpid", 0, do_getpid, 0, MAXITER);
+}
+
+/*
+ * Context switch between two threads of the same priority.
+ */
+static void
+yield_thread(void)
+{
+
+	for (;;)
+		thread_yield();
+}
+
+static void
+do_yield(u_long n, int arg)
+{
+
+	while (n-- > 0)
+		thread_yield();
+}
+
+static void
+bench_ctxsw(void)
+{
+	u_long n, usec;
+
+	thread_run(yield_thread);
+	usec = measure(do_yield, 0, MAXITER, &n);
+	thread_terminate(helper);
+	report_time("ctxsw", 0, usec, n * 2);
+}
+
+/*
+ * IPC round trip to a server thread in the same task.
+ */
+static void
+server_thread(void)
+{
+
+	for (;;) {
+		if (msg_receive(ipcobj, recvbuf, sizeof(recvbuf)) == 0)
+			msg_reply(ipcobj, recvbuf, ipcsize);
+	}
+}
+
+static void
+do_ipc(u_long n, int arg)
+{
+
+	while (n-- > 0)
+		msg_send(ipcobj, sendbuf, ipcsize);
+}
+
+static void
+bench_ipc(void)
+{
+	static const int sizes[] = { 16, 64, 256, 1024, 4096 };
+	char name[MAXOBJNAME];
+	u_int i;
+
+	snprintf(name, sizeof(name), "microbench%d", getpid());
+	if (object_create(name, &ipcobj) != 0)
+		fail("object_create");
+	thread_run(server_thread);
+	for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+		ipcsize = sizes[i];
+		run_time("ipc", sizes[i], do_ipc, 0, MAXITER);
+	}
+	thread_terminate(helper);
+	object_destroy(ipcobj);
+}
+
+/*
+ * Synchronization ping-pong between two threads.
+ */
+static void
+mutex_thread(void)
+{
+
+	for (;;) {
+		mutex_lock(&mtx);
+		thread_yield();
+		mutex_unlock(&mtx);
+	}
+}
+
+static void
+do_mutex(u_long n, int arg)
+{
+
+	while (n-- > 0) {
+		mutex_lock(&mtx);
+		thread_yield();
+		mutex_unlock(&mtx);
+	}
+}
+
+static void
+do_mutex_uncontended(u_long n, int arg)
+{
+
+	while (n-- > 0) {
+		mutex_lock(&mtx);
+		mutex_unlock(&mtx);
+	}
+}
+
+static void
+sem_thread(void)
+{
+
+	for (;;) {
+		sem_wait(&sem[0], 0);
+		sem_post(&sem[1]);
+	}
+}
+
+static void
+do_sem(u_long n, int arg)
+{
+
+	while (n-- > 0) {
+		sem_post(&sem[0]);
+		sem_wait(&sem[1], 0);
+	}
+}
+
+static void
+cond_thread(void)
+{
+
+	mutex_lock(&mtx);
+	for (;;) {
+		while (turn == 0)
+			cond_wait(&cnd, &mtx);
+		turn = 0;
+		cond_signal(&cnd);
+	}
+}
+
+static void
+do_cond(u_long n, int arg)
+{
+
+	mutex_lock(&mtx);
+	while (n-- > 0) {
+		turn = 1;
+		cond_signal(&cnd);
+		while (turn == 1)
+			cond_wait(&cnd, &mtx);
+	}
+	mutex_unlock(&mtx);
+}
+
+static void
+bench_sync(void)
+{
+
+	mutex_init(&mtx);
+	run_time("mutex", 0, do_mutex_uncontended, 0, MAXITER);
+	thread_run(mutex_thread);
+	run_time("mutex_pingpong", 0, do_mutex, 0, MAXITER);
+	thread_terminate(helper);
+	mutex_destroy(&mtx);
+
+	sem_init(&sem[0], 0);
+	sem_init(&sem[1], 0);
+	thread_run(sem_thread);
+	run_time("sem_pingpong", 0, do_sem, 0, MAXITER);
+	thread_terminate(helper);
+	sem_destroy(&sem[0]);
+	sem_destroy(&sem[1]);
+
+	mutex_init(&mtx);
+	cond_init(&cnd);
+	turn = 0;
+	thread_run(cond_thread);
+	run_time("cond_pingpong", 0, do_cond, 0, MAXITER);
+	thread_terminate(helper);
+	cond_destroy(&cnd);
+	mutex_destroy(&mtx);
+}
+
+/*
+ * Virtual memory allocation
+ */
+static void
+do_vm(u_long n, int size)
+{
+	void *addr;
+
+	while (n-- > 0) {
+		if (vm_allocate(task_self(), &addr, size, 1) != 0)
+			fail("vm_allocate");
+		vm_free(task_self(), addr);
+	}
+}
+
+static void
+bench_vm(void)
+{
+	static const int sizes[] = { 4096, 65536, 1024 * 1024 };
+	u_int i;
+
+	for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+		run_time("vm_allocate", sizes[i], do_vm, sizes[i], MAXITER);
+}
+
+/*
+ * Process creation
+ */
+static void
+do_fork(u_long n, int arg)
+{
+	pid_t pid;
+
+	while (n-- > 0) {
+		if ((pid = vfork()) == -1)
+			fail("vfork");
+		if (pid == 0)
+			_exit(0);
+		waitpid(pid, NULL, 0);
+	}
+}
+
+static void
+do_exec(u_long n, int arg)
+{
+	pid_t pid;
+
+	while (n-- > 0) {
+		if ((pid = vfork()) == -1)
+			fail("vfork");
+		if (pid == 0) {
+			execl(execpath, execpath, "-x", NULL);
+			_exit(1);
+		}
+		waitpid(pid, NULL, 0);
+	}
+}
+
+static void
+bench_proc(void)
+{
+
+	run_time("vfork_exit", 0, do_fork, 0, MAXITER);
+	run_time("vfork_exec", 0, do_exec, 0, MAXITER);
+}
+
+/*
+ * Pipe latency and bandwidth with a child process
+ *
+ * The child gets the pipe ends fd1 and fd2. It must close the
+ * ends kept by the parent (cfd1 and cfd2) before exec, or the
+ * pipe never reaches EOF and the child never exits.
+ */
+static pid_t
+spawn(const char *mode, int fd1, int fd2, int cfd1, int cfd2)
+{
+	char arg1[16], arg2[16];
+	pid_t pid;
+
+	snprintf(arg1, sizeof(arg1), "%d", fd1);
+	snprintf(arg2, sizeof(arg2), "%d", fd2);
+	if ((pid = vfork()) == -1)
+		fail("vfork");
+	if (pid == 0) {
+		close(cfd1);
+		if (cfd2 >= 0)
+			close(cfd2);
+		execl(execpath, execpath, mode, arg1,
+		      fd2 >= 0 ? arg2 : NULL, NULL);
+		_exit(1);
+	}
+	return pid;
+}
+
+static int pipe_out, pipe_in;
+
+static void
+do_pipe_lat(u_long n, int arg)
+{
+	char c = 0;
+
+	while (n-- > 0) {
+		if (write(pipe_out, &c, 1) != 1 || read(pipe_in, &c, 1) != 1)
+			fail("pipe");
+	}
+}
+
+static void
+bench_pipe(void)
+{
+	int p1[2], p2[2];
+	u_long n, bytes, usec;
+	pid_t pid;
+	int size;
+
+	if (pipe(p1) == -1 || pipe(p2) == -1)
+		fail("pipe");
+	pid = spawn("-E", p1[0], p2[1], p1[1], p2[0]);
+	close(p1[0]);
+	close(p2[1]);
+	pipe_out = p1[1];
+	pipe_in = p2[0];
+	usec = measure(do_pipe_lat, 0, MAXITER, &n);
+	close(pipe_out);
+	close(pipe_in);
+	waitpid(pid, NULL, 0);
+	report_time("pipe_lat", 1, usec, n);
+
+	/*
+	 * The bandwidth is measured until the reader has
+	 * drained the pipe and exited.
+	 */
+	for (size = 512; size <= BUFSZ; size *= 8) {
+		if (pipe(p1) == -1)
+			fail("pipe");
+		bytes = 0;
+		pid = spawn("-R", p1[0], -1, p1[1], -1);
+		close(p1[0]);
+		bench_start();
+		do {
+			if (write(p1[1], iobuf, size) != size)
+				fail("pipe");
+			bytes += size;
+		} while (bench_stop() < mintime);
+		close(p1[1]);
+		waitpid(pid, NULL, 0);
+		usec = bench_stop();
+		report_bw("pipe_bw", size, bytes, usec);
+	}
+}
+
+/*
+ * File system
+ */
+static void
+do_create(u_long n, int dir)
+{
+	int fd;
+
+	snprintf(path, sizeof(path), "%s/mb%d", dirs[dir], getpid());
+	while (n-- > 0) {
+		if ((fd = creat(path, 0644)) == -1)
+			fail("creat");
+		close(fd);
+		if (unlink(path) == -1)
+			fail("unlink");
+	}
+}
+
+static int	filefd;
+static u_long	rndseed;
+
+static off_t
+next_block(int random)
+{
+	static off_t off;
+
+	if (random) {
+		rndseed = rndseed * 1103515245 + 12345;
+		return ((rndseed >> 8) % (FILESZ / BLKSZ)) * BLKSZ;
+	}
+	off += BLKSZ;
+	if (off >= FILESZ)
+		off = 0;
+	return off;
+}
+
+static void
+do_fileread(u_long n, int random)
+{
+
+	while (n-- > 0) {
+		lseek(filefd, next_block(random), SEEK_SET);
+		if (read(filefd, iobuf, BLKSZ) != BLKSZ)
+			fail("read");
+	}
+}
+
+static void
+do_filewrite(u_long n, int random)
+{
+
+	while (n-- > 0) {
+		lseek(filefd, next_block(random), SEEK_SET);
+		if (write(filefd, iobuf, BLKSZ) != BLKSZ)
+			fail("write");
+	}
+}
+
+static void
+file_bw(const char *name, void (*func)(u_long, int), int random)
+{
+	u_long n, usec;
+
+	usec = measure(func, random, MAXITER, &n);
+	report_bw(name, BLKSZ, n * BLKSZ, usec);
+}
+
+static void
+bench_fs(void)
+{
+	struct stat st;
+	int i;
+
+	rndseed = 1;
+	for (i = 0; i < ndirs; i++) {
+		if (stat(dirs[i], &st) == -1 || !S_ISDIR(st.st_mode)) {
+			printf("# skip %s\n", dirs[i]);
+			continue;
+		}
+		printf("# directory %s\n", dirs[i]);
+		run_time("fs_create_delete", 0, do_create, i, MAXITER);
+
+		snprintf(path, sizeof(path), "%s/mb%d", dirs[i], getpid());
+		if ((filefd = open(path, O_CREAT|O_RDWR, 0644)) == -1)
+			fail("open");
+		do_filewrite(FILESZ / BLKSZ, 0);
+		fsync(filefd);
+
+		file_bw("fs_seq_read", do_fileread, 0);
+		file_bw("fs_seq_write", do_filewrite, 0);
+		file_bw("fs_rand_read", do_fileread, 1);
+		file_bw("fs_rand_write", do_filewrite, 1);
+		close(filefd);
+		unlink(path);
+	}
+}
+
+/*
+ * Timer accuracy
+ */
+static void
+do_sleep(u_long n, int msec)
+{
+
+	while (n-- > 0)
+		timer_sleep(msec, 0);
+}
+
+static void
+bench_timer(void)
+{
+	static const int msecs[] = { 1, 10, 100 };
+	u_int i;
+
+	for (i = 0; i < sizeof(msecs) / sizeof(msecs[0]); i++)
+		run_time("timer_sleep", msecs[i], do_sleep, msecs[i], MAXITER);
+}
+
+static const struct bench benchtab[] = {
+	{ "syscall",	bench_syscall },
+	{ "ctxsw",	bench_ctxsw },
+	{ "ipc",	bench_ipc },
+	{ "sync",	bench_sync },
+	{ "vm",		bench_vm },
+	{ "proc",	bench_proc },
+	{ "pipe",	bench_pipe },
+	{ "fs",		bench_fs },
+	{ "timer",	bench_timer },
+	{ NULL,		NULL },
+};
+
+/*
+ * Child of the pipe latency test: echo every byte back.
+ */
+static void
+child_echo(int in, int out)
+{
+	char c;
+
+	while (read(in, &c, 1) == 1)
+		write(out, &c, 1);
+	_exit(0);
+}
+
+/*
+ * Child of the pipe bandwidth test: drain the pipe.
+ */
+static void
+child_read(int in)
+{
+
+	while (read(in, iobuf, sizeof(iobuf)) > 0)
+		;
+	_exit(0);
+}
+
+static void
+usage(void)
+{
+
+	fputs("usage: microbench [-t msec] [-e path] [-d dir]... "
+	      "[benchmark ...]\n", stderr);
+	exit(1);
+}
+
+int
+main(int argc, char *argv[])
+{
+	const struct bench *b;
+	struct timerinfo info;
+	struct utsname un;
+	int ch, i;
+
+	mintime = 1000000;
+	while ((ch = getopt(argc, argv, "t:e:d:xE:R:")) != -1) {
+		switch (ch) {
+		case 't':
+			mintime = strtoul(optarg, NULL, 0) * 1000;
+			break;
+		case 'e':
+			execpath = optarg;
+			break;
+		case 'd':
+			if (ndirs < MAXDIRS)
+				dirs[ndirs++] = optarg;
+			break;
+		case 'x':
+			_exit(0);
+		case 'E':
+			if (optind >= argc)
+				usage();
+			child_echo(atoi(optarg), atoi(argv[optind]));
+			break;
+		case 'R':
+			child_read(atoi(optarg));
+			break;
+		default:
+			usage();
+		}
+	}
+	argc -= optind;
+	argv += optind;
+
+	if (ndirs == 0) {
+		dirs[ndirs++] = "/tmp";
+		dirs[ndirs++] = "/mnt/floppy";
+	}
+	sys_info(INFO_TIMER, &info);
+	if ((hz = info.hz) == 0)
+		fail("sys_info");
+	mkdir("/tmp", 0777);
+
+	uname(&un);
+	printf("# microbench %s %s %s\n", un.sysname, un.release,
+	       un.machine);
+	printf("# hz %lu mintime %lu\n", hz, mintime / 1000);
+	printf("# benchmark size value unit\n");
+
+	for (b = benchtab; b->name != NULL; b++) {
+		if (argc > 0) {
+			for (i = 0; i < argc; i++) {
+				if (!strcmp(argv[i], b->name))
+					break;
+			}
+			if (i == argc)
+				continue;
+		}
+		b->func();
+	}
+	printf("# done\n");
+	return 0;
+}
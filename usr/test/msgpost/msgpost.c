@@ -0,0 +1,147 @@
+/*-
+ * Copyright (c) 2009, Kohsuke Ohtani
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the author nor the names of any co-contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * msgpost.c - test program for asynchronous messages.
+ */
+
+#include <sys/prex.h>
+#include <ipc/ipc.h>
+#include <stdio.h>
+#include <errno.h>
+
+#define NR_POSTS	100
+
+static char stack[1024];
+static object_t obj[2];
+
+static int
+thread_run(void (*start)(void), void *stack)
+{
+	thread_t t;
+	int error;
+
+	error = thread_create(task_self(), &t);
+	if (error)
+		return error;
+
+	error = thread_load(t, start, stack);
+	if (error)
+		return error;
+
+	error = thread_resume(t);
+	if (error)
+		return error;
+
+	return 0;
+}
+
+/*
+ * Post messages to the both objects by turns.
+ */
+static void
+post_thread(void)
+{
+	struct msg msg;
+	int i, error;
+
+	for (i = 0; i < NR_POSTS; i++) {
+		msg.hdr.code = i;
+		do {
+			error = msg_post(obj[i & 1], &msg, sizeof(msg));
+			if (error == EAGAIN)
+				thread_yield();
+		} while (error == EAGAIN);
+		if (error)
+			panic("msg_post failed");
+	}
+	thread_terminate(thread_self());
+}
+
+int
+main(int argc, char *argv[])
+{
+	char buf[MSG_POSTSIZE];
+	struct msg msg;
+	struct msg_header *hdr = (struct msg_header *)buf;
+	int i, error, count[2];
+
+	printf("Asynchronous message test\n");
+
+	if (object_create(NULL, &obj[0]) || object_create(NULL, &obj[1]))
+		panic("failed to create object");
+
+	/*
+	 * Nothing is posted yet.
+	 */
+	error = msg_wait(obj, 2, buf, MSG_NOWAIT);
+	if (error != EAGAIN)
+		panic("Oops! got a message from an empty queue");
+	error = msg_wait(obj, 2, buf, 100);
+	if (error != ETIMEDOUT)
+		panic("Oops! msg_wait did not time out");
+
+	/*
+	 * Fill the queue.  The sender must not block.
+	 */
+	msg.hdr.code = 0;
+	for (i = 0; i < MAXPOSTQ; i++) {
+		if (msg_post(obj[0], &msg, sizeof(msg)))
+			panic("msg_post failed");
+	}
+	if (msg_post(obj[0], &msg, sizeof(msg)) != EAGAIN)
+		panic("Oops! queue overflow");
+	for (i = 0; i < MAXPOSTQ; i++) {
+		if (msg_wait(obj, 2, buf, MSG_NOWAIT))
+			panic("msg_wait failed");
+		if (hdr->task != task_self() || hdr->status != 0)
+			panic("Oops! wrong header");
+	}
+
+	/*
+	 * Receive messages from the sender thread.
+	 */
+	if (thread_run(post_thread, stack + 1024))
+		panic("failed to run thread");
+
+	count[0] = count[1] = 0;
+	for (i = 0; i < NR_POSTS; i++) {
+		error = msg_wait(obj, 2, buf, 0);
+		if (error)
+			panic("msg_wait failed");
+		if ((hdr->code & 1) != hdr->status)
+			panic("Oops! message from wrong object");
+		count[hdr->status]++;
+	}
+	printf("object A: %d messages, object B: %d messages\n",
+	       count[0], count[1]);
+
+	printf("Test completed.\n");
+	return 0;
+}
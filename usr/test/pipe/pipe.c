@@ -94,10 +94,60 @@ test2(void)
 	}
 }
 
+static void
+test3(void)
+{
+	int fd[2];
+	int i, size;
+	static char buf[12 * 1024];
+
+	printf("pipe size test\n");
+
+	if (pipe(fd) == -1) {
+		perror("pipe");
+		exit(1);
+	}
+	printf("default size=%d\n", fcntl(fd[0], F_GETPIPE_SZ));
+
+	if (fcntl(fd[1], F_SETPIPE_SZ, 16 * 1024) == -1) {
+		perror("fcntl");
+		exit(1);
+	}
+	size = fcntl(fd[0], F_GETPIPE_SZ);
+	printf("new size=%d\n", size);
+	if (size < (int)sizeof(buf)) {
+		printf("pipe is too small\n");
+		exit(1);
+	}
+
+	/* The whole data must fit in the pipe without blocking. */
+	for (i = 0; i < (int)sizeof(buf); i++)
+		buf[i] = (char)i;
+	if (write(fd[1], buf, sizeof(buf)) != sizeof(buf)) {
+		perror("write");
+		exit(1);
+	}
+	memset(buf, 0, sizeof(buf));
+	if (read(fd[0], buf, sizeof(buf)) != sizeof(buf)) {
+		perror("read");
+		exit(1);
+	}
+	for (i = 0; i < (int)sizeof(buf); i++) {
+		if (buf[i] != (char)i) {
+			printf("data mismatch at %d\n", i);
+			exit(1);
+		}
+	}
+	close(fd[0]);
+	close(fd[1]);
+	printf("test3 ok\n");
+}
+
 int
 main(int argc, char *argv[])
 {
 	test1();
+	test3();
 	test2();
 	return 0;
 }
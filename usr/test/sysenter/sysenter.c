@@ -0,0 +1,140 @@
+/*-
+ * Copyright (c) 2009, Kohsuke Ohtani
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ * 3. Neither the name of the author nor the names of any co-contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR AND CONTRIBUTORS ``AS IS'' AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE AUTHOR OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS
+ * OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY
+ * OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+ * SUCH DAMAGE.
+ */
+
+/*
+ * sysenter.c - test system call by sysenter with TF set.
+ */
+
+/*
+ * sysenter does not clear the trap flag. The kernel must take
+ * the debug trap at its entry, and the single step exception
+ * must be delivered to the user after the system call.
+ */
+
+#include <sys/prex.h>
+#include <sys/signal.h>
+#include <stdio.h>
+
+#define SYS_thread_yield	16	/* see syscalls/syscall.h */
+#define REG_EFLAGS		13	/* index of eflags in the frame */
+#define EFL_TF			0x100
+
+static volatile int ntrap;
+static volatile int nexc;
+
+/*
+ * The second argument points the saved user registers.
+ */
+static void
+trap_handler(int code, uint32_t *regs)
+{
+
+	nexc++;
+	if (code == SIGTRAP) {
+		ntrap++;
+		regs[REG_EFLAGS] &= ~EFL_TF;
+	}
+	exception_return();
+}
+
+/*
+ * Check if the cpu supports sysenter. This must be same
+ * with sysenter_init() in the kernel.
+ */
+static int
+has_sysenter(void)
+{
+	uint32_t sig, features, flags;
+
+	__asm__ __volatile__(
+		"pushfl\n\t"
+		"popl %0\n\t"
+		"xorl $0x200000, %0\n\t"
+		"pushl %0\n\t"
+		"popfl\n\t"
+		"pushfl\n\t"
+		"popl %0\n\t"
+		: "=r" (flags));
+	if (!(flags & 0x200000))
+		return 0;
+
+	__asm__ __volatile__("cpuid"
+			     : "=a" (sig), "=d" (features)
+			     : "a" (1)
+			     : "ebx", "ecx");
+	if (!(features & 0x800))
+		return 0;
+	if ((sig & 0xf00) == 0x600 && (sig & 0xf0) < 0x30 &&
+	    (sig & 0xf) < 3)
+		return 0;
+	return 1;
+}
+
+int
+main(int argc, char *argv[])
+{
+	int error;
+
+	printf("sysenter test program\n");
+
+	if (!has_sysenter()) {
+		printf("sysenter is not supported\n");
+		return 0;
+	}
+	exception_setup((void (*)(int))trap_handler);
+
+	/*
+	 * Set TF just before sysenter.
+	 */
+	__asm__ __volatile__(
+		"pushl %%ebp\n\t"
+		"pushl %%edi\n\t"
+		"movl %%esp, %%ebp\n\t"
+		"movl $1f, %%edi\n\t"
+		"pushfl\n\t"
+		"orl %2, (%%esp)\n\t"
+		"popfl\n\t"
+		"sysenter\n"
+		"1:\n\t"
+		"popl %%edi\n\t"
+		"popl %%ebp\n\t"
+		: "=a" (error)
+		: "a" (SYS_thread_yield), "i" (EFL_TF)
+		: "ecx", "edx", "memory", "cc");
+
+	exception_setup(EXC_DFL);
+
+	printf("error=%d trap=%d exception=%d\n", error, ntrap, nexc);
+	if (error != 0 || ntrap != 1 || nexc != 1) {
+		printf("FAIL\n");
+		return 1;
+	}
+	printf("OK\n");
+	return 0;
+}